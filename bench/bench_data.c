@@ -0,0 +1,149 @@
+/*
+ ============================================================================
+ Name        : bench_data.c
+ Author      : Eduardo Ribeiro
+ Description : Synthetic datasets for the benchmarks
+ ============================================================================
+ */
+
+#include "bench_data.h"
+
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/bit.h"
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Returns the next number of the sequence (splitmix64). The same on every
+ * platform, unlike rand()
+ */
+static uint64_t next_random(uint64_t* state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15UL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9UL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBUL;
+
+	return z ^ (z >> 31);
+}
+
+/**
+ * Returns true with a probability of percentage %
+ */
+static bool random_percentage(uint64_t* state, const uint64_t percentage)
+{
+	return next_random(state) % 100 < percentage;
+}
+
+/**
+ * Sets the class bits after the attributes, most significant bit first
+ */
+static void set_class(word_t* line, const uint64_t n_attributes,
+					  const uint8_t n_bits_for_class, const uint64_t class)
+{
+	for (uint8_t b = 0; b < n_bits_for_class; b++)
+	{
+		uint64_t bit = n_attributes + b;
+		word_t mask	 = AND_MASK_TABLE[WORD_BITS - 1 - bit % WORD_BITS];
+
+		if ((class >> (n_bits_for_class - 1 - b)) & 1)
+		{
+			line[bit / WORD_BITS] |= mask;
+		}
+		else
+		{
+			line[bit / WORD_BITS] &= ~mask;
+		}
+	}
+}
+
+void init_bench_params(bench_params_t* params)
+{
+	params->n_classes	   = 2;
+	params->n_attributes   = 1000;
+	params->n_observations = 1000;
+	params->duplicates	   = 10;
+	params->inconsistent   = 50;
+	params->skew		   = 0;
+	params->density		   = 33;
+	params->seed		   = 1;
+}
+
+oknok_t check_bench_params(const bench_params_t* params)
+{
+	if (params->n_classes < 2 || params->n_attributes < 1
+		|| params->n_observations < 2 || params->duplicates > 100
+		|| params->inconsistent > 100 || params->skew > 100
+		|| params->density > 100)
+	{
+		return NOK;
+	}
+
+	return OK;
+}
+
+uint64_t get_bench_n_words(const bench_params_t* params)
+{
+	uint64_t total_bits
+		= params->n_attributes + (uint64_t) ceil(log2(params->n_classes));
+
+	return total_bits / WORD_BITS + (total_bits % WORD_BITS != 0);
+}
+
+word_t* generate_bench_data(const bench_params_t* params)
+{
+	uint64_t n_words		 = get_bench_n_words(params);
+	uint8_t n_bits_for_class = (uint8_t) ceil(log2(params->n_classes));
+
+	word_t* data = (word_t*) calloc(params->n_observations * n_words,
+									sizeof(word_t));
+	if (data == NULL)
+	{
+		return NULL;
+	}
+
+	uint64_t state = params->seed;
+
+	for (uint64_t o = 0; o < params->n_observations; o++)
+	{
+		word_t* line = data + o * n_words;
+
+		if (o > 0 && random_percentage(&state, params->duplicates))
+		{
+			// Repeat a previous observation, maybe with another class
+			uint64_t source = next_random(&state) % o;
+			memcpy(line, data + source * n_words, n_words * sizeof(word_t));
+
+			if (random_percentage(&state, params->inconsistent))
+			{
+				set_class(line, params->n_attributes, n_bits_for_class,
+						  next_random(&state) % params->n_classes);
+			}
+
+			continue;
+		}
+
+		for (uint64_t a = 0; a < params->n_attributes; a++)
+		{
+			if (random_percentage(&state, params->density))
+			{
+				line[a / WORD_BITS] |= AND_MASK_TABLE[WORD_BITS - 1
+													  - a % WORD_BITS];
+			}
+		}
+
+		uint64_t class = random_percentage(&state, params->skew)
+			? 0
+			: next_random(&state) % params->n_classes;
+
+		set_class(line, params->n_attributes, n_bits_for_class, class);
+	}
+
+	return data;
+}
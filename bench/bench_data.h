@@ -0,0 +1,74 @@
+/*
+ ============================================================================
+ Name        : bench_data.h
+ Author      : Eduardo Ribeiro
+ Description : Synthetic datasets for the benchmarks
+ ============================================================================
+ */
+
+#ifndef BENCH_DATA_H
+#define BENCH_DATA_H
+
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include <stdint.h>
+
+/**
+ * Parameters of a synthetic dataset
+ */
+typedef struct bench_params_t
+{
+	uint64_t n_classes;
+	uint64_t n_attributes;
+	uint64_t n_observations;
+
+	/**
+	 * Percentage of observations that repeat a previous observation
+	 */
+	uint64_t duplicates;
+
+	/**
+	 * Percentage of the repeated observations that get another class
+	 */
+	uint64_t inconsistent;
+
+	/**
+	 * Percentage of observations that are always in class 0. The others
+	 * get a class at random
+	 */
+	uint64_t skew;
+
+	/**
+	 * Percentage of attribute bits set
+	 */
+	uint64_t density;
+
+	/**
+	 * The same seed always generates the same dataset
+	 */
+	uint64_t seed;
+} bench_params_t;
+
+/**
+ * Sets the default parameters
+ */
+void init_bench_params(bench_params_t* params);
+
+/**
+ * Checks if the parameters describe a valid dataset
+ */
+oknok_t check_bench_params(const bench_params_t* params);
+
+/**
+ * Returns the number of words in a line, with the class bits
+ */
+uint64_t get_bench_n_words(const bench_params_t* params);
+
+/**
+ * Generates the lines of the dataset, in the same format as the HDF5
+ * datasets. The lines must be freed by the caller
+ */
+word_t* generate_bench_data(const bench_params_t* params);
+
+#endif // BENCH_DATA_H
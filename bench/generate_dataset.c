@@ -0,0 +1,241 @@
+/*
+ ============================================================================
+ Name        : generate_dataset.c
+ Author      : Eduardo Ribeiro
+ Description : Generates synthetic HDF5 datasets for the benchmarks
+ ============================================================================
+ */
+
+#include "bench_data.h"
+
+#include "dataset_hdf5.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/cargs.h"
+
+#include "hdf5.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/**
+ * Writes the lines to a new file, with the attributes read by
+ * hdf5_read_dataset_attributes
+ */
+static oknok_t write_dataset(const char* filename, const char* datasetname,
+							 const bench_params_t* params, const word_t* data)
+{
+	hid_t file_id = H5Fcreate(filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	if (file_id < 1)
+	{
+		fprintf(stderr, "Error creating file %s\n", filename);
+		return NOK;
+	}
+
+	hsize_t dimensions[2]
+		= { params->n_observations, get_bench_n_words(params) };
+
+	hid_t space_id = H5Screate_simple(2, dimensions, NULL);
+	hid_t dataset_id
+		= H5Dcreate(file_id, datasetname, H5T_STD_U64LE, space_id,
+					H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	H5Sclose(space_id);
+
+	if (dataset_id < 1)
+	{
+		fprintf(stderr, "Error creating dataset %s\n", datasetname);
+		H5Fclose(file_id);
+		return NOK;
+	}
+
+	oknok_t status = OK;
+
+	if (H5Dwrite(dataset_id, H5T_NATIVE_UINT64, H5S_ALL, H5S_ALL,
+				 H5P_DEFAULT, data)
+		< 0)
+	{
+		fprintf(stderr, "Error writing the dataset data\n");
+		status = NOK;
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id, N_CLASSES_ATTR,
+									  H5T_NATIVE_UINT64, 1, &params->n_classes);
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id, N_ATTRIBUTES_ATTR,
+									  H5T_NATIVE_UINT64, 1,
+									  &params->n_attributes);
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id, N_OBSERVATIONS_ATTR,
+									  H5T_NATIVE_UINT64, 1,
+									  &params->n_observations);
+	}
+
+	H5Dclose(dataset_id);
+	H5Fclose(file_id);
+
+	return status;
+}
+
+int main(int argc, char** argv)
+{
+	const char* filename	= NULL;
+	const char* datasetname = "dados";
+
+	bench_params_t params;
+	init_bench_params(&params);
+
+	cag_option options[]
+		= { { .identifier	  = 'f',
+			  .access_letters = "f",
+			  .access_name	  = NULL,
+			  .value_name	  = "filename",
+			  .description	  = "HDF5 file to create" },
+
+			{ .identifier	  = 'd',
+			  .access_letters = "d",
+			  .access_name	  = NULL,
+			  .value_name	  = "dataset",
+			  .description	  = "Dataset identifier (default: dados)" },
+
+			{ .identifier	  = 'c',
+			  .access_letters = NULL,
+			  .access_name	  = "classes",
+			  .value_name	  = "N",
+			  .description	  = "Number of classes (default: 2)" },
+
+			{ .identifier	  = 'a',
+			  .access_letters = NULL,
+			  .access_name	  = "attributes",
+			  .value_name	  = "N",
+			  .description	  = "Number of attributes (default: 1000)" },
+
+			{ .identifier	  = 'o',
+			  .access_letters = NULL,
+			  .access_name	  = "observations",
+			  .value_name	  = "N",
+			  .description	  = "Number of observations (default: 1000)" },
+
+			{ .identifier	  = 'u',
+			  .access_letters = NULL,
+			  .access_name	  = "duplicates",
+			  .value_name	  = "P",
+			  .description	  = "Percentage of observations that repeat a "
+							"previous one (default: 10)" },
+
+			{ .identifier	  = 'i',
+			  .access_letters = NULL,
+			  .access_name	  = "inconsistent",
+			  .value_name	  = "P",
+			  .description	  = "Percentage of the repeated observations "
+							"with another class (default: 50)" },
+
+			{ .identifier	  = 'k',
+			  .access_letters = NULL,
+			  .access_name	  = "skew",
+			  .value_name	  = "P",
+			  .description	  = "Percentage of observations always in "
+							"class 0, the others are uniform (default: 0)" },
+
+			{ .identifier	  = 'p',
+			  .access_letters = NULL,
+			  .access_name	  = "density",
+			  .value_name	  = "P",
+			  .description	  = "Percentage of attribute bits set "
+							"(default: 33)" },
+
+			{ .identifier	  = 's',
+			  .access_letters = NULL,
+			  .access_name	  = "seed",
+			  .value_name	  = "N",
+			  .description	  = "Random seed (default: 1)" },
+
+			{ .identifier	  = 'h',
+			  .access_letters = "h",
+			  .access_name	  = "help",
+			  .description	  = "Shows the command help" } };
+
+	cag_option_context context;
+	cag_option_prepare(&context, options, CAG_ARRAY_SIZE(options), argc, argv);
+
+	while (cag_option_fetch(&context))
+	{
+		const char* value = cag_option_get_value(&context);
+
+		switch (cag_option_get(&context))
+		{
+			case 'f':
+				filename = value;
+				break;
+			case 'd':
+				datasetname = value;
+				break;
+			case 'c':
+				params.n_classes = strtoull(value, NULL, 10);
+				break;
+			case 'a':
+				params.n_attributes = strtoull(value, NULL, 10);
+				break;
+			case 'o':
+				params.n_observations = strtoull(value, NULL, 10);
+				break;
+			case 'u':
+				params.duplicates = strtoull(value, NULL, 10);
+				break;
+			case 'i':
+				params.inconsistent = strtoull(value, NULL, 10);
+				break;
+			case 'k':
+				params.skew = strtoull(value, NULL, 10);
+				break;
+			case 'p':
+				params.density = strtoull(value, NULL, 10);
+				break;
+			case 's':
+				params.seed = strtoull(value, NULL, 10);
+				break;
+			case 'h':
+				printf("Usage: %s [OPTION]...\n", argv[0]);
+				cag_option_print(options, CAG_ARRAY_SIZE(options), stdout);
+				return EXIT_SUCCESS;
+		}
+	}
+
+	if (filename == NULL || check_bench_params(&params) != OK)
+	{
+		printf("Usage: %s [OPTION]...\n", argv[0]);
+		cag_option_print(options, CAG_ARRAY_SIZE(options), stdout);
+		return EXIT_FAILURE;
+	}
+
+	word_t* data = generate_bench_data(&params);
+	if (data == NULL)
+	{
+		fprintf(stderr, "Error allocating memory for the dataset\n");
+		return EXIT_FAILURE;
+	}
+
+	oknok_t status = write_dataset(filename, datasetname, &params, data);
+
+	free(data);
+
+	if (status != OK)
+	{
+		return EXIT_FAILURE;
+	}
+
+	fprintf(stdout, "Generated '%s' with %lu classes, %lu attributes and %lu "
+					"observations\n",
+			filename, params.n_classes, params.n_attributes,
+			params.n_observations);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,522 @@
+/*
+ ============================================================================
+ Name        : microbench.c
+ Author      : Eduardo Ribeiro
+ Description : Microbenchmarks of the main dataset and set cover functions
+ ============================================================================
+ */
+
+#include "bench_data.h"
+
+#include "dataset.h"
+#include "dataset_omp.h"
+#include "dataset_transposed.h"
+#include "disjoint_matrix.h"
+#include "disjoint_matrix_mpi.h"
+#include "jnsq.h"
+#include "set_cover.h"
+#include "set_cover_omp.h"
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/cargs.h"
+#include "utils/sort_r.h"
+#include "xor_kernels.h"
+
+#include <omp.h>
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Number of class offsets calculated on each repetition
+ */
+#define N_CLASS_OFFSETS 1000000
+
+/**
+ * The dataset sizes used when none is given
+ */
+static const uint64_t DEFAULT_SIZES[][3] = {
+	// classes, attributes, observations
+	{ 2, 1000, 1000 },
+	{ 2, 10000, 500 },
+	{ 5, 1000, 2000 },
+	{ 12, 2000, 1000 },
+};
+
+/**
+ * Everything a benchmark needs
+ */
+typedef struct bench_t
+{
+	bench_params_t params;
+	dataset_t dataset;
+	dm_t dm;
+	dm_threads_t threads;
+	uint64_t* totals;
+	word_t* column;
+
+	/**
+	 * The sorted lines, with the duplicates
+	 */
+	word_t* sorted;
+	uint64_t n_sorted;
+	uint64_t n_sorted_words;
+
+	/**
+	 * The copy of the sorted lines changed by remove_duplicates
+	 */
+	dataset_t work;
+
+	/**
+	 * The dataset with its transposed copy, stored in columns
+	 */
+	dataset_t transposed;
+	word_t* columns;
+} bench_t;
+
+/**
+ * Preprocesses the dataset like laid_by_lines.c and sets up the full
+ * disjoint matrix for a single process
+ */
+static oknok_t setup_bench(bench_t* bench, const uint64_t n_threads)
+{
+	dataset_t* dataset = &bench->dataset;
+	init_dataset(dataset);
+
+	dataset->data = generate_bench_data(&bench->params);
+	if (dataset->data == NULL)
+	{
+		return NOK;
+	}
+
+	dataset->n_classes		  = bench->params.n_classes;
+	dataset->n_attributes	  = bench->params.n_attributes;
+	dataset->n_observations	  = bench->params.n_observations;
+	dataset->n_bits_for_class = (uint8_t) ceil(log2(dataset->n_classes));
+	dataset->n_words		  = get_bench_n_words(&bench->params);
+	dataset->line_stride	  = dataset->n_words;
+
+	sort_r(dataset->data, dataset->n_observations,
+		   dataset->n_words * sizeof(word_t), compare_lines_extra,
+		   &dataset->n_words);
+
+	// Keep the sorted lines for remove_duplicates
+	bench->n_sorted = dataset->n_observations;
+	bench->sorted
+		= (word_t*) malloc(bench->n_sorted * dataset->n_words * sizeof(word_t));
+	if (bench->sorted == NULL)
+	{
+		return NOK;
+	}
+	memcpy(bench->sorted, dataset->data,
+		   bench->n_sorted * dataset->n_words * sizeof(word_t));
+
+	bench->n_sorted_words = dataset->n_words;
+
+	bench->work = *dataset;
+	bench->work.data
+		= (word_t*) malloc(bench->n_sorted * dataset->n_words * sizeof(word_t));
+	if (bench->work.data == NULL)
+	{
+		return NOK;
+	}
+
+	remove_duplicates(dataset);
+
+	dataset->n_observations_per_class
+		= (uint64_t*) calloc(dataset->n_classes, sizeof(uint64_t));
+	dataset->observations_per_class
+		= (word_t**) calloc(dataset->n_classes, sizeof(word_t*));
+	uint32_t* classes
+		= (uint32_t*) malloc(dataset->n_observations * sizeof(uint32_t));
+
+	if (dataset->n_observations_per_class == NULL
+		|| dataset->observations_per_class == NULL || classes == NULL)
+	{
+		free(classes);
+		return NOK;
+	}
+
+	fill_class_arrays(dataset, classes);
+
+	uint64_t max_inconsistency = add_jnsqs(dataset);
+	if (max_inconsistency > 0)
+	{
+		dataset->n_bits_for_jnsqs = ceil(log2(max_inconsistency + 1));
+	}
+
+	oknok_t status = group_by_class(dataset, classes);
+	free(classes);
+
+	if (status != OK)
+	{
+		return NOK;
+	}
+
+	set_observations_per_class(dataset);
+
+	dataset->n_attributes += dataset->n_bits_for_jnsqs;
+	dataset->n_words = dataset->n_attributes / WORD_BITS
+		+ (dataset->n_attributes % WORD_BITS != 0);
+
+	// The full matrix
+	bench->dm.n_matrix_lines = get_dm_n_lines(dataset);
+
+	uint64_t n_matrix_words = bench->dm.n_matrix_lines / WORD_BITS
+		+ (bench->dm.n_matrix_lines % WORD_BITS != 0);
+
+	if (set_dm_words(dataset, 0, n_matrix_words, &bench->dm) != OK
+		|| init_dm_threads(dataset, &bench->dm, n_threads, &bench->threads)
+			!= OK)
+	{
+		return NOK;
+	}
+
+	bench->transposed = *dataset;
+	bench->columns
+		= (word_t*) malloc(get_transposed_size(dataset) * sizeof(word_t));
+	if (bench->columns == NULL
+		|| set_columns_per_class(&bench->transposed, bench->columns) != OK)
+	{
+		return NOK;
+	}
+
+	transpose_dataset(&bench->transposed, n_threads);
+
+	bench->totals = (uint64_t*) calloc(dataset->n_words * WORD_BITS,
+									   sizeof(uint64_t));
+	bench->column = (word_t*) calloc(n_matrix_words, sizeof(word_t));
+
+	if (bench->totals == NULL || bench->column == NULL)
+	{
+		return NOK;
+	}
+
+	return OK;
+}
+
+static void free_bench(bench_t* bench)
+{
+	free_dataset(&bench->dataset);
+	free_dm_threads(&bench->threads);
+
+	free(bench->totals);
+	free(bench->column);
+	free(bench->sorted);
+	free(bench->work.data);
+	free(bench->transposed.columns_per_class);
+	free(bench->columns);
+
+	bench->totals						= NULL;
+	bench->column						= NULL;
+	bench->sorted						= NULL;
+	bench->work.data					= NULL;
+	bench->transposed.columns_per_class = NULL;
+	bench->columns						= NULL;
+}
+
+/**
+ * The functions measured. Each runs once, for repetition r
+ */
+typedef void (*bench_function_t)(bench_t* bench, const uint64_t r);
+
+static void bench_initial_totals(bench_t* bench, const uint64_t r)
+{
+	(void) r;
+	calculate_initial_attribute_totals(&bench->dataset, &bench->dm,
+									   bench->totals);
+}
+
+static void bench_initial_totals_omp(bench_t* bench, const uint64_t r)
+{
+	(void) r;
+	calculate_initial_attribute_totals_omp(&bench->dataset, &bench->threads,
+										   bench->totals);
+}
+
+static void bench_get_column(bench_t* bench, const uint64_t r)
+{
+	// A different attribute on each repetition
+	get_column(&bench->dataset, &bench->dm,
+			   (r * 7919) % bench->dataset.n_attributes, bench->column);
+}
+
+static void bench_get_column_omp(bench_t* bench, const uint64_t r)
+{
+	get_column_omp(&bench->dataset, &bench->threads,
+				   (r * 7919) % bench->dataset.n_attributes, bench->column);
+}
+
+static void bench_get_column_transposed(bench_t* bench, const uint64_t r)
+{
+	get_column(&bench->transposed, &bench->dm,
+			   (r * 7919) % bench->dataset.n_attributes, bench->column);
+}
+
+static void bench_transpose(bench_t* bench, const uint64_t r)
+{
+	(void) r;
+	transpose_dataset(&bench->transposed, bench->threads.n_threads);
+}
+
+static void bench_class_offsets(bench_t* bench, const uint64_t r)
+{
+	class_offsets_t offsets;
+
+	uint64_t step = bench->dm.n_matrix_lines / N_CLASS_OFFSETS + 1;
+
+	for (uint64_t i = 0; i < N_CLASS_OFFSETS; i++)
+	{
+		calculate_class_offsets(&bench->dataset,
+								(i * step + r) % bench->dm.n_matrix_lines,
+								&offsets);
+	}
+}
+
+/**
+ * Restores the sorted lines, with the duplicates
+ */
+static void prepare_remove_duplicates(bench_t* bench, const uint64_t r)
+{
+	(void) r;
+
+	bench->work.n_observations = bench->n_sorted;
+	bench->work.n_words		   = bench->n_sorted_words;
+
+	memcpy(bench->work.data, bench->sorted,
+		   bench->n_sorted * bench->n_sorted_words * sizeof(word_t));
+}
+
+static void bench_remove_duplicates(bench_t* bench, const uint64_t r)
+{
+	(void) r;
+	remove_duplicates(&bench->work);
+}
+
+static void bench_remove_duplicates_omp(bench_t* bench, const uint64_t r)
+{
+	(void) r;
+	remove_duplicates_omp(&bench->work, bench->threads.n_threads);
+}
+
+/**
+ * What is processed by each function, to show the time per item
+ */
+typedef enum bench_unit_t
+{
+	DM_LINES,
+	CALLS,
+	OBSERVATIONS
+} bench_unit_t;
+
+typedef struct bench_case_t
+{
+	const char* name;
+
+	/**
+	 * Runs before each repetition, without being measured. May be NULL
+	 */
+	bench_function_t prepare;
+
+	bench_function_t run;
+	bench_unit_t unit;
+} bench_case_t;
+
+static const bench_case_t CASES[] = {
+	{ "calculate_initial_attribute_totals", NULL, bench_initial_totals,
+	  DM_LINES },
+	{ "calculate_initial_attribute_totals_omp", NULL,
+	  bench_initial_totals_omp, DM_LINES },
+	{ "get_column", NULL, bench_get_column, DM_LINES },
+	{ "get_column_omp", NULL, bench_get_column_omp, DM_LINES },
+	{ "get_column_transposed", NULL, bench_get_column_transposed, DM_LINES },
+	{ "transpose_dataset", NULL, bench_transpose, OBSERVATIONS },
+	{ "calculate_class_offsets", NULL, bench_class_offsets, CALLS },
+	{ "remove_duplicates", prepare_remove_duplicates, bench_remove_duplicates,
+	  OBSERVATIONS },
+	{ "remove_duplicates_omp", prepare_remove_duplicates,
+	  bench_remove_duplicates_omp, OBSERVATIONS },
+};
+
+/**
+ * Runs every case on a dataset and shows the best and average times
+ */
+static oknok_t run_cases(const bench_params_t* params,
+						 const uint64_t n_threads, const uint64_t n_repeats)
+{
+	bench_t bench;
+	memset(&bench, 0, sizeof(bench_t));
+	bench.params = *params;
+
+	if (setup_bench(&bench, n_threads) != OK)
+	{
+		fprintf(stderr, "Error setting up the dataset\n");
+		free_bench(&bench);
+		return NOK;
+	}
+
+	for (uint64_t c = 0; c < CAG_ARRAY_SIZE(CASES); c++)
+	{
+		const bench_case_t* bench_case = &CASES[c];
+
+		double best = 0;
+		double sum	= 0;
+
+		for (uint64_t r = 0; r < n_repeats; r++)
+		{
+			if (bench_case->prepare != NULL)
+			{
+				bench_case->prepare(&bench, r);
+			}
+
+			double start = omp_get_wtime();
+			bench_case->run(&bench, r);
+			double elapsed = omp_get_wtime() - start;
+
+			best = (r == 0 || elapsed < best) ? elapsed : best;
+			sum += elapsed;
+		}
+
+		uint64_t n_items = bench_case->unit == DM_LINES
+			? bench.dm.n_matrix_lines
+			: bench_case->unit == CALLS ? N_CLASS_OFFSETS : bench.n_sorted;
+
+		fprintf(stdout, "%-40s %3lu %7lu %7lu %11lu %10.6f %10.6f %9.3f\n",
+				bench_case->name, params->n_classes, params->n_attributes,
+				params->n_observations, bench.dm.n_matrix_lines, best,
+				sum / n_repeats, best * 1e9 / n_items);
+		fflush(stdout);
+	}
+
+	free_bench(&bench);
+
+	return OK;
+}
+
+int main(int argc, char** argv)
+{
+	bench_params_t params;
+	init_bench_params(&params);
+
+	uint64_t n_repeats = 5;
+	bool custom_size   = false;
+
+	cag_option options[]
+		= { { .identifier	  = 'c',
+			  .access_letters = NULL,
+			  .access_name	  = "classes",
+			  .value_name	  = "N",
+			  .description	  = "Number of classes" },
+
+			{ .identifier	  = 'a',
+			  .access_letters = NULL,
+			  .access_name	  = "attributes",
+			  .value_name	  = "N",
+			  .description	  = "Number of attributes" },
+
+			{ .identifier	  = 'o',
+			  .access_letters = NULL,
+			  .access_name	  = "observations",
+			  .value_name	  = "N",
+			  .description	  = "Number of observations" },
+
+			{ .identifier	  = 'r',
+			  .access_letters = NULL,
+			  .access_name	  = "repeats",
+			  .value_name	  = "N",
+			  .description	  = "Repetitions of each function (default: 5)" },
+
+			{ .identifier	  = 'k',
+			  .access_letters = NULL,
+			  .access_name	  = "kernels",
+			  .value_name	  = "name",
+			  .description	  = "XOR kernels: generic, avx2 or avx512" },
+
+			{ .identifier	  = 'h',
+			  .access_letters = "h",
+			  .access_name	  = "help",
+			  .description	  = "Shows the command help" } };
+
+	const char* kernels = NULL;
+
+	cag_option_context context;
+	cag_option_prepare(&context, options, CAG_ARRAY_SIZE(options), argc, argv);
+
+	while (cag_option_fetch(&context))
+	{
+		const char* value = cag_option_get_value(&context);
+
+		switch (cag_option_get(&context))
+		{
+			case 'c':
+				params.n_classes = strtoull(value, NULL, 10);
+				custom_size		 = true;
+				break;
+			case 'a':
+				params.n_attributes = strtoull(value, NULL, 10);
+				custom_size			= true;
+				break;
+			case 'o':
+				params.n_observations = strtoull(value, NULL, 10);
+				custom_size			  = true;
+				break;
+			case 'r':
+				n_repeats = strtoull(value, NULL, 10);
+				break;
+			case 'k':
+				kernels = value;
+				break;
+			case 'h':
+				printf("Usage: %s [OPTION]...\n", argv[0]);
+				cag_option_print(options, CAG_ARRAY_SIZE(options), stdout);
+				return EXIT_SUCCESS;
+		}
+	}
+
+	if (n_repeats == 0 || check_bench_params(&params) != OK)
+	{
+		printf("Usage: %s [OPTION]...\n", argv[0]);
+		cag_option_print(options, CAG_ARRAY_SIZE(options), stdout);
+		return EXIT_FAILURE;
+	}
+
+	if (select_xor_kernels(kernels) != OK)
+	{
+		return EXIT_FAILURE;
+	}
+
+	// The benchmark is the only process of the node
+	uint64_t n_threads = get_n_threads(1);
+
+	fprintf(stdout, "Using %s XOR kernels, %lu thread(s), best of %lu\n\n",
+			get_xor_kernels()->name, n_threads, n_repeats);
+	fprintf(stdout, "%-40s %3s %7s %7s %11s %10s %10s %9s\n", "function",
+			"nc", "attrs", "obs", "dm lines", "best (s)", "mean (s)",
+			"ns/item");
+
+	if (custom_size)
+	{
+		return run_cases(&params, n_threads, n_repeats) == OK ? EXIT_SUCCESS
+															 : EXIT_FAILURE;
+	}
+
+	for (uint64_t i = 0; i < CAG_ARRAY_SIZE(DEFAULT_SIZES); i++)
+	{
+		params.n_classes	  = DEFAULT_SIZES[i][0];
+		params.n_attributes	  = DEFAULT_SIZES[i][1];
+		params.n_observations = DEFAULT_SIZES[i][2];
+
+		if (run_cases(&params, n_threads, n_repeats) != OK)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -13,6 +13,9 @@
 ##SBATCH --nodes=1
 ##SBATCH --ntasks-per-node=1
 
+## Hybrid MPI+OpenMP: one process per node (or socket) with many threads
+##SBATCH --cpus-per-task=1
+
 DATASET_FILE="bench_dataset.hd5.original"
 DATASET_NAME="dados"
 
@@ -32,6 +35,10 @@ EXE="./bin/laid-by-lines"
 HDF5_DISABLE_VERSION_CHECK=2 # Runs without showing the warning message
 export HDF5_DISABLE_VERSION_CHECK
 
+# One OpenMP thread for each cpu assigned to the task
+OMP_NUM_THREADS=${SLURM_CPUS_PER_TASK:-1}
+export OMP_NUM_THREADS
+
 # Used to guarantee that the environment does not have any other loaded module
 module purge
 
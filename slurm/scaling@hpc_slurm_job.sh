@@ -0,0 +1,109 @@
+#!/bin/bash
+
+##CHANGE THIS!
+
+#SBATCH --job-name="P4-scaling@hpc"
+
+#SBATCH --output=out.%x.%j
+##SBATCH --error=err.%x.%j
+
+##SBATCH --time=0:30:0
+
+#SBATCH --ntasks=8
+##SBATCH --nodes=1
+##SBATCH --ntasks-per-node=8
+
+## Hybrid MPI+OpenMP: one process per node (or socket) with many threads
+##SBATCH --cpus-per-task=1
+
+## Strong scaling: the same dataset with 1, 2, 4, ... processes
+DATASET_FILE="bench_dataset.hd5.original"
+DATASET_NAME="dados"
+
+## Weak scaling: synthetic datasets with more observations for more
+## processes, so each process has about the same disjoint matrix lines
+WEAK_CLASSES=2
+WEAK_ATTRIBUTES=1000
+WEAK_OBSERVATIONS=1000
+WEAK_SEED=1
+
+## Dataset directories
+DATASET_DIR="../datasets"
+INPUT_DATASET_FILE="$DATASET_DIR/$DATASET_FILE"
+WEAK_DATASET_DIR="${TMPDIR:-/tmp}"
+
+## MAYBE CHANGE THIS!
+
+EXE="./bin/laid-by-lines"
+GENERATOR="./bin/generate-dataset"
+
+# Disable warning for mismatched library versions
+# Cirrus.8 has different hdf5 versions on short and hpc partitions
+# even if we load the same module
+# ##Headers are 1.14.0, library is 1.10.5
+#HDF5_DISABLE_VERSION_CHECK=1 # Runs but shows warning message
+HDF5_DISABLE_VERSION_CHECK=2 # Runs without showing the warning message
+export HDF5_DISABLE_VERSION_CHECK
+
+# One OpenMP thread for each cpu assigned to the task
+OMP_NUM_THREADS=${SLURM_CPUS_PER_TASK:-1}
+export OMP_NUM_THREADS
+
+# Used to guarantee that the environment does not have any other loaded module
+module purge
+
+# Load software modules. Please check session software for the details
+module load gcc11/libs/hdf5/1.14.0
+
+# Be sure to request the correct partition to avoid the job to be held in the queue, furthermore
+#	on CIRRUS-B (Minho)  choose for example HPC_4_Days
+#	on CIRRUS-A (Lisbon) choose for example hpc
+#SBATCH --partition=hpc
+
+## DON'T CHANGE THIS!
+
+# Runs the dataset $2 of file $1 with $3 processes and prints the wall time
+run_timed() {
+	local start=$(date +%s.%N)
+	mpiexec -np $3 $EXE -d $2 -f $1 > /dev/null
+	local end=$(date +%s.%N)
+	echo "$end - $start" | bc
+}
+
+# Move to base dir
+cd ..
+
+if [ ! -f "$EXE" ] || [ ! -f "$GENERATOR" ]; then
+	echo "$EXE or $GENERATOR not found! Build them with make release bench-tools"
+	exit 1
+fi
+
+chmod u+x $EXE $GENERATOR
+
+# Lines with the results, as CSV
+echo "scaling,processes,observations,seconds"
+
+NP=1
+while [ $NP -le $SLURM_NTASKS ]; do
+	if [ -f "$INPUT_DATASET_FILE" ]; then
+		SECONDS_TAKEN=$(run_timed $INPUT_DATASET_FILE $DATASET_NAME $NP)
+		echo "strong,$NP,,$SECONDS_TAKEN"
+	fi
+
+	# The disjoint matrix grows with the square of the observations
+	OBSERVATIONS=$(echo "$WEAK_OBSERVATIONS * sqrt($NP)" | bc -l | cut -d. -f1)
+	WEAK_FILE="$WEAK_DATASET_DIR/weak_$SLURM_JOBID.$NP.h5"
+
+	$GENERATOR -f $WEAK_FILE -d $DATASET_NAME --classes=$WEAK_CLASSES \
+		--attributes=$WEAK_ATTRIBUTES --observations=$OBSERVATIONS \
+		--seed=$WEAK_SEED > /dev/null
+
+	SECONDS_TAKEN=$(run_timed $WEAK_FILE $DATASET_NAME $NP)
+	echo "weak,$NP,$OBSERVATIONS,$SECONDS_TAKEN"
+
+	rm -f $WEAK_FILE
+
+	NP=$((NP * 2))
+done
+
+echo "Finished with job ID: $SLURM_JOBID"
@@ -0,0 +1,428 @@
+/*
+ ============================================================================
+ Name        : batch.c
+ Author      : Eduardo Ribeiro
+ Description : Runs a set cover for each dataset of a manifest in one job
+ ============================================================================
+ */
+
+#include "batch.h"
+
+#include "types/attributes_map_t.h"
+#include "types/batch_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/bit.h"
+#include "utils/ranks.h"
+
+#include "mpi.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * The separators of the names on a manifest line
+ */
+#define BATCH_SPACES " \t\r"
+
+/**
+ * Reads the whole file. Returns UINT64_MAX if it can't be read
+ */
+static uint64_t read_manifest_file(const char* filename, char** text)
+{
+	FILE* file = fopen(filename, "rb");
+	if (file == NULL)
+	{
+		return UINT64_MAX;
+	}
+
+	uint64_t size = UINT64_MAX;
+
+	if (fseek(file, 0, SEEK_END) == 0)
+	{
+		long length = ftell(file);
+
+		if (length >= 0 && fseek(file, 0, SEEK_SET) == 0)
+		{
+			*text = (char*) malloc(length + 1);
+
+			if (*text != NULL
+				&& fread(*text, 1, length, file) == (size_t) length)
+			{
+				size = (uint64_t) length;
+			}
+		}
+	}
+
+	fclose(file);
+
+	return size;
+}
+
+/**
+ * Splits the manifest in its file and dataset names
+ */
+static oknok_t parse_manifest(batch_t* batch)
+{
+	// Each line has at most one entry
+	uint64_t n_lines = 1;
+	for (char* c = batch->manifest; *c != '\0'; c++)
+	{
+		n_lines += *c == '\n';
+	}
+
+	batch->filenames	= (char**) malloc(n_lines * sizeof(char*));
+	batch->datasetnames = (char**) malloc(n_lines * sizeof(char*));
+
+	if (batch->filenames == NULL || batch->datasetnames == NULL)
+	{
+		return NOK;
+	}
+
+	char* line = batch->manifest;
+
+	while (line != NULL)
+	{
+		char* end = strchr(line, '\n');
+		if (end != NULL)
+		{
+			*end = '\0';
+		}
+
+		char* filename = line + strspn(line, BATCH_SPACES);
+
+		if (*filename != '\0' && *filename != '#')
+		{
+			char* datasetname = filename + strcspn(filename, BATCH_SPACES);
+
+			if (*datasetname != '\0')
+			{
+				*datasetname = '\0';
+				datasetname++;
+				datasetname += strspn(datasetname, BATCH_SPACES);
+			}
+
+			datasetname[strcspn(datasetname, BATCH_SPACES)] = '\0';
+
+			if (*datasetname == '\0')
+			{
+				return NOK;
+			}
+
+			batch->filenames[batch->n_entries]	  = filename;
+			batch->datasetnames[batch->n_entries] = datasetname;
+			batch->n_entries++;
+		}
+
+		line = end != NULL ? end + 1 : NULL;
+	}
+
+	return OK;
+}
+
+oknok_t read_batch(MPI_Comm comm, const char* filename, batch_t* batch)
+{
+	int rank;
+	MPI_Comm_rank(comm, &rank);
+
+	batch->n_entries	= 0;
+	batch->manifest		= NULL;
+	batch->filenames	= NULL;
+	batch->datasetnames = NULL;
+	batch->results		= NULL;
+	batch->next_window	= MPI_WIN_NULL;
+	batch->next_entry	= NULL;
+
+	uint64_t size = 0;
+
+	if (rank == ROOT_RANK)
+	{
+		size = read_manifest_file(filename, &batch->manifest);
+	}
+
+	MPI_Bcast(&size, 1, MPI_UINT64_T, ROOT_RANK, comm);
+
+	if (size == UINT64_MAX || size > INT32_MAX)
+	{
+		if (rank == ROOT_RANK)
+		{
+			fprintf(stderr, "Error reading the batch manifest '%s'\n",
+					filename);
+		}
+
+		return NOK;
+	}
+
+	if (rank != ROOT_RANK)
+	{
+		batch->manifest = (char*) malloc(size + 1);
+		if (batch->manifest == NULL)
+		{
+			return NOK;
+		}
+	}
+
+	MPI_Bcast(batch->manifest, (int) size, MPI_CHAR, ROOT_RANK, comm);
+	batch->manifest[size] = '\0';
+
+	if (parse_manifest(batch) != OK)
+	{
+		if (rank == ROOT_RANK)
+		{
+			fprintf(stderr, "Each line of the manifest needs a file and a "
+							"dataset name\n");
+		}
+
+		return NOK;
+	}
+
+	batch->results = (char**) calloc(batch->n_entries + 1, sizeof(char*));
+	if (batch->results == NULL)
+	{
+		return NOK;
+	}
+
+	MPI_Win_allocate(rank == ROOT_RANK ? sizeof(uint64_t) : 0,
+					 sizeof(uint64_t), MPI_INFO_NULL, comm, &batch->next_entry,
+					 &batch->next_window);
+
+	if (rank == ROOT_RANK)
+	{
+		*batch->next_entry = 0;
+	}
+
+	// The groups take the entries while the others run
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, batch->next_window);
+
+	MPI_Win_sync(batch->next_window);
+	MPI_Barrier(comm);
+
+	return OK;
+}
+
+int64_t get_next_batch_entry(MPI_Comm group_comm, const batch_t* batch)
+{
+	int group_rank;
+	MPI_Comm_rank(group_comm, &group_rank);
+
+	uint64_t entry = 0;
+
+	if (group_rank == ROOT_RANK)
+	{
+		uint64_t one = 1;
+		MPI_Fetch_and_op(&one, &entry, MPI_UINT64_T, ROOT_RANK, 0, MPI_SUM,
+						 batch->next_window);
+		MPI_Win_flush(ROOT_RANK, batch->next_window);
+	}
+
+	MPI_Bcast(&entry, 1, MPI_UINT64_T, ROOT_RANK, group_comm);
+
+	return entry < batch->n_entries ? (int64_t) entry : -1;
+}
+
+char* get_batch_result(const char* filename, const char* datasetname,
+					   const attributes_map_t* map, const word_t* selected)
+{
+	uint64_t solution_size = 0;
+	for (uint64_t w = 0; w < map->n_words; w++)
+	{
+		solution_size += __builtin_popcountll(selected[w]);
+	}
+
+	// The numbers have at most 20 digits and a separator
+	size_t length = strlen(filename) + strlen(datasetname)
+		+ (solution_size + 2) * 21 + 4;
+
+	char* result = (char*) malloc(length);
+	if (result == NULL)
+	{
+		return NULL;
+	}
+
+	int written = snprintf(result, length, "%s\t%s\t%lu\t%lu\t", filename,
+						   datasetname, map->n_attributes, solution_size);
+
+	const char* separator = "";
+
+	for (uint64_t a = 0; a < map->n_attributes; a++)
+	{
+		if (BIT_CHECK(selected[a / WORD_BITS], WORD_BITS - a % WORD_BITS - 1))
+		{
+			written += snprintf(result + written, length - written, "%s%lu",
+								separator, a);
+			separator = " ";
+		}
+	}
+
+	snprintf(result + written, length - written, "\n");
+
+	return result;
+}
+
+char* get_batch_failure(const char* filename, const char* datasetname)
+{
+	size_t length = strlen(filename) + strlen(datasetname) + 16;
+
+	char* result = (char*) malloc(length);
+	if (result == NULL)
+	{
+		return NULL;
+	}
+
+	snprintf(result, length, "%s\t%s\t-\t-\tfailed\n", filename,
+			 datasetname);
+
+	return result;
+}
+
+oknok_t write_batch_results(MPI_Comm comm, const batch_t* batch,
+							const char* filename)
+{
+	int rank;
+	MPI_Comm_rank(comm, &rank);
+
+	// The rank that has the result of each entry
+	int* owners = (int*) malloc((batch->n_entries + 1) * sizeof(int));
+	if (owners == NULL)
+	{
+		return NOK;
+	}
+
+	uint64_t n_entries = batch->n_entries;
+
+	// The last slot gets the length of the longest result
+	owners[n_entries] = 0;
+
+	for (uint64_t e = 0; e < n_entries; e++)
+	{
+		owners[e] = batch->results[e] != NULL ? rank : -1;
+
+		if (batch->results[e] != NULL
+			&& (int) strlen(batch->results[e]) + 1 > owners[n_entries])
+		{
+			owners[n_entries] = (int) strlen(batch->results[e]) + 1;
+		}
+	}
+
+	MPI_Reduce(rank == ROOT_RANK ? MPI_IN_PLACE : owners, owners,
+			   (int) n_entries + 1, MPI_INT, MPI_MAX, ROOT_RANK, comm);
+
+	oknok_t status = OK;
+
+	/**
+	 * The file and the buffer for the results of the other ranks, that are
+	 * ready before any of them are sent
+	 */
+	FILE* file	 = NULL;
+	char* buffer = NULL;
+
+	if (rank == ROOT_RANK)
+	{
+		file   = fopen(filename, "w");
+		buffer = (char*) malloc(owners[n_entries] + 1);
+
+		if (file == NULL)
+		{
+			fprintf(stderr, "Error opening the batch results file '%s'\n",
+					filename);
+			status = NOK;
+		}
+		else if (buffer == NULL)
+		{
+			fprintf(stderr, "Error allocating memory for the batch results\n");
+			status = NOK;
+		}
+	}
+
+	MPI_Bcast(&status, 1, MPI_INT8_T, ROOT_RANK, comm);
+
+	if (status != OK)
+	{
+		if (file != NULL)
+		{
+			fclose(file);
+		}
+
+		free(buffer);
+		free(owners);
+
+		return NOK;
+	}
+
+	if (rank != ROOT_RANK)
+	{
+		// The messages of a rank arrive in order, like the root takes them
+		for (uint64_t e = 0; e < n_entries; e++)
+		{
+			if (batch->results[e] != NULL)
+			{
+				MPI_Send(batch->results[e], strlen(batch->results[e]) + 1,
+						 MPI_CHAR, ROOT_RANK, 0, comm);
+			}
+		}
+	}
+	else
+	{
+		fprintf(file, "# file\tdataset\tattributes\tselected\tsolution\n");
+
+		for (uint64_t e = 0; e < n_entries; e++)
+		{
+			const char* result = batch->results[e];
+
+			if (owners[e] > ROOT_RANK)
+			{
+				MPI_Recv(buffer, owners[n_entries], MPI_CHAR, owners[e], 0,
+						 comm, MPI_STATUS_IGNORE);
+				result = buffer;
+			}
+
+			if (result != NULL)
+			{
+				fputs(result, file);
+			}
+		}
+
+		if (fclose(file) != 0)
+		{
+			status = NOK;
+		}
+	}
+
+	free(buffer);
+	free(owners);
+
+	MPI_Bcast(&status, 1, MPI_INT8_T, ROOT_RANK, comm);
+
+	return status;
+}
+
+void free_batch(batch_t* batch)
+{
+	if (batch->next_window != MPI_WIN_NULL)
+	{
+		MPI_Win_unlock_all(batch->next_window);
+		MPI_Win_free(&batch->next_window);
+	}
+
+	if (batch->results != NULL)
+	{
+		for (uint64_t e = 0; e < batch->n_entries; e++)
+		{
+			free(batch->results[e]);
+		}
+	}
+
+	free(batch->results);
+	free(batch->filenames);
+	free(batch->datasetnames);
+	free(batch->manifest);
+
+	batch->results		= NULL;
+	batch->filenames	= NULL;
+	batch->datasetnames = NULL;
+	batch->manifest		= NULL;
+	batch->next_entry	= NULL;
+	batch->n_entries	= 0;
+}
@@ -0,0 +1,70 @@
+/*
+ ============================================================================
+ Name        : batch.h
+ Author      : Eduardo Ribeiro
+ Description : Runs a set cover for each dataset of a manifest in one job
+ ============================================================================
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "types/attributes_map_t.h"
+#include "types/batch_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include "mpi.h"
+
+#include <stdint.h>
+
+/**
+ * The manifest has one dataset on each line, the file name and the dataset
+ * name separated by spaces. Empty lines and lines starting with '#' are
+ * skipped.
+ *
+ * The processes are split in groups, and each group takes the next entry
+ * of the manifest when it finishes the last one, so the small datasets
+ * don't keep the whole job waiting. The entry index is kept on the global
+ * root and taken with MPI_Fetch_and_op.
+ *
+ * The results of all groups are written by the global root to one file, in
+ * the manifest order.
+ */
+
+/**
+ * Reads the manifest on the global root of comm and shares it with all the
+ * processes
+ */
+oknok_t read_batch(MPI_Comm comm, const char* filename, batch_t* batch);
+
+/**
+ * Returns the next entry to run by the processes of group_comm, or -1 if
+ * all have been taken
+ */
+int64_t get_next_batch_entry(MPI_Comm group_comm, const batch_t* batch);
+
+/**
+ * Returns the result line of the solution of a dataset
+ */
+char* get_batch_result(const char* filename, const char* datasetname,
+					   const attributes_map_t* map, const word_t* selected);
+
+/**
+ * Returns the result line of a dataset that couldn't be opened
+ */
+char* get_batch_failure(const char* filename, const char* datasetname);
+
+/**
+ * Writes the results of all the groups to filename, on the global root of
+ * comm
+ */
+oknok_t write_batch_results(MPI_Comm comm, const batch_t* batch,
+							const char* filename);
+
+/**
+ * Frees the batch memory
+ */
+void free_batch(batch_t* batch);
+
+#endif // BATCH_H
@@ -23,12 +23,16 @@ void init_dataset(dataset_t* dataset)
 	dataset->data					  = NULL;
 	dataset->n_observations_per_class = NULL;
 	dataset->observations_per_class	  = NULL;
+	dataset->columns_per_class		  = NULL;
 	dataset->n_attributes			  = 0;
 	dataset->n_bits_for_class		  = 0;
 	dataset->n_bits_for_jnsqs		  = 0;
 	dataset->n_classes				  = 0;
 	dataset->n_observations			  = 0;
 	dataset->n_words				  = 0;
+	dataset->line_stride			  = 0;
+	dataset->n_block_observations	  = 0;
+	dataset->n_chunk_observations	  = 0;
 }
 
 uint64_t get_class(const word_t* line, const uint64_t n_attributes,
@@ -160,7 +164,7 @@ uint64_t remove_duplicates(dataset_t* dataset)
 	return (n_obs - n_uniques);
 }
 
-oknok_t fill_class_arrays(dataset_t* dataset)
+oknok_t fill_class_arrays(dataset_t* dataset, uint32_t* classes)
 {
 	// Number of longs in a line
 	uint64_t n_words = dataset->n_words;
@@ -177,9 +181,6 @@ oknok_t fill_class_arrays(dataset_t* dataset)
 	// Array that stores the number of observations for each class
 	uint64_t* n_class_obs = dataset->n_observations_per_class;
 
-	// Matrix that stores the list of observations per class
-	word_t** class_obs = dataset->observations_per_class;
-
 	// Current line
 	word_t* line = dataset->data;
 
@@ -188,7 +189,7 @@ oknok_t fill_class_arrays(dataset_t* dataset)
 	{
 		uint64_t lc = get_class(line, n_attributes, n_words, n_bits_for_class);
 
-		class_obs[lc * n_obs + n_class_obs[lc]] = line;
+		classes[i] = (uint32_t) lc;
 
 		n_class_obs[lc]++;
 
@@ -198,13 +199,200 @@ oknok_t fill_class_arrays(dataset_t* dataset)
 	return OK;
 }
 
+uint64_t get_aligned_line_words(const dataset_t* dataset)
+{
+	uint64_t n_attribute_words = dataset->n_attributes / WORD_BITS
+		+ (dataset->n_attributes % WORD_BITS != 0);
+
+	// One more word for the class
+	return n_attribute_words + 1 > dataset->n_words ? n_attribute_words + 1
+													: dataset->n_words;
+}
+
+oknok_t align_dataset_lines(dataset_t* dataset)
+{
+	uint64_t n_attributes	 = dataset->n_attributes;
+	uint64_t n_words		 = dataset->n_words;
+	uint64_t n_aligned		 = get_aligned_line_words(dataset);
+	uint8_t n_bits_for_class = dataset->n_bits_for_class;
+
+	// How many full words are used for attributes?
+	uint64_t n_full = n_attributes / WORD_BITS;
+
+	// How many attributes remain on last word
+	uint8_t remaining = n_attributes % WORD_BITS;
+
+	uint64_t n_attribute_words = n_full + (remaining != 0);
+
+	// The lines only move forward, so the last one is moved first
+	for (uint64_t i = dataset->n_observations; i-- > 0;)
+	{
+		word_t* line	= dataset->data + i * n_words;
+		word_t* aligned = dataset->data + i * n_aligned;
+
+		uint64_t lc = get_class(line, n_attributes, n_words, n_bits_for_class);
+
+		memmove(aligned, line, n_attribute_words * sizeof(word_t));
+
+		// Clear the class bits after the attributes
+		if (remaining > 0)
+		{
+			aligned[n_full] &= ~(~0UL >> remaining);
+		}
+
+		memset(aligned + n_attribute_words, 0,
+			   (n_aligned - n_attribute_words) * sizeof(word_t));
+
+		aligned[n_aligned - 1] = (word_t) lc << (WORD_BITS - n_bits_for_class);
+	}
+
+	dataset->n_attributes = (n_aligned - 1) * WORD_BITS;
+	dataset->n_words	  = n_aligned;
+	dataset->line_stride  = n_aligned;
+
+	return OK;
+}
+
+oknok_t pack_dataset_lines(dataset_t* dataset, const uint64_t n_attributes,
+						   const uint64_t n_words)
+{
+	uint64_t n_aligned = dataset->line_stride;
+	uint8_t n_bits	   = dataset->n_bits_for_jnsqs;
+
+	uint64_t n_attribute_words
+		= n_attributes / WORD_BITS + (n_attributes % WORD_BITS != 0);
+
+	// Word and bit where the jnsqs start
+	uint64_t at	   = n_attributes / WORD_BITS;
+	uint8_t offset = n_attributes % WORD_BITS;
+
+	// The lines only move back, so the first one is moved first
+	for (uint64_t i = 0; i < dataset->n_observations; i++)
+	{
+		word_t* aligned = dataset->data + i * n_aligned;
+		word_t* line	= dataset->data + i * n_words;
+
+		// The jnsqs are on the top bits, and the other bits are 0
+		word_t jnsqs = aligned[n_aligned - 1];
+
+		memmove(line, aligned, n_attribute_words * sizeof(word_t));
+		memset(line + n_attribute_words, 0,
+			   (n_words - n_attribute_words) * sizeof(word_t));
+
+		if (n_bits == 0)
+		{
+			continue;
+		}
+
+		line[at] |= jnsqs >> offset;
+
+		if (offset + n_bits > WORD_BITS)
+		{
+			line[at + 1] |= jnsqs << (WORD_BITS - offset);
+		}
+	}
+
+	dataset->n_attributes = n_attributes;
+	dataset->n_words	  = n_words;
+	dataset->line_stride  = n_words;
+
+	return OK;
+}
+
+oknok_t group_by_class(dataset_t* dataset, uint32_t* classes)
+{
+	uint64_t n_classes	  = dataset->n_classes;
+	uint64_t line_stride  = dataset->line_stride;
+	uint64_t* n_class_obs = dataset->n_observations_per_class;
+
+	/**
+	 * Next free position of each class
+	 */
+	uint64_t* next = (uint64_t*) calloc(n_classes, sizeof(uint64_t));
+
+	/**
+	 * Temporary line used to swap lines
+	 */
+	word_t* tmp = (word_t*) malloc(line_stride * sizeof(word_t));
+
+	if (next == NULL || tmp == NULL)
+	{
+		free(next);
+		free(tmp);
+		return NOK;
+	}
+
+	for (uint64_t c = 1; c < n_classes; c++)
+	{
+		next[c] = next[c - 1] + n_class_obs[c - 1];
+	}
+
+	/**
+	 * End of the current class block
+	 */
+	uint64_t end = 0;
+
+	// Each swap moves one line to its class block, so there are at most
+	// n_observations swaps
+	for (uint64_t c = 0; c < n_classes; c++)
+	{
+		end += n_class_obs[c];
+
+		while (next[c] < end)
+		{
+			uint64_t i	= next[c];
+			uint32_t lc = classes[i];
+
+			if (lc == c)
+			{
+				next[c]++;
+				continue;
+			}
+
+			// Swap line i with the next free position of its class
+			uint64_t j = next[lc]++;
+
+			word_t* line_i = dataset->data + i * line_stride;
+			word_t* line_j = dataset->data + j * line_stride;
+
+			memcpy(tmp, line_i, line_stride * sizeof(word_t));
+			memcpy(line_i, line_j, line_stride * sizeof(word_t));
+			memcpy(line_j, tmp, line_stride * sizeof(word_t));
+
+			classes[i] = classes[j];
+			classes[j] = lc;
+		}
+	}
+
+	free(next);
+	free(tmp);
+
+	return OK;
+}
+
+oknok_t set_observations_per_class(dataset_t* dataset)
+{
+	word_t* line = dataset->data;
+
+	for (uint64_t c = 0; c < dataset->n_classes; c++)
+	{
+		dataset->observations_per_class[c] = line;
+
+		line += dataset->n_observations_per_class[c] * dataset->line_stride;
+	}
+
+	return OK;
+}
+
 void free_dataset(dataset_t* dataset)
 {
 	free(dataset->data);
 	free(dataset->n_observations_per_class);
 	free(dataset->observations_per_class);
+	free(dataset->columns_per_class);
 
 	dataset->data					  = NULL;
 	dataset->n_observations_per_class = NULL;
 	dataset->observations_per_class	  = NULL;
+	dataset->columns_per_class		  = NULL;
 }
@@ -63,11 +63,57 @@ bool has_same_attributes(const word_t* a, const word_t* b,
 uint64_t remove_duplicates(dataset_t* dataset);
 
 /**
- * Fill the arrays with the number of items per class and also a matrix with
- * references to the lines that belong to each class to simplify the
- * calculation of the disjoint matrix
+ * Fill the array with the number of items per class and stores the class of
+ * each line in classes
  */
-oknok_t fill_class_arrays(dataset_t* dataset);
+oknok_t fill_class_arrays(dataset_t* dataset, uint32_t* classes);
+
+/**
+ * While the class and the jnsqs are set the lines of the original dataset
+ * use an aligned layout: the attributes are padded to full words and the
+ * class is on the top bits of the last word, where the jnsqs replace it.
+ * With n_attributes set to the padded attributes, get_class, set_jnsq_bits
+ * and has_same_attributes never split the class or the jnsqs between two
+ * words or mask the last attribute word.
+ *
+ * The set cover uses the packed layout, with the jnsqs right after the
+ * attributes, which needs less words for each line.
+ */
+
+/**
+ * Returns the number of words of an aligned line of dataset. The dataset
+ * data needs this many words for each line to be aligned
+ */
+uint64_t get_aligned_line_words(const dataset_t* dataset);
+
+/**
+ * Moves the lines of the dataset to the aligned layout. n_attributes,
+ * n_words and line_stride are changed to the aligned ones
+ */
+oknok_t align_dataset_lines(dataset_t* dataset);
+
+/**
+ * Moves the jnsqs of the aligned lines right after the n_attributes
+ * attributes, with n_words words for each line
+ */
+oknok_t pack_dataset_lines(dataset_t* dataset, const uint64_t n_attributes,
+						   const uint64_t n_words);
+
+/**
+ * Moves the lines of the dataset so that the lines of each class are
+ * contiguous, starting with class 0. Uses the classes calculated by
+ * fill_class_arrays, that are moved with the lines.
+ * This must be done after setting the jnsqs, because they need the sorted
+ * dataset
+ */
+oknok_t group_by_class(dataset_t* dataset, uint32_t* classes);
+
+/**
+ * Sets the pointers to the first line of each class, to simplify the
+ * calculation of the disjoint matrix.
+ * The dataset must be grouped by class
+ */
+oknok_t set_observations_per_class(dataset_t* dataset);
 
 /**
  * Frees dataset memory
@@ -8,17 +8,22 @@
 
 #include "dataset_hdf5.h"
 
+#include "dataset_reduce.h"
+#include "types/attributes_map_t.h"
 #include "types/dataset_t.h"
 #include "types/oknok_t.h"
 #include "types/word_t.h"
+#include "utils/block.h"
 
 #include "hdf5.h"
+#include "mpi.h"
 
 #include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 bool hdf5_dataset_exists(const hid_t file_id, const char* datasetname)
 {
@@ -43,6 +48,100 @@ bool hdf5_file_has_dataset(const char* filename, const char* datasetname)
 	return exists;
 }
 
+oknok_t hdf5_get_source_info(hid_t dataset_id, uint64_t* source_info)
+{
+	hsize_t dimensions[2];
+	hdf5_get_dataset_dimensions(dataset_id, dimensions);
+
+	source_info[0] = dimensions[0];
+	source_info[1] = dimensions[1];
+
+	if (hdf5_read_attribute(dataset_id, N_CLASSES_ATTR, H5T_NATIVE_UINT64,
+							&source_info[2])
+			!= OK
+		|| hdf5_read_attribute(dataset_id, N_ATTRIBUTES_ATTR,
+							   H5T_NATIVE_UINT64, &source_info[3])
+			   != OK)
+	{
+		return NOK;
+	}
+
+	return OK;
+}
+
+/**
+ * Checks if the preprocessed dataset preprocessed_id was made from the
+ * dataset source_id as it is now
+ */
+static bool has_same_source(hid_t source_id, hid_t preprocessed_id)
+{
+	uint64_t source_info[N_SOURCE_INFO];
+	uint64_t stored_info[N_SOURCE_INFO];
+
+	// Written before the source info was stored
+	if (H5Aexists(preprocessed_id, SOURCE_INFO_ATTR) <= 0)
+	{
+		return false;
+	}
+
+	if (hdf5_get_source_info(source_id, source_info) != OK
+		|| hdf5_read_attribute(preprocessed_id, SOURCE_INFO_ATTR,
+							   H5T_NATIVE_UINT64, stored_info)
+			   != OK)
+	{
+		return false;
+	}
+
+	return memcmp(source_info, stored_info, sizeof(source_info)) == 0;
+}
+
+bool hdf5_file_has_preprocessed_dataset(const char* filename,
+										const char* datasetname,
+										const char* preprocessed_name)
+{
+	hid_t file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+	if (file_id < 1)
+	{
+		fprintf(stderr, "Error opening file %s\n", filename);
+		return false;
+	}
+
+	if (!hdf5_dataset_exists(file_id, preprocessed_name)
+		|| !hdf5_dataset_exists(file_id, datasetname))
+	{
+		H5Fclose(file_id);
+		return false;
+	}
+
+	hid_t source_id		  = H5Dopen(file_id, datasetname, H5P_DEFAULT);
+	hid_t preprocessed_id = H5Dopen(file_id, preprocessed_name, H5P_DEFAULT);
+
+	bool current = source_id >= 0 && preprocessed_id >= 0
+		&& has_same_source(source_id, preprocessed_id);
+
+	if (!current)
+	{
+		fprintf(stderr,
+				"The preprocessed dataset %s was not made from %s as it is "
+				"now, so it is not used\n",
+				preprocessed_name, datasetname);
+	}
+
+	if (source_id >= 0)
+	{
+		H5Dclose(source_id);
+	}
+
+	if (preprocessed_id >= 0)
+	{
+		H5Dclose(preprocessed_id);
+	}
+
+	H5Fclose(file_id);
+
+	return current;
+}
+
 oknok_t hdf5_open_dataset(const char* filename, const char* datasetname,
 						  dataset_hdf5_t* dataset)
 {
@@ -183,6 +282,373 @@ oknok_t hdf5_read_dataset_data(hid_t dataset_id, word_t* data)
 	return OK;
 }
 
+char* hdf5_preprocessed_dataset_name(const char* datasetname)
+{
+	size_t length = strlen(datasetname) + strlen(PREPROCESSED_SUFFIX) + 1;
+
+	char* name = (char*) malloc(length);
+	if (name != NULL)
+	{
+		snprintf(name, length, "%s%s", datasetname, PREPROCESSED_SUFFIX);
+	}
+
+	return name;
+}
+
+oknok_t hdf5_read_preprocessed_attributes(hid_t dataset_id, dataset_t* dataset,
+										  uint64_t* n_observations_per_class)
+{
+	uint8_t n_bits_for_jnsqs = 0;
+	if (hdf5_read_attribute(dataset_id, N_BITS_FOR_JNSQS_ATTR,
+							H5T_NATIVE_UINT8, &n_bits_for_jnsqs)
+		!= OK)
+	{
+		return NOK;
+	}
+
+	if (hdf5_read_attribute(dataset_id, N_OBSERVATIONS_PER_CLASS_ATTR,
+							H5T_NATIVE_UINT64, n_observations_per_class)
+		!= OK)
+	{
+		return NOK;
+	}
+
+	dataset->n_bits_for_jnsqs = n_bits_for_jnsqs;
+
+	return OK;
+}
+
+oknok_t hdf5_read_attributes_map(hid_t dataset_id, attributes_map_t* map)
+{
+	hid_t attr = H5Aopen(dataset_id, ATTRIBUTES_MAP_ATTR, H5P_DEFAULT);
+	if (attr < 0)
+	{
+		fprintf(stderr, "Error opening the attribute %s\n",
+				ATTRIBUTES_MAP_ATTR);
+		return NOK;
+	}
+
+	// One value for each input attribute
+	hid_t space_id	  = H5Aget_space(attr);
+	hssize_t n_values = H5Sget_simple_extent_npoints(space_id);
+	H5Sclose(space_id);
+	H5Aclose(attr);
+
+	if (n_values < 1 || init_attributes_map((uint64_t) n_values, map) != OK)
+	{
+		return NOK;
+	}
+
+	if (hdf5_read_attribute(dataset_id, ATTRIBUTES_MAP_ATTR, H5T_NATIVE_INT64,
+							map->kept)
+		!= OK)
+	{
+		free_attributes_map(map);
+		return NOK;
+	}
+
+	// The first input attribute of each column is the one kept
+	map->n_kept = 0;
+	for (uint64_t a = 0; a < map->n_attributes; a++)
+	{
+		if (map->kept[a] == (int64_t) map->n_kept)
+		{
+			map->original[map->n_kept] = a;
+			map->n_kept++;
+		}
+	}
+
+	return OK;
+}
+
+oknok_t hdf5_write_attribute(hid_t dataset_id, const char* attribute,
+							 hid_t datatype, const hsize_t n,
+							 const void* value)
+{
+	hid_t space_id = H5Screate_simple(1, &n, NULL);
+
+	hid_t attr
+		= H5Acreate(dataset_id, attribute, datatype, space_id, H5P_DEFAULT,
+					H5P_DEFAULT);
+	H5Sclose(space_id);
+
+	if (attr < 0)
+	{
+		fprintf(stderr, "Error creating the attribute %s\n", attribute);
+		return NOK;
+	}
+
+	herr_t status = H5Awrite(attr, datatype, value);
+	H5Aclose(attr);
+
+	if (status < 0)
+	{
+		fprintf(stderr, "Error writing the attribute %s\n", attribute);
+		return NOK;
+	}
+
+	return OK;
+}
+
+oknok_t hdf5_write_preprocessed_dataset(const char* filename,
+										const char* datasetname,
+										const dataset_t* dataset,
+										const attributes_map_t* map,
+										const uint64_t* source_info)
+{
+	// The attributes map has one value for each input attribute, too many for
+	// the 64KB of attributes in the object header of the earliest format
+	hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+	H5Pset_libver_bounds(fapl_id, H5F_LIBVER_V18, H5F_LIBVER_LATEST);
+
+	hid_t file_id = H5Fopen(filename, H5F_ACC_RDWR, fapl_id);
+	H5Pclose(fapl_id);
+
+	if (file_id < 1)
+	{
+		fprintf(stderr, "Error opening file %s for writing\n", filename);
+		return NOK;
+	}
+
+	// A preprocessed dataset of an older source
+	if (hdf5_dataset_exists(file_id, datasetname))
+	{
+		H5Ldelete(file_id, datasetname, H5P_DEFAULT);
+	}
+
+	// Only the words of the kept attributes of each line
+	hsize_t dimensions[2] = { dataset->n_observations, dataset->n_words };
+
+	hid_t space_id = H5Screate_simple(2, dimensions, NULL);
+
+	// So the attributes are stored outside the object header
+	hid_t dcpl_id = H5Pcreate(H5P_DATASET_CREATE);
+	H5Pset_attr_phase_change(dcpl_id, 0, 0);
+
+	hid_t dataset_id
+		= H5Dcreate(file_id, datasetname, H5T_STD_U64LE, space_id,
+					H5P_DEFAULT, dcpl_id, H5P_DEFAULT);
+	H5Sclose(space_id);
+	H5Pclose(dcpl_id);
+
+	if (dataset_id < 1)
+	{
+		fprintf(stderr, "Error creating dataset %s\n", datasetname);
+		H5Fclose(file_id);
+		return NOK;
+	}
+
+	oknok_t status = OK;
+
+	// The lines in memory keep their stride
+	hsize_t memory_dimensions[2]
+		= { dataset->n_observations, dataset->line_stride };
+	hsize_t offset[2] = { 0, 0 };
+
+	hid_t mem_space_id = H5Screate_simple(2, memory_dimensions, NULL);
+	H5Sselect_hyperslab(mem_space_id, H5S_SELECT_SET, offset, NULL,
+						dimensions, NULL);
+
+	if (H5Dwrite(dataset_id, H5T_NATIVE_UINT64, mem_space_id, H5S_ALL,
+				 H5P_DEFAULT, dataset->data)
+		< 0)
+	{
+		fprintf(stderr, "Error writing the dataset data\n");
+		status = NOK;
+	}
+
+	H5Sclose(mem_space_id);
+
+	// The jnsqs are counted in the attributes
+	uint8_t n_bits_for_jnsqs = 0;
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id, N_CLASSES_ATTR,
+									  H5T_NATIVE_UINT64, 1,
+									  &dataset->n_classes);
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id, N_ATTRIBUTES_ATTR,
+									  H5T_NATIVE_UINT64, 1,
+									  &dataset->n_attributes);
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id, N_OBSERVATIONS_ATTR,
+									  H5T_NATIVE_UINT64, 1,
+									  &dataset->n_observations);
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id, N_BITS_FOR_JNSQS_ATTR,
+									  H5T_NATIVE_UINT8, 1, &n_bits_for_jnsqs);
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id, ATTRIBUTES_MAP_ATTR,
+									  H5T_NATIVE_INT64, map->n_attributes,
+									  map->kept);
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id, SOURCE_INFO_ATTR,
+									  H5T_NATIVE_UINT64, N_SOURCE_INFO,
+									  source_info);
+	}
+
+	// Written last, so a dataset without it is never used
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(
+			dataset_id, N_OBSERVATIONS_PER_CLASS_ATTR, H5T_NATIVE_UINT64,
+			dataset->n_classes, dataset->n_observations_per_class);
+	}
+
+	H5Dclose(dataset_id);
+
+	if (status != OK)
+	{
+		// Don't leave an incomplete dataset in the file
+		H5Ldelete(file_id, datasetname, H5P_DEFAULT);
+	}
+
+	H5Fclose(file_id);
+
+	return status;
+}
+
+oknok_t hdf5_open_dataset_shared(const char* filename, const char* datasetname,
+								 MPI_Comm roots_comm, dataset_hdf5_t* dataset)
+{
+#ifdef H5_HAVE_PARALLEL
+	// Open the data file with MPI-IO
+	hid_t fapl_id = H5Pcreate(H5P_FILE_ACCESS);
+	H5Pset_fapl_mpio(fapl_id, roots_comm, MPI_INFO_NULL);
+
+	hid_t file_id = H5Fopen(filename, H5F_ACC_RDONLY, fapl_id);
+	H5Pclose(fapl_id);
+
+	if (file_id < 1)
+	{
+		// Error creating file
+		fprintf(stderr, "Error opening file %s\n", filename);
+		return NOK;
+	}
+
+	// Open input dataset
+	hid_t dataset_id = H5Dopen(file_id, datasetname, H5P_DEFAULT);
+	if (dataset_id < 1)
+	{
+		// Error opening dataset
+		fprintf(stderr, "Dataset %s not found!\n", datasetname);
+		H5Fclose(file_id);
+		return NOK;
+	}
+
+	dataset->file_id	= file_id;
+	dataset->dataset_id = dataset_id;
+	hdf5_get_dataset_dimensions(dataset_id, dataset->dimensions);
+
+	return OK;
+#else
+	(void) roots_comm;
+
+	// The attributes and dimensions are read by every process
+	return hdf5_open_dataset(filename, datasetname, dataset);
+#endif
+}
+
+oknok_t hdf5_read_dataset_data_shared(hid_t dataset_id, MPI_Comm roots_comm,
+									  const uint64_t n_observations,
+									  const uint64_t n_words, word_t* data)
+{
+	int rank;
+	int size;
+
+	MPI_Comm_rank(roots_comm, &rank);
+	MPI_Comm_size(roots_comm, &size);
+
+	/**
+	 * One line of the dataset
+	 */
+	MPI_Datatype line_type;
+	MPI_Type_contiguous((int) n_words, MPI_UINT64_T, &line_type);
+	MPI_Type_commit(&line_type);
+
+	oknok_t status = OK;
+
+#ifdef H5_HAVE_PARALLEL
+	int* counts = (int*) malloc(size * sizeof(int));
+	int* displs = (int*) malloc(size * sizeof(int));
+
+	if (counts == NULL || displs == NULL)
+	{
+		free(counts);
+		free(displs);
+		MPI_Type_free(&line_type);
+		return NOK;
+	}
+
+	for (int r = 0; r < size; r++)
+	{
+		counts[r] = (int) BLOCK_SIZE(r, size, n_observations);
+		displs[r] = (int) BLOCK_LOW(r, size, n_observations);
+	}
+
+	// Read the block of lines of this process
+	hsize_t offset[2] = { displs[rank], 0 };
+	hsize_t count[2]  = { counts[rank], n_words };
+
+	hid_t file_space_id = H5Dget_space(dataset_id);
+	H5Sselect_hyperslab(file_space_id, H5S_SELECT_SET, offset, NULL, count,
+						NULL);
+
+	hid_t mem_space_id = H5Screate_simple(2, count, NULL);
+
+	hid_t dxpl_id = H5Pcreate(H5P_DATASET_XFER);
+	H5Pset_dxpl_mpio(dxpl_id, H5FD_MPIO_COLLECTIVE);
+
+	herr_t hdf5_status
+		= H5Dread(dataset_id, H5T_NATIVE_UINT64, mem_space_id, file_space_id,
+				  dxpl_id, data + offset[0] * n_words);
+
+	H5Pclose(dxpl_id);
+	H5Sclose(mem_space_id);
+	H5Sclose(file_space_id);
+
+	if (hdf5_status < 0)
+	{
+		fprintf(stderr, "Error reading the dataset data\n");
+		status = NOK;
+	}
+
+	// Every process gets the blocks of the others
+	MPI_Allgatherv(MPI_IN_PLACE, 0, line_type, data, counts, displs,
+				   line_type, roots_comm);
+
+	free(counts);
+	free(displs);
+#else
+	if (rank == 0)
+	{
+		status = hdf5_read_dataset_data(dataset_id, data);
+	}
+
+	MPI_Bcast(data, (int) n_observations, line_type, 0, roots_comm);
+#endif
+
+	MPI_Type_free(&line_type);
+
+	return status;
+}
+
 void hdf5_get_dataset_dimensions(hid_t dataset_id, hsize_t* dataset_dimensions)
 {
 	// Get filespace handle first.
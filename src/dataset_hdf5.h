@@ -9,11 +9,13 @@
 #ifndef HDF5_DATASET_H
 #define HDF5_DATASET_H
 
+#include "types/attributes_map_t.h"
 #include "types/dataset_hdf5_t.h"
 #include "types/dataset_t.h"
 #include "types/oknok_t.h"
 
 #include "hdf5.h"
+#include "mpi.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -33,6 +35,41 @@
  */
 #define N_OBSERVATIONS_ATTR "n_observations"
 
+/**
+ * Attribute for number of jnsq bits of a preprocessed dataset
+ */
+#define N_BITS_FOR_JNSQS_ATTR "n_bits_for_jnsqs"
+
+/**
+ * Attribute for number of observations of each class of a preprocessed
+ * dataset
+ */
+#define N_OBSERVATIONS_PER_CLASS_ATTR "n_observations_per_class"
+
+/**
+ * Attribute of a preprocessed dataset with the dimensions, the number of
+ * classes and the number of attributes of the dataset it was made from
+ */
+#define SOURCE_INFO_ATTR "source_info"
+
+/**
+ * Number of values of the SOURCE_INFO_ATTR attribute
+ */
+#define N_SOURCE_INFO 4
+
+/**
+ * Attribute of a preprocessed dataset with the kept attribute of each input
+ * attribute (see attributes_map_t), as the redundant attributes were
+ * removed before it was written
+ */
+#define ATTRIBUTES_MAP_ATTR "attributes_map"
+
+/**
+ * The preprocessed dataset is stored next to the original one, with this
+ * suffix added to its name
+ */
+#define PREPROCESSED_SUFFIX "_preprocessed"
+
 /**
  * Checks if dataset is present in file_id
  */
@@ -43,6 +80,21 @@ bool hdf5_dataset_exists(const hid_t file_id, const char* dataset);
  */
 bool hdf5_file_has_dataset(const char* filename, const char* datasetname);
 
+/**
+ * Checks if the file has the preprocessed dataset preprocessed_name, made
+ * from datasetname as it is now: the source info stored with it must match
+ * the dimensions and the attributes of datasetname
+ */
+bool hdf5_file_has_preprocessed_dataset(const char* filename,
+										const char* datasetname,
+										const char* preprocessed_name);
+
+/**
+ * Gets the N_SOURCE_INFO values stored with a preprocessed dataset made from
+ * the dataset dataset_id
+ */
+oknok_t hdf5_get_source_info(hid_t dataset_id, uint64_t* source_info);
+
 /**
  * Opens the file and dataset indicated
  */
@@ -60,11 +112,70 @@ oknok_t hdf5_read_dataset_attributes(hid_t dataset_id, dataset_t* dataset);
 oknok_t hdf5_read_attribute(hid_t dataset_id, const char* attribute,
 							hid_t datatype, void* value);
 
+/**
+ * Writes one attribute with n values to the dataset
+ */
+oknok_t hdf5_write_attribute(hid_t dataset_id, const char* attribute,
+							 hid_t datatype, const hsize_t n,
+							 const void* value);
+
 /**
  * Reads the entire dataset data from the hdf5 file
  */
 oknok_t hdf5_read_dataset_data(hid_t dataset_id, word_t* data);
 
+/**
+ * Returns the name of the preprocessed version of datasetname.
+ * The name must be freed by the caller
+ */
+char* hdf5_preprocessed_dataset_name(const char* datasetname);
+
+/**
+ * Reads the attributes that are only stored in a preprocessed dataset:
+ * the number of jnsq bits and the number of observations of each class
+ */
+oknok_t hdf5_read_preprocessed_attributes(hid_t dataset_id, dataset_t* dataset,
+										  uint64_t* n_observations_per_class);
+
+/**
+ * Reads the attributes map of a preprocessed dataset to map, that is
+ * allocated
+ */
+oknok_t hdf5_read_attributes_map(hid_t dataset_id, attributes_map_t* map);
+
+/**
+ * Writes the dataset, after sorting, removing the duplicates, setting the
+ * jnsqs, grouping the lines by class and removing the redundant attributes
+ * of map, to a new dataset of the file.
+ * The jnsqs are attributes like the others by then, and only the words of
+ * the kept attributes of each line are written.
+ * The attributes needed to use it without any preprocessing are written
+ * with it, and the source_info of the dataset it was made from.
+ * A preprocessed dataset already in the file is replaced
+ */
+oknok_t hdf5_write_preprocessed_dataset(const char* filename,
+										const char* datasetname,
+										const dataset_t* dataset,
+										const attributes_map_t* map,
+										const uint64_t* source_info);
+
+/**
+ * Opens the file and dataset indicated on every process of roots_comm (one
+ * process per node). With parallel HDF5 the file is opened with MPI-IO
+ */
+oknok_t hdf5_open_dataset_shared(const char* filename, const char* datasetname,
+								 MPI_Comm roots_comm, dataset_hdf5_t* dataset);
+
+/**
+ * Reads the entire dataset data on every process of roots_comm.
+ * With parallel HDF5 each process reads a block of lines and the blocks are
+ * shared with MPI_Allgatherv. Otherwise only the first process reads the
+ * data and sends it to the others with MPI_Bcast, so the file is read once
+ */
+oknok_t hdf5_read_dataset_data_shared(hid_t dataset_id, MPI_Comm roots_comm,
+									  const uint64_t n_observations,
+									  const uint64_t n_words, word_t* data);
+
 /**
  * Returns the dataset dimensions stored in the hdf5 dataset
  */
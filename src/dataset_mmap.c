@@ -0,0 +1,141 @@
+/*
+ ============================================================================
+ Name        : dataset_mmap.c
+ Author      : Eduardo Ribeiro
+ Description : Maps the dataset data from the HDF5 file to memory
+ ============================================================================
+ */
+
+// mmap is not part of C99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+// POSIX_MADV_DONTNEED doesn't drop the pages on Linux, MADV_DONTNEED does
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
+#include "dataset_mmap.h"
+
+#include "types/dataset_mmap_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include "hdf5.h"
+
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+bool can_map_dataset_data(hid_t dataset_id, uint64_t* offset)
+{
+	hid_t dcpl_id = H5Dget_create_plist(dataset_id);
+
+	bool contiguous = H5Pget_layout(dcpl_id) == H5D_CONTIGUOUS
+		&& H5Pget_nfilters(dcpl_id) == 0;
+
+	H5Pclose(dcpl_id);
+
+	hid_t type_id = H5Dget_type(dataset_id);
+
+	bool native = H5Tequal(type_id, H5T_NATIVE_UINT64) > 0;
+
+	H5Tclose(type_id);
+
+	if (!contiguous || !native)
+	{
+		return false;
+	}
+
+	// The offset is undefined if the data was never written
+	haddr_t address = H5Dget_offset(dataset_id);
+	if (address == HADDR_UNDEF)
+	{
+		return false;
+	}
+
+	*offset = (uint64_t) address;
+
+	return true;
+}
+
+oknok_t map_dataset_data(const char* filename, const uint64_t offset,
+						 const uint64_t n_words, dataset_mmap_t* mapping,
+						 word_t** data)
+{
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Error opening file %s\n", filename);
+		return NOK;
+	}
+
+	// The mapping must start on a page
+	uint64_t page_size = (uint64_t) sysconf(_SC_PAGESIZE);
+	uint64_t start	   = offset - offset % page_size;
+	uint64_t skip	   = offset - start;
+
+	mapping->length = skip + n_words * sizeof(word_t);
+	mapping->address
+		= mmap(NULL, mapping->length, PROT_READ, MAP_SHARED, fd, (off_t) start);
+
+	// The mapping stays valid after the file is closed
+	close(fd);
+
+	if (mapping->address == MAP_FAILED)
+	{
+		fprintf(stderr, "Error mapping file %s\n", filename);
+
+		mapping->address = NULL;
+		mapping->length	 = 0;
+		return NOK;
+	}
+
+	*data = (word_t*) ((char*) mapping->address + skip);
+
+	return OK;
+}
+
+void prefetch_dataset_lines(const word_t* lines, const uint64_t n_words)
+{
+	uintptr_t page_size = (uintptr_t) sysconf(_SC_PAGESIZE);
+	uintptr_t start		= (uintptr_t) lines;
+	uintptr_t end		= (uintptr_t) (lines + n_words);
+
+	// The mapping covers the whole pages of the data
+	start -= start % page_size;
+
+	// It's only a hint, the lines are read when they are used anyway
+	posix_madvise((void*) start, end - start, POSIX_MADV_WILLNEED);
+}
+
+void release_dataset_lines(const word_t* lines, const uint64_t n_words)
+{
+	uintptr_t page_size = (uintptr_t) sysconf(_SC_PAGESIZE);
+	uintptr_t start		= (uintptr_t) lines;
+	uintptr_t end		= (uintptr_t) (lines + n_words);
+
+	// The first and last pages may have lines still in use
+	start += (page_size - start % page_size) % page_size;
+	end -= end % page_size;
+
+	if (start < end)
+	{
+		madvise((void*) start, end - start, MADV_DONTNEED);
+	}
+}
+
+void unmap_dataset_data(dataset_mmap_t* mapping)
+{
+	if (mapping->address != NULL)
+	{
+		munmap(mapping->address, mapping->length);
+	}
+
+	mapping->address = NULL;
+	mapping->length	 = 0;
+}
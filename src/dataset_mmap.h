@@ -0,0 +1,61 @@
+/*
+ ============================================================================
+ Name        : dataset_mmap.h
+ Author      : Eduardo Ribeiro
+ Description : Maps the dataset data from the HDF5 file to memory
+ ============================================================================
+ */
+
+#ifndef DATASET_MMAP_H
+#define DATASET_MMAP_H
+
+#include "types/dataset_mmap_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include "hdf5.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Only datasets that are not changed after they are read can be mapped,
+ * like the preprocessed dataset. The processes of a node share the pages of
+ * the file in the page cache, so the data isn't copied by HDF5 and isn't
+ * read again by each run.
+ */
+
+/**
+ * Checks if the dataset data can be mapped: it must be contiguous, without
+ * filters, already written and stored as native 64 bit words.
+ * The position of the data in the file is stored in offset
+ */
+bool can_map_dataset_data(hid_t dataset_id, uint64_t* offset);
+
+/**
+ * Maps n_words words of the file, starting at offset, as read only memory.
+ * data is set to the first word
+ */
+oknok_t map_dataset_data(const char* filename, const uint64_t offset,
+						 const uint64_t n_words, dataset_mmap_t* mapping,
+						 word_t** data);
+
+/**
+ * Tells the system that the n_words words of mapped data starting at lines
+ * are used next, so they are read from the file while other lines are used
+ */
+void prefetch_dataset_lines(const word_t* lines, const uint64_t n_words);
+
+/**
+ * Drops the n_words words of mapped data starting at lines from the memory
+ * of the process. They are read again from the file if they are used later.
+ * Only the pages with nothing but those words are dropped
+ */
+void release_dataset_lines(const word_t* lines, const uint64_t n_words);
+
+/**
+ * Removes the mapping
+ */
+void unmap_dataset_data(dataset_mmap_t* mapping);
+
+#endif // DATASET_MMAP_H
@@ -0,0 +1,400 @@
+/*
+ ============================================================================
+ Name        : dataset_omp.c
+ Author      : Eduardo Ribeiro
+ Description : Splits the dataset preprocessing between OpenMP threads
+ ============================================================================
+ */
+
+#include "dataset_omp.h"
+
+#include "dataset.h"
+#include "jnsq.h"
+#include "types/dataset_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/block.h"
+#include "utils/sort_r.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Merges the sorted lines [a, a_end) and [b, b_end) into out
+ */
+static void merge_lines(const word_t* a, const word_t* a_end, const word_t* b,
+						const word_t* b_end, uint64_t n_words, word_t* out)
+{
+	size_t line_size = n_words * sizeof(word_t);
+
+	while (a < a_end && b < b_end)
+	{
+		// Keep the order of equal lines, like sort_r
+		if (compare_lines_extra(b, a, &n_words) < 0)
+		{
+			memcpy(out, b, line_size);
+			NEXT_LINE(b, n_words);
+		}
+		else
+		{
+			memcpy(out, a, line_size);
+			NEXT_LINE(a, n_words);
+		}
+
+		NEXT_LINE(out, n_words);
+	}
+
+	if (a < a_end)
+	{
+		memcpy(out, a, (a_end - a) * sizeof(word_t));
+	}
+
+	if (b < b_end)
+	{
+		memcpy(out, b, (b_end - b) * sizeof(word_t));
+	}
+}
+
+oknok_t sort_dataset_omp(dataset_t* dataset, const uint64_t n_threads)
+{
+	uint64_t n_words = dataset->n_words;
+	uint64_t n_obs	 = dataset->n_observations;
+
+	word_t* tmp = NULL;
+
+	if (n_threads > 1 && n_obs > n_threads)
+	{
+		tmp = (word_t*) malloc(n_obs * n_words * sizeof(word_t));
+	}
+
+	if (tmp == NULL)
+	{
+		sort_r(dataset->data, n_obs, n_words * sizeof(word_t),
+			   compare_lines_extra, &n_words);
+
+		return OK;
+	}
+
+	/**
+	 * First line of each sorted run, the last one is n_obs
+	 */
+	uint64_t* runs = (uint64_t*) malloc((n_threads + 1) * sizeof(uint64_t));
+	if (runs == NULL)
+	{
+		free(tmp);
+		return NOK;
+	}
+
+	for (uint64_t t = 0; t <= n_threads; t++)
+	{
+		runs[t] = BLOCK_LOW(t, n_threads, n_obs);
+	}
+
+#pragma omp parallel for num_threads(n_threads) schedule(static, 1)
+	for (uint64_t t = 0; t < n_threads; t++)
+	{
+		sort_r(dataset->data + runs[t] * n_words, runs[t + 1] - runs[t],
+			   n_words * sizeof(word_t), compare_lines_extra, &n_words);
+	}
+
+	word_t* src = dataset->data;
+	word_t* dst = tmp;
+
+	// Merge the runs in pairs until there is only one
+	for (uint64_t n_runs = n_threads; n_runs > 1; n_runs = (n_runs + 1) / 2)
+	{
+#pragma omp parallel for num_threads(n_threads) schedule(dynamic, 1)
+		for (uint64_t r = 0; r < n_runs; r += 2)
+		{
+			uint64_t end = r + 2 <= n_runs ? runs[r + 2] : runs[r + 1];
+
+			merge_lines(src + runs[r] * n_words, src + runs[r + 1] * n_words,
+						src + runs[r + 1] * n_words, src + end * n_words,
+						n_words, dst + runs[r] * n_words);
+		}
+
+		// The merged runs start on the even runs
+		for (uint64_t r = 0; r < n_runs; r += 2)
+		{
+			runs[r / 2] = runs[r];
+		}
+		runs[(n_runs + 1) / 2] = n_obs;
+
+		word_t* swap = src;
+		src			 = dst;
+		dst			 = swap;
+	}
+
+	// The sorted lines must end up in the dataset
+	if (src != dataset->data)
+	{
+#pragma omp parallel for num_threads(n_threads) schedule(static, 1)
+		for (uint64_t t = 0; t < n_threads; t++)
+		{
+			uint64_t first = BLOCK_LOW(t, n_threads, n_obs);
+
+			memcpy(dataset->data + first * n_words, src + first * n_words,
+				   BLOCK_SIZE(t, n_threads, n_obs) * n_words * sizeof(word_t));
+		}
+	}
+
+	free(runs);
+	free(tmp);
+
+	return OK;
+}
+
+uint64_t remove_duplicates_omp(dataset_t* dataset, const uint64_t n_threads)
+{
+	uint64_t n_words = dataset->n_words;
+	uint64_t n_obs	 = dataset->n_observations;
+
+	/**
+	 * Number of unique lines in each block
+	 */
+	uint64_t* n_uniques = (uint64_t*) calloc(n_threads, sizeof(uint64_t));
+
+	/**
+	 * The first line of each block is not a copy of the previous line
+	 */
+	bool* first_unique = (bool*) calloc(n_threads, sizeof(bool));
+
+	if (n_threads == 1 || n_obs <= n_threads || n_uniques == NULL
+		|| first_unique == NULL)
+	{
+		free(n_uniques);
+		free(first_unique);
+
+		return remove_duplicates(dataset);
+	}
+
+	word_t* data = dataset->data;
+
+	// The blocks must know their first line before any line is moved
+#pragma omp parallel num_threads(n_threads)
+	{
+#pragma omp for schedule(static, 1)
+		for (uint64_t t = 0; t < n_threads; t++)
+		{
+			uint64_t first = BLOCK_LOW(t, n_threads, n_obs);
+
+			first_unique[t] = first == 0
+				|| compare_lines_extra(data + first * n_words,
+									   data + (first - 1) * n_words, &n_words)
+					!= 0;
+		}
+
+		// Remove the duplicates inside each block, keeping it in place
+#pragma omp for schedule(static, 1)
+		for (uint64_t t = 0; t < n_threads; t++)
+		{
+			uint64_t first = BLOCK_LOW(t, n_threads, n_obs);
+			uint64_t size  = BLOCK_SIZE(t, n_threads, n_obs);
+
+			word_t* line = data + first * n_words;
+			word_t* last = line;
+
+			uint64_t n = first_unique[t];
+			if (!first_unique[t])
+			{
+				// The first line is overwritten by the next unique line
+				last = GET_PREV_LINE(last, n_words);
+			}
+
+			for (uint64_t i = 1; i < size; i++)
+			{
+				NEXT_LINE(line, n_words);
+
+				// last may be the previous block, which is not changed
+				if (compare_lines_extra(line, last, &n_words) != 0)
+				{
+					NEXT_LINE(last, n_words);
+					n++;
+					if (last != line)
+					{
+						memcpy(last, line, sizeof(word_t) * n_words);
+					}
+				}
+			}
+
+			n_uniques[t] = n;
+		}
+	}
+
+	/**
+	 * Move the unique lines of each block after the ones of the previous
+	 * block. The lines only move back, so they are moved in order
+	 */
+	uint64_t n_total = 0;
+
+	for (uint64_t t = 0; t < n_threads; t++)
+	{
+		uint64_t first = BLOCK_LOW(t, n_threads, n_obs);
+
+		if (n_total != first && n_uniques[t] > 0)
+		{
+			memmove(data + n_total * n_words, data + first * n_words,
+					n_uniques[t] * n_words * sizeof(word_t));
+		}
+
+		n_total += n_uniques[t];
+	}
+
+	free(n_uniques);
+	free(first_unique);
+
+	// Update number of observations, so the code ignores the remaining lines
+	dataset->n_observations = n_total;
+	return (n_obs - n_total);
+}
+
+uint64_t add_jnsqs_omp(dataset_t* dataset, const uint64_t n_threads)
+{
+	uint64_t n_attributes	 = dataset->n_attributes;
+	uint64_t n_words		 = dataset->n_words;
+	uint64_t n_obs			 = dataset->n_observations;
+	uint8_t n_bits_for_class = dataset->n_bits_for_class;
+
+	/**
+	 * Inconsistency of the first line of each block
+	 */
+	uint64_t* first_inconsistency
+		= (uint64_t*) calloc(n_threads, sizeof(uint64_t));
+
+	/**
+	 * Inconsistency of the last line of each block, counting from 0 on the
+	 * first line of the block
+	 */
+	uint64_t* last_inconsistency
+		= (uint64_t*) calloc(n_threads, sizeof(uint64_t));
+
+	/**
+	 * The first line of the block has the same attributes as the previous
+	 * line, and the block has no other attributes
+	 */
+	bool* joins_previous = (bool*) calloc(n_threads, sizeof(bool));
+	bool* single_run	 = (bool*) calloc(n_threads, sizeof(bool));
+
+	if (n_threads == 1 || n_obs <= n_threads || first_inconsistency == NULL
+		|| last_inconsistency == NULL || joins_previous == NULL
+		|| single_run == NULL)
+	{
+		free(first_inconsistency);
+		free(last_inconsistency);
+		free(joins_previous);
+		free(single_run);
+
+		return add_jnsqs(dataset);
+	}
+
+	word_t* data = dataset->data;
+
+	uint64_t max_inconsistency = 0;
+
+#pragma omp parallel num_threads(n_threads)
+	{
+		// Find the inconsistencies of each block, without changing any line
+#pragma omp for schedule(static, 1)
+		for (uint64_t t = 0; t < n_threads; t++)
+		{
+			uint64_t first = BLOCK_LOW(t, n_threads, n_obs);
+			uint64_t size  = BLOCK_SIZE(t, n_threads, n_obs);
+
+			word_t* line = data + first * n_words;
+
+			joins_previous[t] = first > 0
+				&& has_same_attributes(line, GET_PREV_LINE(line, n_words),
+									   n_attributes);
+
+			uint64_t inconsistency = 0;
+			bool same			   = true;
+
+			for (uint64_t i = 1; i < size; i++)
+			{
+				NEXT_LINE(line, n_words);
+
+				if (has_same_attributes(line, GET_PREV_LINE(line, n_words),
+										n_attributes))
+				{
+					inconsistency++;
+				}
+				else
+				{
+					inconsistency = 0;
+					same		  = false;
+				}
+			}
+
+			last_inconsistency[t] = inconsistency;
+			single_run[t]		  = same;
+		}
+
+#pragma omp single
+		{
+			// Carry the inconsistencies across the block boundaries
+			uint64_t last = 0;
+
+			for (uint64_t t = 0; t < n_threads; t++)
+			{
+				first_inconsistency[t] = joins_previous[t] ? last + 1 : 0;
+
+				last = single_run[t]
+					? first_inconsistency[t] + last_inconsistency[t]
+					: last_inconsistency[t];
+			}
+		}
+
+		// Set the jnsqs. The first line is not compared with the previous
+		// block, which may be changing
+#pragma omp for schedule(static, 1) reduction(max : max_inconsistency)
+		for (uint64_t t = 0; t < n_threads; t++)
+		{
+			uint64_t first = BLOCK_LOW(t, n_threads, n_obs);
+			uint64_t size  = BLOCK_SIZE(t, n_threads, n_obs);
+
+			word_t* line = data + first * n_words;
+
+			uint64_t inconsistency = first_inconsistency[t];
+
+			if (inconsistency > max_inconsistency)
+			{
+				max_inconsistency = inconsistency;
+			}
+
+			set_jnsq_bits(line, inconsistency, n_attributes, n_words,
+						  n_bits_for_class);
+
+			for (uint64_t i = 1; i < size; i++)
+			{
+				NEXT_LINE(line, n_words);
+
+				if (has_same_attributes(line, GET_PREV_LINE(line, n_words),
+										n_attributes))
+				{
+					inconsistency++;
+
+					if (inconsistency > max_inconsistency)
+					{
+						max_inconsistency = inconsistency;
+					}
+				}
+				else
+				{
+					inconsistency = 0;
+				}
+
+				set_jnsq_bits(line, inconsistency, n_attributes, n_words,
+							  n_bits_for_class);
+			}
+		}
+	}
+
+	free(first_inconsistency);
+	free(last_inconsistency);
+	free(joins_previous);
+	free(single_run);
+
+	return max_inconsistency;
+}
@@ -0,0 +1,46 @@
+/*
+ ============================================================================
+ Name        : dataset_omp.h
+ Author      : Eduardo Ribeiro
+ Description : Splits the dataset preprocessing between OpenMP threads
+ ============================================================================
+ */
+
+#ifndef DATASET_OMP_H
+#define DATASET_OMP_H
+
+#include "types/dataset_t.h"
+#include "types/oknok_t.h"
+
+#include <stdint.h>
+
+/**
+ * These functions have the same behaviour as sort_r with compare_lines_extra,
+ * remove_duplicates and add_jnsqs. The lines are split in one block per
+ * thread, and the threads fix the results on the boundaries of the blocks.
+ */
+
+/**
+ * Sorts the dataset lines.
+ * Each thread sorts its block, and the sorted blocks are merged in pairs
+ * using a temporary copy of the data. If there is no memory for the copy the
+ * dataset is sorted by a single thread
+ */
+oknok_t sort_dataset_omp(dataset_t* dataset, const uint64_t n_threads);
+
+/**
+ * Removes duplicated lines from the dataset.
+ * Assumes the dataset is ordered
+ * Returns number of removed observations
+ */
+uint64_t remove_duplicates_omp(dataset_t* dataset, const uint64_t n_threads);
+
+/**
+ * Adds the JNSQs attributes to the dataset.
+ * The dataset must be sorted and not have any duplicates in it
+ *
+ * Returns max inconsistency found
+ */
+uint64_t add_jnsqs_omp(dataset_t* dataset, const uint64_t n_threads);
+
+#endif // DATASET_OMP_H
@@ -0,0 +1,293 @@
+/*
+ ============================================================================
+ Name        : dataset_reduce.c
+ Author      : Eduardo Ribeiro
+ Description : Removes the attributes that can't change the set cover
+			   solution before it starts
+ ============================================================================
+ */
+
+#include "dataset_reduce.h"
+
+#include "dataset_transposed.h"
+#include "types/attributes_map_t.h"
+#include "types/dataset_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/bit.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+oknok_t init_attributes_map(const uint64_t n_attributes,
+							attributes_map_t* map)
+{
+	map->n_attributes = n_attributes;
+	map->n_words
+		= n_attributes / WORD_BITS + (n_attributes % WORD_BITS != 0);
+	map->n_kept		  = n_attributes;
+
+	map->original = (uint64_t*) malloc(n_attributes * sizeof(uint64_t));
+	map->kept	  = (int64_t*) malloc(n_attributes * sizeof(int64_t));
+
+	if (map->original == NULL || map->kept == NULL)
+	{
+		free_attributes_map(map);
+		return NOK;
+	}
+
+	for (uint64_t a = 0; a < n_attributes; a++)
+	{
+		map->original[a] = a;
+		map->kept[a]	 = (int64_t) a;
+	}
+
+	return OK;
+}
+
+/**
+ * The bits of word w of the class c columns that are observations
+ */
+static word_t get_column_mask(const dataset_t* dataset, const uint64_t c,
+							  const uint64_t w)
+{
+	uint64_t n_bits = dataset->n_observations_per_class[c] - w * WORD_BITS;
+
+	return n_bits >= WORD_BITS ? ~0UL : ~(~0UL >> n_bits);
+}
+
+/**
+ * Returns a mask with all the bits set if the first observation of the
+ * dataset has attribute set, so its column is inverted
+ */
+static word_t get_column_invert(const dataset_t* dataset, const uint64_t a)
+{
+	for (uint64_t c = 0; c < dataset->n_classes; c++)
+	{
+		if (dataset->n_observations_per_class[c] > 0)
+		{
+			word_t first = dataset->columns_per_class[c]
+							   [a * get_class_column_words(dataset, c)];
+
+			return BIT_CHECK(first, WORD_BITS - 1) ? ~0UL : 0;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Hashes the columns of attribute a with the first observation cleared.
+ * empty is set if no observation is set
+ */
+static uint64_t hash_column(const dataset_t* dataset, const uint64_t a,
+							bool* empty)
+{
+	word_t invert = get_column_invert(dataset, a);
+
+	// FNV-1a over the words
+	uint64_t hash = 14695981039346656037UL;
+	word_t bits	  = 0;
+
+	for (uint64_t c = 0; c < dataset->n_classes; c++)
+	{
+		uint64_t n_class_words = get_class_column_words(dataset, c);
+
+		const word_t* column
+			= dataset->columns_per_class[c] + a * n_class_words;
+
+		for (uint64_t w = 0; w < n_class_words; w++)
+		{
+			word_t word
+				= (column[w] ^ invert) & get_column_mask(dataset, c, w);
+
+			hash ^= word;
+			hash *= 1099511628211UL;
+			bits |= word;
+		}
+	}
+
+	*empty = bits == 0;
+
+	return hash;
+}
+
+/**
+ * Checks if attributes a and b have the same column
+ */
+static bool has_same_column(const dataset_t* dataset, const uint64_t a,
+							const uint64_t b)
+{
+	word_t invert_a = get_column_invert(dataset, a);
+	word_t invert_b = get_column_invert(dataset, b);
+
+	for (uint64_t c = 0; c < dataset->n_classes; c++)
+	{
+		uint64_t n_class_words = get_class_column_words(dataset, c);
+
+		const word_t* column_a
+			= dataset->columns_per_class[c] + a * n_class_words;
+		const word_t* column_b
+			= dataset->columns_per_class[c] + b * n_class_words;
+
+		for (uint64_t w = 0; w < n_class_words; w++)
+		{
+			if (((column_a[w] ^ invert_a ^ column_b[w] ^ invert_b)
+				 & get_column_mask(dataset, c, w))
+				!= 0)
+			{
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+oknok_t find_redundant_attributes(const dataset_t* dataset,
+								  attributes_map_t* map,
+								  const uint64_t n_threads)
+{
+	uint64_t n_attributes = map->n_attributes;
+
+	// Open addressing table with the kept attributes, at most half full
+	uint64_t table_size = 1;
+	while (table_size < 2 * n_attributes)
+	{
+		table_size <<= 1;
+	}
+
+	uint64_t* hashes = (uint64_t*) malloc(n_attributes * sizeof(uint64_t));
+	bool* empty		 = (bool*) malloc(n_attributes * sizeof(bool));
+	int64_t* table	 = (int64_t*) malloc(table_size * sizeof(int64_t));
+
+	if (hashes == NULL || empty == NULL || table == NULL)
+	{
+		free(hashes);
+		free(empty);
+		free(table);
+		return NOK;
+	}
+
+	memset(table, 0xff, table_size * sizeof(int64_t));
+
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+	for (uint64_t a = 0; a < n_attributes; a++)
+	{
+		hashes[a] = hash_column(dataset, a, &empty[a]);
+	}
+
+	map->n_kept = 0;
+
+	// The first attribute of each column is kept
+	for (uint64_t a = 0; a < n_attributes; a++)
+	{
+		if (empty[a])
+		{
+			map->kept[a] = -1;
+			continue;
+		}
+
+		uint64_t slot = hashes[a] & (table_size - 1);
+
+		while (table[slot] >= 0
+			   && (hashes[table[slot]] != hashes[a]
+				   || !has_same_column(dataset, table[slot], a)))
+		{
+			slot = (slot + 1) & (table_size - 1);
+		}
+
+		if (table[slot] >= 0)
+		{
+			map->kept[a] = map->kept[table[slot]];
+			continue;
+		}
+
+		table[slot] = (int64_t) a;
+
+		map->kept[a]			   = (int64_t) map->n_kept;
+		map->original[map->n_kept] = a;
+		map->n_kept++;
+	}
+
+	free(hashes);
+	free(empty);
+	free(table);
+
+	return OK;
+}
+
+oknok_t remove_redundant_attributes(const dataset_t* dataset,
+									const attributes_map_t* map,
+									const uint64_t n_threads)
+{
+	uint64_t stride = dataset->line_stride;
+
+	// The kept attributes only move back, so they are moved in order
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+	for (uint64_t i = 0; i < dataset->n_observations; i++)
+	{
+		word_t* line = dataset->data + i * stride;
+
+		for (uint64_t a = 0; a < map->n_kept; a++)
+		{
+			uint64_t from = map->original[a];
+			if (from == a)
+			{
+				continue;
+			}
+
+			uint8_t from_bit = WORD_BITS - from % WORD_BITS - 1;
+			uint8_t to_bit	 = WORD_BITS - a % WORD_BITS - 1;
+
+			if (BIT_CHECK(line[from / WORD_BITS], from_bit))
+			{
+				BIT_SET(line[a / WORD_BITS], to_bit);
+			}
+			else
+			{
+				BIT_CLEAR(line[a / WORD_BITS], to_bit);
+			}
+		}
+
+		// The bits after the kept attributes are not part of any column
+		for (uint64_t a = map->n_kept; a < map->n_attributes; a++)
+		{
+			BIT_CLEAR(line[a / WORD_BITS], WORD_BITS - a % WORD_BITS - 1);
+		}
+	}
+
+	if (dataset->columns_per_class == NULL)
+	{
+		return OK;
+	}
+
+	for (uint64_t c = 0; c < dataset->n_classes; c++)
+	{
+		uint64_t n_class_words = get_class_column_words(dataset, c);
+		word_t* columns		   = dataset->columns_per_class[c];
+
+		for (uint64_t a = 0; a < map->n_kept; a++)
+		{
+			if (map->original[a] != a)
+			{
+				memmove(columns + a * n_class_words,
+						columns + map->original[a] * n_class_words,
+						n_class_words * sizeof(word_t));
+			}
+		}
+	}
+
+	return OK;
+}
+
+void free_attributes_map(attributes_map_t* map)
+{
+	free(map->original);
+	free(map->kept);
+
+	map->original = NULL;
+	map->kept	  = NULL;
+}
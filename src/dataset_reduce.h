@@ -0,0 +1,53 @@
+/*
+ ============================================================================
+ Name        : dataset_reduce.h
+ Author      : Eduardo Ribeiro
+ Description : Removes the attributes that can't change the set cover
+			   solution before it starts
+ ============================================================================
+ */
+
+#ifndef DATASET_REDUCE_H
+#define DATASET_REDUCE_H
+
+#include "types/attributes_map_t.h"
+#include "types/dataset_t.h"
+#include "types/oknok_t.h"
+
+#include <stdint.h>
+
+/**
+ * Sets map to keep all the n_attributes attributes
+ */
+oknok_t init_attributes_map(const uint64_t n_attributes,
+							attributes_map_t* map);
+
+/**
+ * Finds the attributes with an empty disjoint matrix column (the same value
+ * on every observation) and the ones with the same column as an attribute
+ * before them (the same or the inverted value on every observation).
+ * They are never selected: the set cover picks the first of the attributes
+ * with the best total, and then the others cover no lines.
+ *
+ * Uses the transposed dataset. The columns are hashed, after inverting the
+ * ones where the first observation is set, and the attributes with the same
+ * hash are compared
+ */
+oknok_t find_redundant_attributes(const dataset_t* dataset,
+								  attributes_map_t* map,
+								  const uint64_t n_threads);
+
+/**
+ * Moves the kept attributes to the start of the lines and of the transposed
+ * columns of every class. The dataset sizes are not changed
+ */
+oknok_t remove_redundant_attributes(const dataset_t* dataset,
+									const attributes_map_t* map,
+									const uint64_t n_threads);
+
+/**
+ * Frees the map memory
+ */
+void free_attributes_map(attributes_map_t* map);
+
+#endif // DATASET_REDUCE_H
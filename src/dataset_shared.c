@@ -0,0 +1,73 @@
+/*
+ ============================================================================
+ Name        : dataset_shared.c
+ Author      : Eduardo Ribeiro
+ Description : Shared memory windows of the dataset, kept between runs
+ ============================================================================
+ */
+
+#include "dataset_shared.h"
+
+#include "types/oknok_t.h"
+#include "types/shared_window_t.h"
+#include "types/word_t.h"
+#include "utils/ranks.h"
+
+#include "mpi.h"
+
+#include <stdint.h>
+
+void init_shared_window(shared_window_t* window)
+{
+	window->window	= MPI_WIN_NULL;
+	window->n_words = 0;
+	window->data	= NULL;
+}
+
+oknok_t get_shared_window(MPI_Comm node_comm, uint64_t n_words,
+						  shared_window_t* window)
+{
+	int node_rank;
+	MPI_Comm_rank(node_comm, &node_rank);
+
+	MPI_Bcast(&n_words, 1, MPI_UINT64_T, LOCAL_ROOT_RANK, node_comm);
+
+	if (window->window != MPI_WIN_NULL && n_words <= window->n_words)
+	{
+		return OK;
+	}
+
+	free_shared_window(window);
+
+	uint64_t local_words = node_rank == LOCAL_ROOT_RANK ? n_words : 0;
+
+	if (MPI_Win_allocate_shared(local_words * sizeof(word_t), sizeof(word_t),
+								MPI_INFO_NULL, node_comm, &window->data,
+								&window->window)
+		!= MPI_SUCCESS)
+	{
+		return NOK;
+	}
+
+	if (node_rank != LOCAL_ROOT_RANK)
+	{
+		MPI_Aint win_size;
+		int win_disp;
+		MPI_Win_shared_query(window->window, LOCAL_ROOT_RANK, &win_size,
+							 &win_disp, &window->data);
+	}
+
+	window->n_words = n_words;
+
+	return OK;
+}
+
+void free_shared_window(shared_window_t* window)
+{
+	if (window->window != MPI_WIN_NULL)
+	{
+		MPI_Win_free(&window->window);
+	}
+
+	init_shared_window(window);
+}
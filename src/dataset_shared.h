@@ -0,0 +1,39 @@
+/*
+ ============================================================================
+ Name        : dataset_shared.h
+ Author      : Eduardo Ribeiro
+ Description : Shared memory windows of the dataset, kept between runs
+ ============================================================================
+ */
+
+#ifndef DATASET_SHARED_H
+#define DATASET_SHARED_H
+
+#include "types/oknok_t.h"
+#include "types/shared_window_t.h"
+
+#include "mpi.h"
+
+#include <stdint.h>
+
+/**
+ * Sets window to have no memory
+ */
+void init_shared_window(shared_window_t* window);
+
+/**
+ * Makes the node root memory of window at least n_words long and points
+ * window->data to it on every process of node_comm. Only the n_words of
+ * the node root are used.
+ * The window is only allocated again if it is smaller, so its contents are
+ * lost then
+ */
+oknok_t get_shared_window(MPI_Comm node_comm, uint64_t n_words,
+						  shared_window_t* window);
+
+/**
+ * Frees the window
+ */
+void free_shared_window(shared_window_t* window);
+
+#endif // DATASET_SHARED_H
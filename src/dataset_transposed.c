@@ -0,0 +1,224 @@
+/*
+ ============================================================================
+ Name        : dataset_transposed.c
+ Author      : Eduardo Ribeiro
+ Description : Transposed copy of the dataset, with one bitset over the
+			   observations of each class for each attribute
+ ============================================================================
+ */
+
+// sysconf is not part of C99
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "dataset_transposed.h"
+
+#include "disjoint_matrix_mpi.h"
+#include "types/dataset_t.h"
+#include "types/dm_segment_t.h"
+#include "types/dm_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/bit.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+uint64_t get_class_column_words(const dataset_t* dataset, const uint64_t c)
+{
+	uint64_t n_obs = dataset->n_observations_per_class[c];
+
+	return n_obs / WORD_BITS + (n_obs % WORD_BITS != 0);
+}
+
+uint64_t get_transposed_size(const dataset_t* dataset)
+{
+	uint64_t size = 0;
+
+	for (uint64_t c = 0; c < dataset->n_classes; c++)
+	{
+		size += dataset->n_attributes * get_class_column_words(dataset, c);
+	}
+
+	return size;
+}
+
+bool can_transpose_dataset(const dataset_t* dataset,
+						   const uint64_t max_memory)
+{
+	uint64_t size = get_transposed_size(dataset) * sizeof(word_t);
+
+	if (max_memory != UINT64_MAX)
+	{
+		return size <= max_memory * 1024 * 1024;
+	}
+
+	long pages	   = sysconf(_SC_AVPHYS_PAGES);
+	long page_size = sysconf(_SC_PAGESIZE);
+
+	// The available memory is not known
+	if (pages < 0 || page_size < 0)
+	{
+		return true;
+	}
+
+	return size <= (uint64_t) pages * (uint64_t) page_size;
+}
+
+oknok_t set_columns_per_class(dataset_t* dataset, word_t* columns)
+{
+	dataset->columns_per_class
+		= (word_t**) calloc(dataset->n_classes, sizeof(word_t*));
+	if (dataset->columns_per_class == NULL)
+	{
+		return NOK;
+	}
+
+	for (uint64_t c = 0; c < dataset->n_classes; c++)
+	{
+		dataset->columns_per_class[c] = columns;
+
+		columns += dataset->n_attributes * get_class_column_words(dataset, c);
+	}
+
+	return OK;
+}
+
+oknok_t transpose_dataset(const dataset_t* dataset, const uint64_t n_threads)
+{
+	uint64_t n_attributes = dataset->n_attributes;
+	uint64_t n_words	  = dataset->n_words;
+	uint64_t stride		  = dataset->line_stride;
+
+	for (uint64_t c = 0; c < dataset->n_classes; c++)
+	{
+		uint64_t n_obs		   = dataset->n_observations_per_class[c];
+		uint64_t n_class_words = get_class_column_words(dataset, c);
+
+		const word_t* lines = dataset->observations_per_class[c];
+		word_t* columns		= dataset->columns_per_class[c];
+
+		// Each block of 64 observations fills one word of the columns
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+		for (uint64_t b = 0; b < n_class_words; b++)
+		{
+			word_t tile[WORD_BITS];
+
+			uint64_t first = b * WORD_BITS;
+			uint64_t n	   = n_obs - first;
+			if (n > WORD_BITS)
+			{
+				n = WORD_BITS;
+			}
+
+			for (uint64_t w = 0; w < n_words; w++)
+			{
+				for (uint64_t i = 0; i < n; i++)
+				{
+					tile[i] = lines[(first + i) * stride + w];
+				}
+
+				// Clear observations that were not filled
+				if (n < WORD_BITS)
+				{
+					memset(tile + n, 0, (WORD_BITS - n) * sizeof(word_t));
+				}
+
+				transpose64(tile);
+
+				// Row i has the bits of attribute w * WORD_BITS + i
+				uint64_t n_rows = n_attributes - w * WORD_BITS;
+				if (n_rows > WORD_BITS)
+				{
+					n_rows = WORD_BITS;
+				}
+
+				for (uint64_t i = 0; i < n_rows; i++)
+				{
+					columns[(w * WORD_BITS + i) * n_class_words + b] = tile[i];
+				}
+			}
+		}
+	}
+
+	return OK;
+}
+
+/**
+ * Copies n bits of src, starting at bit src_bit, to dst, starting at bit
+ * dst_bit, inverting them if invert is all ones.
+ * The bits of dst must be clear
+ */
+static void copy_column_bits(const word_t* src, uint64_t src_bit, uint64_t n,
+							 const word_t invert, word_t* dst, uint64_t dst_bit)
+{
+	while (n > 0)
+	{
+		uint64_t sw = src_bit / WORD_BITS;
+		uint8_t so	= src_bit % WORD_BITS;
+		uint8_t dso = dst_bit % WORD_BITS;
+
+		// Bits that still fit in this word of dst
+		uint64_t take = WORD_BITS - dso;
+		if (take > n)
+		{
+			take = n;
+		}
+
+		word_t bits = src[sw] << so;
+
+		// Only read the next word if the bits continue there
+		if (so + take > WORD_BITS)
+		{
+			bits |= src[sw + 1] >> (WORD_BITS - so);
+		}
+
+		// Keep the first take bits
+		bits = ((bits ^ invert) >> (WORD_BITS - take)) << (WORD_BITS - take);
+
+		dst[dst_bit / WORD_BITS] |= bits >> dso;
+
+		src_bit += take;
+		dst_bit += take;
+		n -= take;
+	}
+}
+
+oknok_t get_column_transposed(const dataset_t* dataset, const dm_t* dm,
+							  const int64_t attribute, word_t* column)
+{
+	// Which word has the index attribute
+	uint64_t attribute_word = attribute / WORD_BITS;
+
+	// Which bit?
+	uint8_t attribute_bit = WORD_BITS - (attribute % WORD_BITS) - 1;
+
+	uint64_t stride = dataset->line_stride;
+	word_t** opc	= dataset->observations_per_class;
+	word_t** cpc	= dataset->columns_per_class;
+
+	memset(column, 0, dm->n_words_in_a_column * sizeof(word_t));
+
+	dm_segment_t segment;
+
+	for (bool more = first_dm_segment(dataset, dm, &segment); more;
+		 more = next_dm_segment(dataset, dm, &segment))
+	{
+		word_t* la = opc[segment.classA] + segment.indexA * stride;
+
+		word_t invert
+			= BIT_CHECK(la[attribute_word], attribute_bit) ? ~0UL : 0;
+
+		const word_t* cb_column = cpc[segment.classB]
+			+ attribute * get_class_column_words(dataset, segment.classB);
+
+		copy_column_bits(cb_column, segment.indexB, segment.n_lines, invert,
+						 column, segment.line);
+	}
+
+	return OK;
+}
@@ -0,0 +1,60 @@
+/*
+ ============================================================================
+ Name        : dataset_transposed.h
+ Author      : Eduardo Ribeiro
+ Description : Transposed copy of the dataset, with one bitset over the
+			   observations of each class for each attribute
+ ============================================================================
+ */
+
+#ifndef DATASET_TRANSPOSED_H
+#define DATASET_TRANSPOSED_H
+
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Number of words of the column of one attribute of class c
+ */
+uint64_t get_class_column_words(const dataset_t* dataset, const uint64_t c);
+
+/**
+ * Number of words needed by the transposed copy of the dataset
+ */
+uint64_t get_transposed_size(const dataset_t* dataset);
+
+/**
+ * Checks if the transposed copy of the dataset fits in max_memory MB, or in
+ * the memory available now if max_memory is UINT64_MAX
+ */
+bool can_transpose_dataset(const dataset_t* dataset,
+						   const uint64_t max_memory);
+
+/**
+ * Sets the pointers to the columns of each class, stored in columns with
+ * get_transposed_size words. Allocates dataset->columns_per_class.
+ * The dataset must be grouped by class and have the jnsqs
+ */
+oknok_t set_columns_per_class(dataset_t* dataset, word_t* columns);
+
+/**
+ * Fills the columns of every class from the dataset lines, 64 observations
+ * at a time with transpose64
+ */
+oknok_t transpose_dataset(const dataset_t* dataset, const uint64_t n_threads);
+
+/**
+ * Same as get_column, using the transposed dataset.
+ * For each line of class A the lines of the matrix with class B are the
+ * column of class B, inverted if the attribute is set on the line of class A,
+ * so the column is copied a word at a time
+ */
+oknok_t get_column_transposed(const dataset_t* dataset, const dm_t* dm,
+							  const int64_t attribute, word_t* column);
+
+#endif // DATASET_TRANSPOSED_H
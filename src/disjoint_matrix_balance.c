@@ -0,0 +1,270 @@
+/*
+ ============================================================================
+ Name        : disjoint_matrix_balance.c
+ Author      : Eduardo Ribeiro
+ Description : Moves disjoint matrix lines between processes, to keep the
+			   same number of uncovered lines in each one
+ ============================================================================
+ */
+
+#include "disjoint_matrix_balance.h"
+
+#include "disjoint_matrix_mpi.h"
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include "mpi.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Returns the mask of the lines of dm stored in word w
+ */
+static word_t get_lines_mask(const dm_t* dm, const uint64_t w)
+{
+	uint64_t n_lines = dm->s_size - w * WORD_BITS;
+
+	if (n_lines >= WORD_BITS)
+	{
+		return ~0UL;
+	}
+
+	// Line i of the word is bit WORD_BITS - 1 - i
+	return ~(~0UL >> n_lines);
+}
+
+uint64_t get_n_uncovered_lines(const dm_t* dm, const word_t* covered_lines)
+{
+	uint64_t n_uncovered = 0;
+
+	for (uint64_t w = 0; w < dm->n_words_in_a_column; w++)
+	{
+		n_uncovered
+			+= __builtin_popcountll(~covered_lines[w] & get_lines_mask(dm, w));
+	}
+
+	return n_uncovered;
+}
+
+/**
+ * Returns the number of words shared by [a0, a1) and [b0, b1), and their
+ * first word in start
+ */
+static uint64_t get_overlap(const uint64_t a0, const uint64_t a1,
+							const uint64_t b0, const uint64_t b1,
+							uint64_t* start)
+{
+	*start = a0 > b0 ? a0 : b0;
+
+	uint64_t end = a1 < b1 ? a1 : b1;
+
+	return end > *start ? end - *start : 0;
+}
+
+/**
+ * Splits the words of the full columns between the processes, so each has
+ * about the same number of uncovered lines. The first word of process r is
+ * stored in first_words[r] and first_words[size] is the number of words
+ */
+static oknok_t split_uncovered_lines(MPI_Comm comm, const dm_t* dm,
+									 const word_t* covered_lines,
+									 const uint64_t n_uncovered_lines,
+									 const int size, uint64_t* first_words)
+{
+	uint64_t n_matrix_words = dm->n_matrix_lines / WORD_BITS
+		+ (dm->n_matrix_lines % WORD_BITS != 0);
+
+	// Number of words in a chunk
+	uint64_t n_chunks	 = (uint64_t) size * REBALANCE_CHUNKS;
+	uint64_t chunk_words = n_matrix_words / n_chunks
+		+ (n_matrix_words % n_chunks != 0);
+	n_chunks = n_matrix_words / chunk_words
+		+ (n_matrix_words % chunk_words != 0);
+
+	uint64_t* chunks = (uint64_t*) calloc(n_chunks, sizeof(uint64_t));
+	if (chunks == NULL)
+	{
+		return NOK;
+	}
+
+	uint64_t first_word = dm->s_offset / WORD_BITS;
+	for (uint64_t w = 0; w < dm->n_words_in_a_column; w++)
+	{
+		chunks[(first_word + w) / chunk_words] += __builtin_popcountll(
+			~covered_lines[w] & get_lines_mask(dm, w));
+	}
+
+	MPI_Allreduce(MPI_IN_PLACE, chunks, n_chunks, MPI_UINT64_T, MPI_SUM,
+				  comm);
+
+	first_words[0]	  = 0;
+	first_words[size] = n_matrix_words;
+
+	uint64_t c	 = 0;
+	uint64_t sum = 0;
+
+	for (int r = 1; r < size; r++)
+	{
+		uint64_t target = r * n_uncovered_lines / size;
+
+		while (c < n_chunks && sum < target)
+		{
+			sum += chunks[c];
+			c++;
+		}
+
+		first_words[r] = c * chunk_words;
+		if (first_words[r] > n_matrix_words)
+		{
+			first_words[r] = n_matrix_words;
+		}
+	}
+
+	free(chunks);
+
+	return OK;
+}
+
+oknok_t rebalance_dm(MPI_Comm comm, const dataset_t* dataset, dm_t* dm,
+					 const uint64_t round, const uint64_t n_uncovered_lines,
+					 word_t** covered_lines, word_t** best_column,
+					 bool* rebalanced)
+{
+	*rebalanced = false;
+
+	int rank;
+	int size;
+
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+
+	// The lines start balanced, and every process has the same round
+	if (size == 1 || round == 0 || round % REBALANCE_ROUNDS != 0)
+	{
+		return OK;
+	}
+
+	/**
+	 * First word, number of words and number of uncovered lines of each
+	 * process
+	 */
+	uint64_t info[3] = { dm->s_offset / WORD_BITS, dm->n_words_in_a_column,
+						 n_uncovered_lines };
+
+	uint64_t* all_info = (uint64_t*) malloc(3 * size * sizeof(uint64_t));
+	uint64_t* first_words
+		= (uint64_t*) malloc((size + 1) * sizeof(uint64_t));
+	int* counts = (int*) malloc(4 * size * sizeof(int));
+
+	if (all_info == NULL || first_words == NULL || counts == NULL)
+	{
+		free(all_info);
+		free(first_words);
+		free(counts);
+		return NOK;
+	}
+
+	MPI_Allgather(info, 3, MPI_UINT64_T, all_info, 3, MPI_UINT64_T, comm);
+
+	uint64_t total = 0;
+	uint64_t max   = 0;
+
+	for (int r = 0; r < size; r++)
+	{
+		uint64_t n = all_info[3 * r + 2];
+
+		total += n;
+		max = n > max ? n : max;
+	}
+
+	oknok_t status = OK;
+
+	// Balanced enough
+	if (total == 0 || max * size * 100 <= total * (100 + REBALANCE_TOLERANCE))
+	{
+		goto done;
+	}
+
+	// Uncovered lines of the busiest process above the average
+	uint64_t excess = max - total / size;
+
+	// Not worth calculating the totals of all the new lines again
+	if (excess < REBALANCE_MIN_LINES
+		|| excess * REBALANCE_ROUNDS <= dm->n_matrix_lines / size)
+	{
+		goto done;
+	}
+
+	status = split_uncovered_lines(comm, dm, *covered_lines, total, size,
+								   first_words);
+	if (status != OK)
+	{
+		goto done;
+	}
+
+	int* send_counts = counts;
+	int* send_displs = counts + size;
+	int* recv_counts = counts + 2 * size;
+	int* recv_displs = counts + 3 * size;
+
+	uint64_t old_first = info[0];
+	uint64_t old_end   = info[0] + info[1];
+	uint64_t new_first = first_words[rank];
+	uint64_t new_end   = first_words[rank + 1];
+
+	for (int r = 0; r < size; r++)
+	{
+		uint64_t start;
+
+		// My old words that are now in process r
+		send_counts[r] = (int) get_overlap(old_first, old_end, first_words[r],
+										   first_words[r + 1], &start);
+		send_displs[r] = send_counts[r] > 0 ? (int) (start - old_first) : 0;
+
+		// The old words of process r that are now mine
+		uint64_t r_first = all_info[3 * r];
+		uint64_t r_end	 = r_first + all_info[3 * r + 1];
+
+		recv_counts[r] = (int) get_overlap(r_first, r_end, new_first, new_end,
+										   &start);
+		recv_displs[r] = recv_counts[r] > 0 ? (int) (start - new_first) : 0;
+	}
+
+	uint64_t n_words = new_end - new_first;
+
+	word_t* new_covered_lines = (word_t*) calloc(n_words + 1, sizeof(word_t));
+	word_t* new_best_column	  = (word_t*) calloc(n_words + 1, sizeof(word_t));
+
+	if (new_covered_lines == NULL || new_best_column == NULL)
+	{
+		free(new_covered_lines);
+		free(new_best_column);
+		status = NOK;
+		goto done;
+	}
+
+	MPI_Alltoallv(*covered_lines, send_counts, send_displs, MPI_UINT64_T,
+				  new_covered_lines, recv_counts, recv_displs, MPI_UINT64_T,
+				  comm);
+
+	free(*covered_lines);
+	free(*best_column);
+
+	*covered_lines = new_covered_lines;
+	*best_column   = new_best_column;
+
+	status = set_dm_words(dataset, new_first, n_words, dm);
+
+	*rebalanced = true;
+
+done:
+	free(all_info);
+	free(first_words);
+	free(counts);
+
+	return status;
+}
@@ -0,0 +1,72 @@
+/*
+ ============================================================================
+ Name        : disjoint_matrix_balance.h
+ Author      : Eduardo Ribeiro
+ Description : Moves disjoint matrix lines between processes, to keep the
+			   same number of uncovered lines in each one
+ ============================================================================
+ */
+
+#ifndef DISJOINT_MATRIX_BALANCE_H
+#define DISJOINT_MATRIX_BALANCE_H
+
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include "mpi.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * The lines are moved when a process has more than
+ * (100 + REBALANCE_TOLERANCE)% of the average number of uncovered lines
+ */
+#define REBALANCE_TOLERANCE 25
+
+/**
+ * The lines are checked every REBALANCE_ROUNDS rounds, so the other rounds
+ * don't gather the uncovered lines of every process
+ */
+#define REBALANCE_ROUNDS 8
+
+/**
+ * The lines aren't moved if the busiest process has fewer than
+ * REBALANCE_MIN_LINES uncovered lines above the average
+ */
+#define REBALANCE_MIN_LINES 4096
+
+/**
+ * Number of chunks of each process used to find the new lines of every
+ * process
+ */
+#define REBALANCE_CHUNKS 256
+
+/**
+ * Returns the number of lines not covered in covered_lines
+ */
+uint64_t get_n_uncovered_lines(const dm_t* dm, const word_t* covered_lines);
+
+/**
+ * Every REBALANCE_ROUNDS rounds, checks the number of uncovered lines of all
+ * processes and, if they are not balanced, splits the uncovered lines evenly
+ * between them.
+ * Moving the lines drops the worklists and the stored lines, and the totals
+ * are calculated again over all the new lines. So the lines are only moved
+ * if the extra lines of the busiest process, over the rounds until the next
+ * check, are more than the average lines of a process.
+ * The processes keep their lines in order and every range starts on a word
+ * of the full columns, so only covered lines words are sent.
+ *
+ * covered_lines and best_column are replaced by arrays for the new lines,
+ * and rebalanced is set to true. The attribute totals of the new lines have
+ * to be calculated again.
+ */
+oknok_t rebalance_dm(MPI_Comm comm, const dataset_t* dataset, dm_t* dm,
+					 const uint64_t round, const uint64_t n_uncovered_lines,
+					 word_t** covered_lines, word_t** best_column,
+					 bool* rebalanced);
+
+#endif // DISJOINT_MATRIX_BALANCE_H
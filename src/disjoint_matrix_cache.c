@@ -0,0 +1,323 @@
+/*
+ ============================================================================
+ Name        : disjoint_matrix_cache.c
+ Author      : Eduardo Ribeiro
+ Description : Stores the disjoint matrix lines of one process in memory,
+			   one column for each attribute
+ ============================================================================
+ */
+
+#include "disjoint_matrix_cache.h"
+
+#include "disjoint_matrix_mpi.h"
+#include "set_cover.h"
+#include "types/dataset_t.h"
+#include "types/dm_segment_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/bit.h"
+#include "xor_kernels.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+uint64_t get_dm_cache_size(const dataset_t* dataset, const dm_t* dm)
+{
+	return dataset->n_attributes * dm->n_words_in_a_column * sizeof(word_t);
+}
+
+/**
+ * Number of tiles stored at once. Each column gets N_CACHE_TILES consecutive
+ * words, instead of scattering one word to every column for each tile
+ */
+#define N_CACHE_TILES 8
+
+/**
+ * Number of lines stored at once
+ */
+#define CACHE_BLOCK_LINES (N_CACHE_TILES * TILE_LINES)
+
+/**
+ * Transposes the tiles of lines for each word of the lines, and stores the
+ * rows in the columns of the attributes, starting at column_word
+ */
+static void store_tiles(const dataset_t* dataset, const dm_t* dm,
+						const word_t* const* la, const word_t* const* lb,
+						const uint64_t n_lines, const uint64_t column_word,
+						word_t* cache)
+{
+	word_t tiles[N_CACHE_TILES][TILE_LINES];
+
+	uint64_t n_tiles = n_lines / TILE_LINES + (n_lines % TILE_LINES != 0);
+
+	for (uint64_t w = 0; w < dataset->n_words; w++)
+	{
+		for (uint64_t t = 0; t < n_tiles; t++)
+		{
+			uint64_t first = t * TILE_LINES;
+			uint64_t n	   = n_lines - first;
+			if (n > TILE_LINES)
+			{
+				n = TILE_LINES;
+			}
+
+			for (uint64_t i = 0; i < n; i++)
+			{
+				tiles[t][i] = la[first + i][w] ^ lb[first + i][w];
+			}
+
+			// Clear lines that were not filled
+			if (n < TILE_LINES)
+			{
+				memset(tiles[t] + n, 0, (TILE_LINES - n) * sizeof(word_t));
+			}
+
+			transpose64(tiles[t]);
+		}
+
+		// Row i has the bits of attribute w * WORD_BITS + i
+		uint64_t n_rows = dataset->n_attributes - w * WORD_BITS;
+		if (n_rows > WORD_BITS)
+		{
+			n_rows = WORD_BITS;
+		}
+
+		for (uint64_t i = 0; i < n_rows; i++)
+		{
+			word_t* column = cache
+				+ (w * WORD_BITS + i) * dm->n_words_in_a_column + column_word;
+
+			for (uint64_t t = 0; t < n_tiles; t++)
+			{
+				column[t] = tiles[t][i];
+			}
+		}
+	}
+}
+
+/**
+ * Generates the lines of one part of the matrix. The part starts at word
+ * first_word of the columns
+ */
+static void build_dm_cache_part(const dataset_t* dataset, const dm_t* dm,
+								const dm_t* part, const uint64_t first_word,
+								word_t* cache)
+{
+	uint64_t stride = dataset->line_stride;
+	word_t** opc	= dataset->observations_per_class;
+
+	/**
+	 * The lines of the current block. Each tile of the block fills one word
+	 * of the columns
+	 */
+	const word_t* block_la[CACHE_BLOCK_LINES];
+	const word_t* block_lb[CACHE_BLOCK_LINES];
+
+	uint64_t n_lines = 0;
+
+	dm_segment_t segment;
+
+	for (bool more = first_dm_segment(dataset, part, &segment); more;
+		 more = next_dm_segment(dataset, part, &segment))
+	{
+		word_t* la = opc[segment.classA] + segment.indexA * stride;
+		word_t* lb = opc[segment.classB] + segment.indexB * stride;
+
+		for (uint64_t i = 0; i < segment.n_lines; i++, lb += stride)
+		{
+			block_la[n_lines] = la;
+			block_lb[n_lines] = lb;
+			n_lines++;
+
+			if (n_lines == CACHE_BLOCK_LINES)
+			{
+				store_tiles(dataset, dm, block_la, block_lb, n_lines,
+							first_word
+								+ (segment.line + i + 1 - n_lines) / WORD_BITS,
+							cache);
+				n_lines = 0;
+			}
+		}
+	}
+
+	if (n_lines > 0)
+	{
+		store_tiles(dataset, dm, block_la, block_lb, n_lines,
+					first_word + (part->s_size - n_lines) / WORD_BITS, cache);
+	}
+}
+
+oknok_t build_dm_cache(const dataset_t* dataset, const dm_threads_t* threads,
+					   const dm_t* dm, word_t* cache)
+{
+	uint64_t n_threads = threads->n_threads;
+
+#pragma omp parallel for num_threads(n_threads) schedule(static, 1)
+	for (uint64_t t = 0; t < n_threads; t++)
+	{
+		const dm_t* part = threads->dms + t;
+
+		build_dm_cache_part(dataset, dm, part,
+							(part->s_offset - dm->s_offset) / WORD_BITS,
+							cache);
+	}
+
+	return OK;
+}
+
+oknok_t calculate_initial_attribute_totals_cached(const dataset_t* dataset,
+												  const dm_t* dm,
+												  const uint64_t n_threads,
+												  const word_t* cache,
+												  uint64_t* totals)
+{
+	uint64_t n_words = dm->n_words_in_a_column;
+
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+	for (uint64_t a = 0; a < dataset->n_attributes; a++)
+	{
+		const word_t* column = cache + a * n_words;
+
+		uint64_t total = 0;
+		for (uint64_t w = 0; w < n_words; w++)
+		{
+			total += __builtin_popcountll(column[w]);
+		}
+
+		totals[a] = total;
+	}
+
+	return OK;
+}
+
+/**
+ * Returns the number of words with lines not yet covered, and stores their
+ * indexes in live_words
+ */
+static uint64_t get_live_words(const dm_t* dm, const word_t* covered_lines,
+							   uint64_t* live_words)
+{
+	uint64_t n_live = 0;
+
+	for (uint64_t w = 0; w < dm->n_words_in_a_column; w++)
+	{
+		if (~covered_lines[w] != 0)
+		{
+			live_words[n_live++] = w;
+		}
+	}
+
+	return n_live;
+}
+
+oknok_t calculate_attribute_totals_add_cached(const dataset_t* dataset,
+											  const dm_t* dm,
+											  const uint64_t n_threads,
+											  const word_t* cache,
+											  const word_t* covered_lines,
+											  uint64_t* totals)
+{
+	uint64_t n_words = dm->n_words_in_a_column;
+
+	/**
+	 * Only the words with uncovered lines are read
+	 */
+	uint64_t* live_words = (uint64_t*) malloc(n_words * sizeof(uint64_t));
+	if (live_words == NULL)
+	{
+		return NOK;
+	}
+
+	uint64_t n_live = get_live_words(dm, covered_lines, live_words);
+
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+	for (uint64_t a = 0; a < dataset->n_attributes; a++)
+	{
+		// The attributes of the dead words cover no uncovered lines
+		if (!is_live_attribute_word(dm, a / WORD_BITS))
+		{
+			totals[a] = 0;
+			continue;
+		}
+
+		const word_t* column = cache + a * n_words;
+
+		uint64_t total = 0;
+		for (uint64_t i = 0; i < n_live; i++)
+		{
+			uint64_t w = live_words[i];
+			total += __builtin_popcountll(column[w] & ~covered_lines[w]);
+		}
+
+		totals[a] = total;
+	}
+
+	free(live_words);
+
+	return OK;
+}
+
+oknok_t calculate_attribute_totals_sub_cached(const dataset_t* dataset,
+											  const dm_t* dm,
+											  const uint64_t n_threads,
+											  const word_t* cache,
+											  const word_t* covered_lines,
+											  uint64_t* totals)
+{
+	uint64_t n_words = dm->n_words_in_a_column;
+
+	/**
+	 * Only the words with lines to remove are read
+	 */
+	uint64_t* set_words = (uint64_t*) malloc(n_words * sizeof(uint64_t));
+	if (set_words == NULL)
+	{
+		return NOK;
+	}
+
+	uint64_t n_set = 0;
+	for (uint64_t w = 0; w < n_words; w++)
+	{
+		if (covered_lines[w] != 0)
+		{
+			set_words[n_set++] = w;
+		}
+	}
+
+#pragma omp parallel for num_threads(n_threads) schedule(static)
+	for (uint64_t a = 0; a < dataset->n_attributes; a++)
+	{
+		if (!is_live_attribute_word(dm, a / WORD_BITS))
+		{
+			continue;
+		}
+
+		const word_t* column = cache + a * n_words;
+
+		uint64_t total = 0;
+		for (uint64_t i = 0; i < n_set; i++)
+		{
+			uint64_t w = set_words[i];
+			total += __builtin_popcountll(column[w] & covered_lines[w]);
+		}
+
+		totals[a] -= total;
+	}
+
+	free(set_words);
+
+	return OK;
+}
+
+oknok_t get_column_cached(const dm_t* dm, const word_t* cache,
+						  const int64_t attribute, word_t* column)
+{
+	memcpy(column, cache + attribute * dm->n_words_in_a_column,
+		   dm->n_words_in_a_column * sizeof(word_t));
+
+	return OK;
+}
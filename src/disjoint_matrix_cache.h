@@ -0,0 +1,76 @@
+/*
+ ============================================================================
+ Name        : disjoint_matrix_cache.h
+ Author      : Eduardo Ribeiro
+ Description : Stores the disjoint matrix lines of one process in memory,
+			   one column for each attribute
+ ============================================================================
+ */
+
+#ifndef DISJOINT_MATRIX_CACHE_H
+#define DISJOINT_MATRIX_CACHE_H
+
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include <stdint.h>
+
+/**
+ * Returns the memory (in bytes) needed to store the disjoint matrix lines of
+ * this process
+ */
+uint64_t get_dm_cache_size(const dataset_t* dataset, const dm_t* dm);
+
+/**
+ * Generates the disjoint matrix lines of this process and stores them in
+ * cache. Column a is stored in cache + a * dm->n_words_in_a_column, with the
+ * same layout as the columns returned by get_column.
+ * Each thread generates the lines of its part
+ */
+oknok_t build_dm_cache(const dataset_t* dataset, const dm_threads_t* threads,
+					   const dm_t* dm, word_t* cache);
+
+/**
+ * These functions have the same behaviour as the ones in set_cover.h and
+ * disjoint_matrix_mpi.h, but read the stored columns.
+ */
+
+/**
+ * Calculates the initial attributes totals with n_threads threads
+ */
+oknok_t calculate_initial_attribute_totals_cached(const dataset_t* dataset,
+												  const dm_t* dm,
+												  const uint64_t n_threads,
+												  const word_t* cache,
+												  uint64_t* totals);
+
+/**
+ * Calculates the attributes totals for the lines not yet covered
+ */
+oknok_t calculate_attribute_totals_add_cached(const dataset_t* dataset,
+											  const dm_t* dm,
+											  const uint64_t n_threads,
+											  const word_t* cache,
+											  const word_t* covered_lines,
+											  uint64_t* totals);
+
+/**
+ * Removes from the attributes totals the lines set in covered_lines
+ */
+oknok_t calculate_attribute_totals_sub_cached(const dataset_t* dataset,
+											  const dm_t* dm,
+											  const uint64_t n_threads,
+											  const word_t* cache,
+											  const word_t* covered_lines,
+											  uint64_t* totals);
+
+/**
+ * Copies the column of attribute
+ */
+oknok_t get_column_cached(const dm_t* dm, const word_t* cache,
+						  const int64_t attribute, word_t* column);
+
+#endif // DISJOINT_MATRIX_CACHE_H
@@ -7,18 +7,439 @@
  */
 
 #include "disjoint_matrix_mpi.h"
+#include "dataset_mmap.h"
+#include "dataset_transposed.h"
 #include "types/dataset_t.h"
+#include "types/dm_segment_t.h"
 #include "types/dm_t.h"
 #include "types/oknok_t.h"
 #include "types/word_t.h"
 #include "utils/bit.h"
+#include "xor_kernels.h"
 
+#include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
+oknok_t set_dm_words(const dataset_t* dataset, const uint64_t first_word,
+					 const uint64_t n_words, dm_t* dm)
+{
+	uint64_t first_line = first_word * WORD_BITS;
+	uint64_t end_line	= (first_word + n_words) * WORD_BITS;
+
+	if (end_line > dm->n_matrix_lines)
+	{
+		end_line = dm->n_matrix_lines;
+	}
+
+	dm->n_words_in_a_column = n_words;
+	dm->s_offset			= first_line;
+	dm->s_size				= first_line < end_line ? end_line - first_line : 0;
+
+	// All the lines are visited
+	dm->segments		= NULL;
+	dm->n_segments		= 0;
+	dm->n_segment_lines = 0;
+
+	dm->live_attribute_words = NULL;
+
+	// The lines split in blocks are not in the order of the dense loops
+	dm->dense_2_classes
+		= dataset->n_classes == 2 && dataset->n_block_observations == 0;
+
+	if (dm->s_size == 0)
+	{
+		return OK;
+	}
+
+	return calculate_class_offsets(dataset, dm->s_offset,
+								   &dm->initial_class_offsets);
+}
+
+/**
+ * Sets the number of lines of segment, that ends on the last observation of
+ * class B, of its chunk if the lines are split in blocks, or on the last line
+ * of dm
+ */
+static void set_segment_lines(const dataset_t* dataset, const dm_t* dm,
+							  dm_segment_t* segment)
+{
+	uint64_t end_b = dataset->n_observations_per_class[segment->classB];
+
+	if (dataset->n_block_observations > 0)
+	{
+		uint64_t nco	   = dataset->n_chunk_observations;
+		uint64_t end_chunk = segment->indexB - segment->indexB % nco + nco;
+
+		if (end_chunk < end_b)
+		{
+			end_b = end_chunk;
+		}
+	}
+
+	segment->n_lines = end_b - segment->indexB;
+
+	if (segment->n_lines > dm->s_size - segment->line)
+	{
+		segment->n_lines = dm->s_size - segment->line;
+	}
+}
+
+/**
+ * Prefetches the group of size observations of class c that has observation
+ * index
+ */
+static void prefetch_observations(const dataset_t* dataset, const uint64_t c,
+								  const uint64_t index, const uint64_t size)
+{
+	uint64_t first = index - index % size;
+	uint64_t n_obs = dataset->n_observations_per_class[c] - first;
+
+	if (n_obs > size)
+	{
+		n_obs = size;
+	}
+
+	prefetch_dataset_lines(dataset->observations_per_class[c]
+							   + first * dataset->line_stride,
+						   n_obs * dataset->line_stride);
+}
+
+/**
+ * Releases the observations of class c that are not in the group of size
+ * observations that has observation index, or all of them if size is 0.
+ * A page that is used maps the pages read ahead with it, so the pages of the
+ * groups before it may be in memory again after they were released
+ */
+static void release_observations(const dataset_t* dataset, const uint64_t c,
+								 const uint64_t index, const uint64_t size)
+{
+	uint64_t n_obs	= dataset->n_observations_per_class[c];
+	uint64_t stride = dataset->line_stride;
+
+	uint64_t first = 0;
+	uint64_t end   = 0;
+
+	if (size > 0)
+	{
+		first = index - index % size;
+		end	  = first + size < n_obs ? first + size : n_obs;
+	}
+
+	const word_t* lines = dataset->observations_per_class[c];
+
+	release_dataset_lines(lines, first * stride);
+	release_dataset_lines(lines + end * stride, (n_obs - end) * stride);
+}
+
+/**
+ * Prefetches the block and the chunk of segment, with the chunk after it,
+ * if they are not the ones of previous, and releases the other lines of the
+ * classes of previous. previous is NULL for the first segment
+ */
+static void stream_dm_segment(const dataset_t* dataset,
+							  const dm_segment_t* previous,
+							  const dm_segment_t* segment)
+{
+	uint64_t nbo = dataset->n_block_observations;
+	uint64_t nco = dataset->n_chunk_observations;
+
+	if (previous == NULL || previous->classA != segment->classA
+		|| previous->indexA / nbo != segment->indexA / nbo)
+	{
+		if (previous != NULL)
+		{
+			release_observations(dataset, previous->classA, segment->indexA,
+								 previous->classA == segment->classA ? nbo
+																	 : 0);
+		}
+
+		prefetch_observations(dataset, segment->classA, segment->indexA, nbo);
+	}
+
+	if (previous == NULL || previous->classB != segment->classB
+		|| previous->indexB / nco != segment->indexB / nco)
+	{
+		if (previous != NULL)
+		{
+			release_observations(dataset, previous->classB, segment->indexB,
+								 previous->classB == segment->classB ? nco
+																	 : 0);
+		}
+
+		prefetch_observations(dataset, segment->classB, segment->indexB, nco);
+
+		// The next chunk is read from the file while this one is used
+		uint64_t next = segment->indexB - segment->indexB % nco + nco;
+
+		if (next < dataset->n_observations_per_class[segment->classB])
+		{
+			prefetch_observations(dataset, segment->classB, next, nco);
+		}
+	}
+}
+
+/**
+ * Moves segment to the next segment when the lines are split in blocks: the
+ * next observation of class A of the block, with the same chunk of class B,
+ * or the next chunk, class B, block or class A
+ */
+static void next_blocked_segment(const dataset_t* dataset,
+								 dm_segment_t* segment)
+{
+	uint64_t nc	   = dataset->n_classes;
+	uint64_t* nopc = dataset->n_observations_per_class;
+	uint64_t nbo   = dataset->n_block_observations;
+	uint64_t nco   = dataset->n_chunk_observations;
+
+	uint64_t first_a = segment->indexA - segment->indexA % nbo;
+	uint64_t end_a	 = first_a + nbo;
+
+	if (end_a > nopc[segment->classA])
+	{
+		end_a = nopc[segment->classA];
+	}
+
+	uint64_t first_b = segment->indexB - segment->indexB % nco;
+
+	if (segment->indexA + 1 < end_a)
+	{
+		segment->indexA++;
+		segment->indexB = first_b;
+		return;
+	}
+
+	segment->indexA = first_a;
+
+	if (first_b + nco < nopc[segment->classB])
+	{
+		segment->indexB = first_b + nco;
+		return;
+	}
+
+	segment->indexB = 0;
+
+	// The next class B with observations, for the same block
+	do
+	{
+		segment->classB++;
+	} while (segment->classB < nc && nopc[segment->classB] == 0);
+
+	if (segment->classB < nc)
+	{
+		return;
+	}
+
+	if (end_a < nopc[segment->classA])
+	{
+		segment->indexA = end_a;
+	}
+	else
+	{
+		// There are more lines, so there is a class A with observations
+		// and some class B after it
+		do
+		{
+			segment->classA++;
+		} while (nopc[segment->classA] == 0);
+
+		segment->indexA = 0;
+	}
+
+	segment->classB = segment->classA + 1;
+
+	while (nopc[segment->classB] == 0)
+	{
+		segment->classB++;
+	}
+}
+
+bool first_dm_segment(const dataset_t* dataset, const dm_t* dm,
+					  dm_segment_t* segment)
+{
+	if (dm->segments != NULL)
+	{
+		if (dm->n_segments == 0)
+		{
+			return false;
+		}
+
+		*segment = dm->segments[0];
+	}
+	else if (dm->s_size == 0)
+	{
+		return false;
+	}
+	else
+	{
+		segment->classA = dm->initial_class_offsets.classA;
+		segment->indexA = dm->initial_class_offsets.indexA;
+		segment->classB = dm->initial_class_offsets.classB;
+		segment->indexB = dm->initial_class_offsets.indexB;
+		segment->line	= 0;
+		segment->index	= 0;
+
+		set_segment_lines(dataset, dm, segment);
+	}
+
+	if (dataset->n_block_observations > 0)
+	{
+		stream_dm_segment(dataset, NULL, segment);
+	}
+
+	return true;
+}
+
+bool next_dm_segment(const dataset_t* dataset, const dm_t* dm,
+					 dm_segment_t* segment)
+{
+	uint64_t nc	   = dataset->n_classes;
+	uint64_t* nopc = dataset->n_observations_per_class;
+
+	if (dm->segments != NULL)
+	{
+		if (segment->index + 1 >= dm->n_segments)
+		{
+			return false;
+		}
+
+		if (dataset->n_block_observations > 0)
+		{
+			stream_dm_segment(dataset, segment,
+							  dm->segments + segment->index + 1);
+		}
+
+		*segment = dm->segments[segment->index + 1];
+		return true;
+	}
+
+	segment->line += segment->n_lines;
+
+	if (segment->line >= dm->s_size)
+	{
+		return false;
+	}
+
+	if (dataset->n_block_observations > 0)
+	{
+		dm_segment_t previous = *segment;
+
+		next_blocked_segment(dataset, segment);
+		set_segment_lines(dataset, dm, segment);
+
+		stream_dm_segment(dataset, &previous, segment);
+
+		return true;
+	}
+
+	if (nc == 2)
+	{
+		// Every row of class 0 is one segment with all the observations of
+		// class 1, like the closed form of calculate_class_offsets
+		segment->indexA++;
+		segment->indexB = 0;
+
+		set_segment_lines(dataset, dm, segment);
+
+		return true;
+	}
+
+	// The next class B with observations, on this or the next rows
+	do
+	{
+		segment->classB++;
+
+		if (segment->classB == nc)
+		{
+			segment->indexA++;
+
+			while (segment->indexA == nopc[segment->classA])
+			{
+				segment->classA++;
+				segment->indexA = 0;
+			}
+
+			segment->classB = segment->classA + 1;
+		}
+	} while (nopc[segment->classB] == 0);
+
+	segment->indexB = 0;
+
+	set_segment_lines(dataset, dm, segment);
+
+	return true;
+}
+
+bool is_dense_dm(const dm_t* dm)
+{
+	return dm->dense_2_classes && dm->segments == NULL;
+}
+
+/**
+ * get_column for the dense 2-class lines
+ */
+static void get_dense_column(const dataset_t* dataset, const dm_t* dm,
+							 const uint64_t attribute_word,
+							 const uint8_t attribute_bit, word_t* column)
+{
+	uint64_t stride	 = dataset->line_stride;
+	uint64_t n_obs_b = dataset->n_observations_per_class[1];
+
+	const xor_kernels_t* kernels = get_xor_kernels();
+
+	const word_t* tile_la[TILE_LINES];
+	const word_t* tile_lb[TILE_LINES];
+
+	uint64_t n_lines   = 0;
+	uint64_t tile_word = 0;
+
+	const word_t* la = dataset->observations_per_class[0]
+		+ dm->initial_class_offsets.indexA * stride;
+	uint64_t ib = dm->initial_class_offsets.indexB;
+
+	for (uint64_t line = 0; line < dm->s_size; la += stride, ib = 0)
+	{
+		// The observations of class 1 on this row of class 0
+		uint64_t n = n_obs_b - ib;
+		if (n > dm->s_size - line)
+		{
+			n = dm->s_size - line;
+		}
+
+		const word_t* lb = dataset->observations_per_class[1] + ib * stride;
+
+		for (uint64_t i = 0; i < n; i++, lb += stride)
+		{
+			tile_la[n_lines] = la;
+			tile_lb[n_lines] = lb;
+			n_lines++;
+
+			if (n_lines == TILE_LINES)
+			{
+				column[tile_word++] = kernels->column_bits(
+					tile_la, tile_lb, attribute_word, attribute_bit, n_lines);
+				n_lines = 0;
+			}
+		}
+
+		line += n;
+	}
+
+	if (n_lines > 0)
+	{
+		column[tile_word] = kernels->column_bits(
+			tile_la, tile_lb, attribute_word, attribute_bit, n_lines);
+	}
+}
+
 oknok_t get_column(const dataset_t* dataset, const dm_t* dm,
 				   const int64_t attribute, word_t* column)
 {
+	if (dataset->columns_per_class != NULL)
+	{
+		return get_column_transposed(dataset, dm, attribute, column);
+	}
 
 	// Which word has the index attribute
 	uint64_t attribute_word = attribute / WORD_BITS;
@@ -26,69 +447,205 @@ oknok_t get_column(const dataset_t* dataset, const dm_t* dm,
 	// Which bit?
 	uint8_t attribute_bit = WORD_BITS - (attribute % WORD_BITS) - 1;
 
-	// Reset best_column
-	memset(column, 0, dm->n_words_in_a_column * sizeof(word_t));
+	if (is_dense_dm(dm))
+	{
+		get_dense_column(dataset, dm, attribute_word, attribute_bit, column);
+		return OK;
+	}
+
+	uint64_t stride = dataset->line_stride;
+	word_t** opc	= dataset->observations_per_class;
+
+	const xor_kernels_t* kernels = get_xor_kernels();
+
+	/**
+	 * The lines of the current tile. Each tile fills one word of the column
+	 */
+	const word_t* tile_la[TILE_LINES];
+	const word_t* tile_lb[TILE_LINES];
+
+	uint64_t n_lines = 0;
+
+	/**
+	 * Word of the column of the current tile
+	 */
+	uint64_t tile_word = 0;
+
+	// The words without lines in the worklist are not visited
+	if (dm->segments != NULL)
+	{
+		memset(column, 0, dm->n_words_in_a_column * sizeof(word_t));
+	}
+
+	dm_segment_t segment;
+
+	for (bool more = first_dm_segment(dataset, dm, &segment); more;
+		 more = next_dm_segment(dataset, dm, &segment))
+	{
+		word_t* la = opc[segment.classA] + segment.indexA * stride;
+		word_t* lb = opc[segment.classB] + segment.indexB * stride;
+
+		for (uint64_t i = 0; i < segment.n_lines; i++, lb += stride)
+		{
+			uint64_t cl = segment.line + i;
+
+			// The worklist may skip the rest of the tile
+			if (n_lines > 0 && cl / WORD_BITS != tile_word)
+			{
+				column[tile_word] = kernels->column_bits(
+					tile_la, tile_lb, attribute_word, attribute_bit, n_lines);
+				n_lines = 0;
+			}
+
+			tile_word = cl / WORD_BITS;
+
+			// And the lines before cl, which XOR to 0
+			while (n_lines < cl % WORD_BITS)
+			{
+				tile_la[n_lines] = la;
+				tile_lb[n_lines] = la;
+				n_lines++;
+			}
+
+			tile_la[n_lines] = la;
+			tile_lb[n_lines] = lb;
+			n_lines++;
 
+			if (n_lines == TILE_LINES)
+			{
+				column[tile_word] = kernels->column_bits(
+					tile_la, tile_lb, attribute_word, attribute_bit, n_lines);
+				n_lines = 0;
+			}
+		}
+	}
+
+	if (n_lines > 0)
+	{
+		column[tile_word] = kernels->column_bits(
+			tile_la, tile_lb, attribute_word, attribute_bit, n_lines);
+	}
+
+	return OK;
+}
+
+void set_dm_blocks(dataset_t* dataset, const uint64_t max_memory)
+{
+	uint64_t line_size = dataset->line_stride * sizeof(word_t);
+
+	// Half of the memory for the block and a quarter for each chunk
+	uint64_t nbo = max_memory / 2 / line_size;
+	uint64_t nco = max_memory / 4 / line_size;
+
+	// No block or chunk is bigger than the dataset
+	if (nbo > dataset->n_observations)
+	{
+		nbo = dataset->n_observations;
+	}
+
+	if (nco > dataset->n_observations)
+	{
+		nco = dataset->n_observations;
+	}
+
+	dataset->n_block_observations = nbo > 0 ? nbo : 1;
+	dataset->n_chunk_observations = nco > 0 ? nco : 1;
+}
+
+/**
+ * calculate_class_offsets when the lines are split in blocks. The lines of
+ * class A are the blocks of its observations, all but the last one with
+ * n_block_observations observations. The lines of a block are the lines of
+ * each class B after class A, and the lines of each class B are the chunks of
+ * its observations, with one line for each observation of the block and each
+ * observation of the chunk
+ */
+static oknok_t calculate_blocked_class_offsets(const dataset_t* dataset,
+											   const uint64_t line,
+											   class_offsets_t* class_offsets)
+{
 	uint64_t nc	   = dataset->n_classes;
-	uint64_t nobs  = dataset->n_observations;
-	word_t** opc   = dataset->observations_per_class;
 	uint64_t* nopc = dataset->n_observations_per_class;
+	uint64_t nbo   = dataset->n_block_observations;
+	uint64_t nco   = dataset->n_chunk_observations;
 
-	uint64_t ca = dm->initial_class_offsets.classA;
-	uint64_t ia = dm->initial_class_offsets.indexA;
-	uint64_t cb = dm->initial_class_offsets.classB;
-	uint64_t ib = dm->initial_class_offsets.indexB;
+	/**
+	 * Number of observations in the classes after ca
+	 */
+	uint64_t n_obs_after = 0;
+	for (uint64_t c = 1; c < nc; c++)
+	{
+		n_obs_after += nopc[c];
+	}
 
-	uint64_t cl = 0;
+	/**
+	 * Line number relative to the start of the current block
+	 */
+	uint64_t cl = line;
 
-	while (ca < nc - 1)
+	for (uint64_t ca = 0; ca < nc - 1; ca++)
 	{
-		while (ia < nopc[ca])
+		// Number of lines of classA
+		uint64_t n_lines_ca = nopc[ca] * n_obs_after;
+
+		if (cl < n_lines_ca)
 		{
-			while (cb < nc)
+			// The blocks before the one of the line are full
+			uint64_t first_a = cl / (nbo * n_obs_after) * nbo;
+			uint64_t n_obs_a = nopc[ca] - first_a;
+
+			if (n_obs_a > nbo)
+			{
+				n_obs_a = nbo;
+			}
+
+			cl -= first_a * n_obs_after;
+
+			for (uint64_t cb = ca + 1; cb < nc; cb++)
 			{
-				while (ib < nopc[cb])
+				// Number of lines of the block with classB
+				uint64_t n_lines_cb = n_obs_a * nopc[cb];
+
+				if (cl < n_lines_cb)
 				{
-					if (cl == dm->s_size)
+					// And so are the chunks before the one of the line
+					uint64_t first_b = cl / (n_obs_a * nco) * nco;
+					uint64_t n_obs_b = nopc[cb] - first_b;
+
+					if (n_obs_b > nco)
 					{
-						return OK;
+						n_obs_b = nco;
 					}
 
-					word_t** bla = opc + ca * nobs;
-					word_t* la	 = *(bla + ia);
-					word_t** blb = opc + cb * nobs;
-					word_t* lb	 = *(blb + ib);
+					cl -= first_b * n_obs_a;
 
-					word_t lxor = la[attribute_word] ^ lb[attribute_word];
-					if (BIT_CHECK(lxor, attribute_bit))
-					{
-						uint64_t w = cl / WORD_BITS;
-						uint8_t b  = WORD_BITS - (cl % WORD_BITS) - 1;
+					class_offsets->classA = ca;
+					class_offsets->indexA = first_a + cl / n_obs_b;
+					class_offsets->classB = cb;
+					class_offsets->indexB = first_b + cl % n_obs_b;
 
-						BIT_SET(column[w], b);
-					}
-					ib++;
-					cl++;
+					return OK;
 				}
-				cb++;
-				ib = 0;
+
+				cl -= n_lines_cb;
 			}
-			ia++;
-			cb = ca + 1;
-			ib = 0;
 		}
-		ca++;
-		ia = 0;
-		cb = ca + 1;
-		ib = 0;
+
+		cl -= n_lines_ca;
+		n_obs_after -= nopc[ca + 1];
 	}
 
-	return OK;
+	return NOK;
 }
 
 oknok_t calculate_class_offsets(const dataset_t* dataset, const uint64_t line,
 								class_offsets_t* class_offsets)
 {
+	if (dataset->n_block_observations > 0)
+	{
+		return calculate_blocked_class_offsets(dataset, line, class_offsets);
+	}
+
 
 	/**
 	 * Number of classes in dataset
@@ -113,38 +670,62 @@ oknok_t calculate_class_offsets(const dataset_t* dataset, const uint64_t line,
 		class_offsets->indexA = line / nopc[1];
 		class_offsets->classB = 1;
 		class_offsets->indexB = line % nopc[1];
+
+		return line < nopc[0] * nopc[1] ? OK : NOK;
 	}
 	else
 	{
-		uint64_t cl = 0;
-		uint64_t ca = 0;
-		uint64_t ia = 0;
-		uint64_t cb = 0;
-		uint64_t ib = 0;
+		/**
+		 * The lines of classA are nopc[classA] blocks, one for each
+		 * observation of classA, with one line for each observation of the
+		 * classes after classA.
+		 * We only need the prefix sums of those blocks to find the line.
+		 */
 
-		// I still haven't found a better way for more than 2 classes...
-		// TODO: is there a better way?
-		for (ca = 0; ca < nc - 1; ca++)
+		/**
+		 * Number of observations in the classes after ca
+		 */
+		uint64_t n_obs_after = 0;
+		for (uint64_t c = 1; c < nc; c++)
 		{
-			for (ia = 0; ia < nopc[ca]; ia++)
+			n_obs_after += nopc[c];
+		}
+
+		/**
+		 * Line number relative to the start of the current block
+		 */
+		uint64_t cl = line;
+
+		for (uint64_t ca = 0; ca < nc - 1; ca++)
+		{
+			// Number of lines of classA
+			uint64_t n_lines_ca = nopc[ca] * n_obs_after;
+
+			if (cl < n_lines_ca)
 			{
-				for (cb = ca + 1; cb < nc; cb++)
+				class_offsets->classA = ca;
+				class_offsets->indexA = cl / n_obs_after;
+
+				// Line inside the block of indexA
+				cl %= n_obs_after;
+
+				for (uint64_t cb = ca + 1; cb < nc; cb++)
 				{
-					for (ib = 0; ib < nopc[cb]; ib++, cl++)
+					if (cl < nopc[cb])
 					{
-						if (cl == line)
-						{
-							// This process will start working from here
-							class_offsets->classA = ca;
-							class_offsets->indexA = ia;
-							class_offsets->classB = cb;
-							class_offsets->indexB = ib;
-
-							return OK;
-						}
+						// This process will start working from here
+						class_offsets->classB = cb;
+						class_offsets->indexB = cl;
+
+						return OK;
 					}
+
+					cl -= nopc[cb];
 				}
 			}
+
+			cl -= n_lines_ca;
+			n_obs_after -= nopc[ca + 1];
 		}
 	}
 
@@ -10,18 +10,74 @@
 #define MPI_DISJOINT_MATRIX_H
 
 #include "types/dataset_t.h"
+#include "types/dm_segment_t.h"
 #include "types/dm_t.h"
 #include "types/oknok_t.h"
 #include "types/word_t.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
+/**
+ * Sets the lines of dm to the ones of words [first_word, first_word +
+ * n_words) of the full matrix columns.
+ * The processes lines start on a word of the full columns, so they can move
+ * their covered lines words between them
+ */
+oknok_t set_dm_words(const dataset_t* dataset, const uint64_t first_word,
+					 const uint64_t n_words, dm_t* dm);
+
+/**
+ * Sets segment to the first segment of the lines of dm.
+ * Returns false if dm has no lines
+ */
+bool first_dm_segment(const dataset_t* dataset, const dm_t* dm,
+					  dm_segment_t* segment);
+
+/**
+ * Moves segment to the next segment of the lines of dm.
+ * Returns false after the last segment.
+ * The lines of dm are visited with:
+ *
+ *  for (bool more = first_dm_segment(dataset, dm, &segment); more;
+ *       more = next_dm_segment(dataset, dm, &segment))
+ */
+bool next_dm_segment(const dataset_t* dataset, const dm_t* dm,
+					 dm_segment_t* segment);
+
+/**
+ * Checks if the lines of dm are walked with the dense double loop of the
+ * 2-class datasets: from the initial offsets, each observation of class 0
+ * against the observations of class 1
+ */
+bool is_dense_dm(const dm_t* dm);
+
+/**
+ * Gets the column of attribute for the lines of dm.
+ * Uses the transposed dataset if there is one
+ */
 oknok_t get_column(const dataset_t* dataset, const dm_t* dm,
 				   const int64_t attribute, word_t* column);
 
+/**
+ * Splits the disjoint matrix lines of each class A in blocks of its
+ * observations, with the lines of each block split in chunks of the
+ * observations of each class B, so a block and two chunks of lines fit in
+ * max_memory bytes.
+ * The lines of a block are ordered by chunk, so each chunk is read once for
+ * the whole block instead of once for each observation of class A, and is
+ * streamed from the file when the dataset is mapped: while the lines of a
+ * chunk are used the next chunk is prefetched, and the other lines of the
+ * classes of the block and of the chunk are released.
+ * Every process must use the same blocks, as they set the line numbers
+ */
+void set_dm_blocks(dataset_t* dataset, const uint64_t max_memory);
+
 /**
  * Calculates the class offsets that correspond to the requested
- * line of the disjoint matrix
+ * line of the disjoint matrix.
+ * Uses the prefix sums of the number of lines per class, so it's O(n_classes)
+ * and can be used to seek to any line of the matrix
  */
 oknok_t calculate_class_offsets(const dataset_t* dataset, const uint64_t line,
 								class_offsets_t* class_offsets);
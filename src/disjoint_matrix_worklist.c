@@ -0,0 +1,170 @@
+/*
+ ============================================================================
+ Name        : disjoint_matrix_worklist.c
+ Author      : Eduardo Ribeiro
+ Description : Worklists with the uncovered disjoint matrix lines of each
+			   thread, so the covered lines are not visited again
+ ============================================================================
+ */
+
+#include "disjoint_matrix_worklist.h"
+
+#include "disjoint_matrix_mpi.h"
+#include "types/dataset_t.h"
+#include "types/dm_segment_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/**
+ * Returns the first line in [from, to) with the covered bit equal to
+ * covered, or to if there is none
+ */
+static uint64_t find_line(const word_t* covered_lines, uint64_t from,
+						  const uint64_t to, const bool covered)
+{
+	while (from < to)
+	{
+		uint64_t w = from / WORD_BITS;
+
+		word_t bits = covered ? covered_lines[w] : ~covered_lines[w];
+
+		// Line i of the word is bit WORD_BITS - 1 - i
+		bits &= ~0UL >> (from % WORD_BITS);
+
+		if (bits != 0)
+		{
+			uint64_t line = w * WORD_BITS + __builtin_clzll(bits);
+			return line < to ? line : to;
+		}
+
+		from = (w + 1) * WORD_BITS;
+	}
+
+	return to;
+}
+
+/**
+ * Splits the segments visited by dm in the runs of uncovered lines.
+ * The runs are stored in segments, if it's not NULL, and the number of runs
+ * is returned. n_lines is set to the number of uncovered lines
+ */
+static uint64_t find_uncovered_runs(const dataset_t* dataset, const dm_t* dm,
+									const word_t* covered_lines,
+									dm_segment_t* segments, uint64_t* n_lines)
+{
+	uint64_t n_runs = 0;
+	*n_lines		= 0;
+
+	dm_segment_t segment;
+
+	for (bool more = first_dm_segment(dataset, dm, &segment); more;
+		 more = next_dm_segment(dataset, dm, &segment))
+	{
+		uint64_t end  = segment.line + segment.n_lines;
+		uint64_t line = find_line(covered_lines, segment.line, end, false);
+
+		while (line < end)
+		{
+			uint64_t run_end = find_line(covered_lines, line, end, true);
+
+			if (segments != NULL)
+			{
+				dm_segment_t* run = segments + n_runs;
+
+				*run		 = segment;
+				run->indexB	 = segment.indexB + (line - segment.line);
+				run->line	 = line;
+				run->n_lines = run_end - line;
+				run->index	 = n_runs;
+			}
+
+			n_runs++;
+			*n_lines += run_end - line;
+
+			line = find_line(covered_lines, run_end, end, false);
+		}
+	}
+
+	return n_runs;
+}
+
+oknok_t compact_dm_worklists(const dataset_t* dataset, dm_threads_t* threads,
+							 const word_t* covered_lines,
+							 const uint64_t n_uncovered_lines)
+{
+	uint64_t n_threads = threads->n_threads;
+
+	// Number of lines visited by the threads
+	uint64_t n_visited = 0;
+
+	for (uint64_t t = 0; t < n_threads; t++)
+	{
+		const dm_t* part = threads->dms + t;
+
+		n_visited += part->segments == NULL ? part->s_size
+											: part->n_segment_lines;
+	}
+
+	if (n_uncovered_lines * WORKLIST_COMPACT_RATIO > n_visited)
+	{
+		return OK;
+	}
+
+	oknok_t status = OK;
+
+#pragma omp parallel for num_threads(n_threads) schedule(static, 1)
+	for (uint64_t t = 0; t < n_threads; t++)
+	{
+		dm_t* part = threads->dms + t;
+
+		// This part of the covered lines array
+		const word_t* tcl = covered_lines
+			+ (part->s_offset - threads->s_offset) / WORD_BITS;
+
+		uint64_t n_lines = 0;
+		uint64_t n_runs
+			= find_uncovered_runs(dataset, part, tcl, NULL, &n_lines);
+
+		// The worklist must be smaller than the covered lines of the part
+		if (n_runs * sizeof(dm_segment_t)
+			> part->n_words_in_a_column * sizeof(word_t))
+		{
+			continue;
+		}
+
+		// An empty worklist is not NULL, so no line is visited
+		dm_segment_t* segments = (dm_segment_t*) malloc(
+			(n_runs > 0 ? n_runs : 1) * sizeof(dm_segment_t));
+		if (segments == NULL)
+		{
+#pragma omp atomic write
+			status = NOK;
+			continue;
+		}
+
+		find_uncovered_runs(dataset, part, tcl, segments, &n_lines);
+
+		free_dm_worklist(part);
+
+		part->segments		  = segments;
+		part->n_segments	  = n_runs;
+		part->n_segment_lines = n_lines;
+	}
+
+	return status;
+}
+
+void free_dm_worklist(dm_t* dm)
+{
+	free(dm->segments);
+
+	dm->segments		= NULL;
+	dm->n_segments		= 0;
+	dm->n_segment_lines = 0;
+}
@@ -0,0 +1,43 @@
+/*
+ ============================================================================
+ Name        : disjoint_matrix_worklist.h
+ Author      : Eduardo Ribeiro
+ Description : Worklists with the uncovered disjoint matrix lines of each
+			   thread, so the covered lines are not visited again
+ ============================================================================
+ */
+
+#ifndef DISJOINT_MATRIX_WORKLIST_H
+#define DISJOINT_MATRIX_WORKLIST_H
+
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include <stdint.h>
+
+/**
+ * The worklists are compacted when the uncovered lines of a process are
+ * less than 1 / WORKLIST_COMPACT_RATIO of the lines they visit
+ */
+#define WORKLIST_COMPACT_RATIO 2
+
+/**
+ * Replaces the worklist of every thread by the segments of its lines that
+ * are not covered, if the process has few uncovered lines left.
+ * A worklist is only stored if it uses less memory than the covered lines
+ * of the thread, otherwise the thread keeps visiting its current lines.
+ * The first_dm_segment/next_dm_segment loops then skip the covered lines
+ */
+oknok_t compact_dm_worklists(const dataset_t* dataset, dm_threads_t* threads,
+							 const word_t* covered_lines,
+							 const uint64_t n_uncovered_lines);
+
+/**
+ * Frees the worklist of dm, so all its lines are visited again
+ */
+void free_dm_worklist(dm_t* dm);
+
+#endif // DISJOINT_MATRIX_WORKLIST_H
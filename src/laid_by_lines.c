@@ -6,23 +6,47 @@
  ============================================================================
  */
 
+#include "batch.h"
 #include "dataset.h"
 #include "dataset_hdf5.h"
+#include "dataset_mmap.h"
+#include "dataset_omp.h"
+#include "dataset_reduce.h"
+#include "dataset_shared.h"
+#include "dataset_transposed.h"
 #include "disjoint_matrix.h"
+#include "disjoint_matrix_balance.h"
+#include "disjoint_matrix_cache.h"
 #include "disjoint_matrix_mpi.h"
+#include "disjoint_matrix_worklist.h"
 #include "jnsq.h"
 #include "set_cover.h"
+#include "set_cover_checkpoint.h"
+#include "set_cover_lazy.h"
+#include "set_cover_offload.h"
+#include "set_cover_omp.h"
+#include "set_cover_reduce.h"
+#include "set_cover_stats.h"
+#include "types/attributes_map_t.h"
+#include "types/batch_t.h"
 #include "types/dataset_hdf5_t.h"
+#include "types/dataset_mmap_t.h"
 #include "types/dataset_t.h"
 #include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/lazy_heap_t.h"
+#include "types/offload_t.h"
+#include "types/round_stats_t.h"
+#include "types/shared_window_t.h"
+#include "types/totals_reduce_t.h"
 #include "types/word_t.h"
 #include "utils/bit.h"
 #include "utils/block.h"
 #include "utils/clargs.h"
 #include "utils/output.h"
 #include "utils/ranks.h"
-#include "utils/sort_r.h"
 #include "utils/timing.h"
+#include "xor_kernels.h"
 
 #include "hdf5.h"
 #include "mpi.h"
@@ -32,8 +56,15 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
+/**
+ * Returned by run_laid on every process when the dataset can't be opened,
+ * so a batch goes on with the next dataset
+ */
+#define EXIT_NOT_OPENED 2
+
 /**
  * In this mode we don't write the disjoint matrix (DM).
  * Everytime we need a line or column from the DM it's generated from the
@@ -43,8 +74,8 @@
  * memory. This allows us to save memory in each node, without sacrificing much
  * performance, because we're not having to send data across nodes.
  *
- * The node root(s) sort the dataset in memory, remove duplicates and  adds
- * jnsqs bits if necessary.
+ * The node root(s) sort the dataset in memory, remove duplicates, adds
+ * jnsqs bits if necessary and groups the lines by class.
  *
  * Then they build a list of the steps needed to generate the disjoint matrix.
  * This list of steps allows us to generate any line or column of the disjoint
@@ -57,6 +88,7 @@
  *  - Sort dataset
  *  - Remove duplicates
  *  - Add jnsqs
+ *  - Group by class
  *  - Builds steps for matrix generation
  *
  * All processes
@@ -65,30 +97,11 @@
  * Global root
  *  - Show solution
  */
-int main(int argc, char** argv)
+static int run_laid(const clargs_t args, MPI_Comm comm, MPI_Comm node_comm,
+					MPI_Comm roots_comm, const uint64_t n_threads,
+					shared_window_t* dset_window,
+					shared_window_t* columns_window, char** result)
 {
-	/**
-	 * Command line arguments set by the user
-	 */
-	clargs_t args;
-
-	/**
-	 * Parse command line arguments
-	 */
-	if (read_args(argc, argv, &args) == READ_CL_ARGS_NOK)
-	{
-		return EXIT_FAILURE;
-	}
-
-	/*
-	 * Initialize MPI
-	 */
-	if (MPI_Init(&argc, &argv) != MPI_SUCCESS)
-	{
-		printf("Error initializing MPI environment!\n");
-		return EXIT_FAILURE;
-	}
-
 	/**
 	 * Rank of process
 	 */
@@ -99,44 +112,34 @@ int main(int argc, char** argv)
 	 */
 	int size;
 
-	/**
-	 * Global communicator group
-	 */
-	MPI_Comm comm = MPI_COMM_WORLD;
-
 	/**
 	 * Setup global rank and size
 	 */
 	MPI_Comm_size(comm, &size);
 	MPI_Comm_rank(comm, &rank);
 
-	/**
-	 * Node communicator group
-	 */
-	MPI_Comm node_comm = MPI_COMM_NULL;
-
-	/**
-	 * Create node-local communicator
-	 * This communicator is used to share memory with processes intranode
-	 */
-	MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL,
-						&node_comm);
-
 	/**
 	 * In-node rank of process
 	 */
 	int node_rank;
+	MPI_Comm_rank(node_comm, &node_rank);
 
 	/**
-	 * In-node number of processes
+	 * Number of processes in the node
 	 */
 	int node_size;
+	MPI_Comm_size(node_comm, &node_size);
 
 	/**
-	 * Setup node rank and size
+	 * Threads of the node root while it preprocesses the dataset. The other
+	 * processes of the node wait for it, so it also uses their threads
 	 */
-	MPI_Comm_size(node_comm, &node_size);
-	MPI_Comm_rank(node_comm, &node_rank);
+	int thread_support;
+	MPI_Query_thread(&thread_support);
+
+	uint64_t n_node_threads = thread_support < MPI_THREAD_FUNNELED
+		? 1
+		: n_threads * (uint64_t) node_size;
 
 	/**
 	 * Timing for the full operation
@@ -161,7 +164,9 @@ int main(int argc, char** argv)
 
 	// Open dataset file
 	ROOT_SHOWS("Using dataset '%s'\n", args.filename);
-	ROOT_SHOWS("Using %d processes\n\n", size);
+	ROOT_SHOWS("Using %d processes", size);
+	ROOT_SHOWS(" with %lu thread(s) each\n", n_threads);
+	ROOT_SHOWS("Using %s XOR kernels\n\n", get_xor_kernels()->name);
 	ROOT_SAYS("Initializing MPI Shared Dataset: ");
 	TICK;
 
@@ -171,39 +176,136 @@ int main(int argc, char** argv)
 	 */
 	uint64_t shared_data_size = 0;
 
+	/**
+	 * The dataset data is mapped from the file instead of read
+	 */
+	bool mapped_data = false;
+
+	/**
+	 * Position of the data in the file, when it is mapped
+	 */
+	uint64_t data_offset = 0;
+
+	/**
+	 * The mapping of the dataset data
+	 */
+	dataset_mmap_t data_mapping = { NULL, 0 };
+	word_t* mapped_dset_data	= NULL;
+
+	/**
+	 * The file already has the preprocessed dataset
+	 */
+	bool preprocessed = false;
+
+	/**
+	 * Name of the preprocessed dataset
+	 */
+	char* preprocessed_name = hdf5_preprocessed_dataset_name(args.datasetname);
+	assert(preprocessed_name != NULL);
+
+	/**
+	 * Dimensions and attributes of the dataset read from the file, stored
+	 * with the preprocessed dataset
+	 */
+	uint64_t source_info[N_SOURCE_INFO] = { 0 };
+
+	/**
+	 * The dataset was opened and can be used, on every node
+	 */
+	oknok_t opened = OK;
+
 	if (node_rank == LOCAL_ROOT_RANK)
 	{
-		if (hdf5_open_dataset(args.filename, args.datasetname, &hdf5_dset)
-			== NOK)
+		preprocessed = hdf5_file_has_preprocessed_dataset(
+			args.filename, args.datasetname, preprocessed_name);
+
+		opened = hdf5_open_dataset_shared(args.filename,
+										  preprocessed ? preprocessed_name
+													   : args.datasetname,
+										  roots_comm, &hdf5_dset);
+	}
+
+	if (node_rank == LOCAL_ROOT_RANK && opened == OK)
+	{
+		dataset.n_observations = hdf5_dset.dimensions[0];
+
+		// Load dataset attributes
+		hdf5_read_dataset_attributes(hdf5_dset.dataset_id, &dataset);
+
+		if (preprocessed)
 		{
-			return EXIT_FAILURE;
+			// The words are not the ones of all the attributes and the class:
+			// the preprocessed lines only have the words of the attributes
+			// that were kept
+			dataset.n_words = hdf5_dset.dimensions[1];
+		}
+		else
+		{
+			hdf5_get_source_info(hdf5_dset.dataset_id, source_info);
 		}
 
-		dataset.n_observations = hdf5_dset.dimensions[0];
-		dataset.n_words		   = hdf5_dset.dimensions[1];
+		// The original lines are aligned while the jnsqs are set
+		shared_data_size = dataset.n_observations
+			* (preprocessed ? dataset.n_words
+							: get_aligned_line_words(&dataset));
+
+		// The preprocessed dataset is never changed, so it can be mapped
+		mapped_data = preprocessed
+			&& can_map_dataset_data(hdf5_dset.dataset_id, &data_offset);
 
-		shared_data_size = dataset.n_observations * dataset.n_words;
+		if (args.out_of_core_memory > 0 && !mapped_data)
+		{
+			fprintf(stderr,
+					"The out-of-core mode needs a preprocessed dataset stored "
+					"as contiguous words. Run once with --write-preprocessed\n");
+			hdf5_close_dataset(&hdf5_dset);
+			opened = NOK;
+		}
 	}
 
-	word_t* dset_data		= NULL;
-	MPI_Win win_shared_dset = MPI_WIN_NULL;
-	MPI_Win_allocate_shared(shared_data_size * sizeof(word_t), sizeof(word_t),
-							MPI_INFO_NULL, node_comm, &dset_data,
-							&win_shared_dset);
+	// The processes of comm give up on the dataset together
+	MPI_Allreduce(MPI_IN_PLACE, &opened, 1, MPI_INT8_T, MPI_MIN, comm);
 
-	// Set dataset data pointer
-	if (node_rank == LOCAL_ROOT_RANK)
+	if (opened != OK)
 	{
-		dataset.data = dset_data;
+		free(preprocessed_name);
+		return EXIT_NOT_OPENED;
 	}
-	else
+
+	MPI_Bcast(&preprocessed, 1, MPI_C_BOOL, LOCAL_ROOT_RANK, node_comm);
+	MPI_Bcast(&mapped_data, 1, MPI_C_BOOL, LOCAL_ROOT_RANK, node_comm);
+
+	if (mapped_data)
+	{
+		MPI_Bcast(&data_offset, 1, MPI_UINT64_T, LOCAL_ROOT_RANK, node_comm);
+		MPI_Bcast(&shared_data_size, 1, MPI_UINT64_T, LOCAL_ROOT_RANK,
+				  node_comm);
+
+		// Every process maps the file, sharing the same pages
+		if (map_dataset_data(args.filename, data_offset, shared_data_size,
+							 &data_mapping, &mapped_dset_data)
+			!= OK)
+		{
+			return EXIT_FAILURE;
+		}
+
+		shared_data_size = 0;
+	}
+
+	// The window of the last dataset is kept if this one fits
+	if (get_shared_window(node_comm, shared_data_size, dset_window) != OK)
 	{
-		MPI_Aint win_size;
-		int win_disp;
-		MPI_Win_shared_query(win_shared_dset, LOCAL_ROOT_RANK, &win_size,
-							 &win_disp, &dataset.data);
+		fprintf(stderr, "Error allocating the shared dataset\n");
+		return EXIT_FAILURE;
 	}
+
 	// All dataset.data pointers should now point to copy on noderank 0
+	dataset.data = dset_window->data;
+
+	if (mapped_data)
+	{
+		dataset.data = mapped_dset_data;
+	}
 
 	TOCK;
 
@@ -212,13 +314,46 @@ int main(int argc, char** argv)
 	ROOT_SAYS("Reading dataset: ");
 	TICK;
 
+	/**
+	 * Number of observations of each class of the preprocessed dataset
+	 */
+	uint64_t* preprocessed_class_counts = NULL;
+
+	/**
+	 * The attributes kept for the set cover and the input attribute of each
+	 */
+	attributes_map_t attributes_map;
+
 	if (node_rank == LOCAL_ROOT_RANK)
 	{
-		// Load dataset attributes
-		hdf5_read_dataset_attributes(hdf5_dset.dataset_id, &dataset);
+		if (preprocessed)
+		{
+			// The class counts are only needed after the Bcasts
+			preprocessed_class_counts
+				= (uint64_t*) malloc(dataset.n_classes * sizeof(uint64_t));
+			assert(preprocessed_class_counts != NULL);
+
+			if (hdf5_read_preprocessed_attributes(hdf5_dset.dataset_id,
+												  &dataset,
+												  preprocessed_class_counts)
+					!= OK
+				|| hdf5_read_attributes_map(hdf5_dset.dataset_id,
+											&attributes_map)
+					   != OK)
+			{
+				return EXIT_FAILURE;
+			}
+		}
 
-		// Load dataset data
-		hdf5_read_dataset_data(hdf5_dset.dataset_id, dataset.data);
+		// Load dataset data, the file is shared by the node roots
+		if (!mapped_data
+			&& hdf5_read_dataset_data_shared(
+				hdf5_dset.dataset_id, roots_comm, dataset.n_observations,
+				dataset.n_words, dataset.data)
+			== NOK)
+		{
+			return EXIT_FAILURE;
+		}
 
 		TOCK;
 
@@ -230,18 +365,32 @@ int main(int argc, char** argv)
 
 		// We no longer need the dataset file
 		hdf5_close_dataset(&hdf5_dset);
+	}
+
+	if (preprocessed)
+	{
+		ROOT_SHOWS("  Using preprocessed dataset '%s'\n", preprocessed_name);
+
+		if (args.out_of_core_memory > 0)
+		{
+			ROOT_SAYS("  Streamed from the file in blocks (out-of-core)\n");
+		}
+		else if (mapped_data)
+		{
+			ROOT_SAYS("  Mapped from the file\n");
+		}
+	}
+	else if (node_rank == LOCAL_ROOT_RANK)
+	{
 
 		// Sort dataset
 		ROOT_SAYS("Sorting dataset: ");
 		TICK;
 
-		/**
-		 * We need to know the number of longs in each line of the dataset
-		 * so we can't use the standard qsort implementation
-		 */
-		sort_r(dataset.data, dataset.n_observations,
-			   dataset.n_words * sizeof(word_t), compare_lines_extra,
-			   &dataset.n_words);
+		if (sort_dataset_omp(&dataset, n_node_threads) != OK)
+		{
+			return EXIT_FAILURE;
+		}
 
 		TOCK;
 
@@ -249,7 +398,7 @@ int main(int argc, char** argv)
 		ROOT_SAYS("Removing duplicates: ");
 		TICK;
 
-		uint64_t duplicates = remove_duplicates(&dataset);
+		uint64_t duplicates = remove_duplicates_omp(&dataset, n_node_threads);
 
 		TOCK;
 		ROOT_SHOWS("  %lu duplicate(s) removed\n", duplicates);
@@ -266,9 +415,8 @@ int main(int argc, char** argv)
 			  node_comm);
 	MPI_Bcast(&(dataset.n_words), 1, MPI_UINT64_T, LOCAL_ROOT_RANK, node_comm);
 
-	// Fill class arrays
-	ROOT_SAYS("Checking classes: ");
-	TICK;
+	// The lines are read with this stride even if n_words changes
+	dataset.line_stride = dataset.n_words;
 
 	/**
 	 * Array that stores the number of observations for each class
@@ -278,41 +426,73 @@ int main(int argc, char** argv)
 	assert(dataset.n_observations_per_class != NULL);
 
 	/**
-	 * Matrix that stores the list of observations per class
+	 * Array that stores the first observation of each class
 	 */
-	dataset.observations_per_class = (word_t**) calloc(
-		dataset.n_classes * dataset.n_observations, sizeof(word_t*));
+	dataset.observations_per_class
+		= (word_t**) calloc(dataset.n_classes, sizeof(word_t*));
 	assert(dataset.observations_per_class != NULL);
 
-	// Must make sure the dataset is filled before proceeding
-	MPI_Barrier(node_comm);
-
-	if (fill_class_arrays(&dataset) != OK)
+	if (preprocessed)
 	{
-		return EXIT_FAILURE;
-	}
+		// The lines are already grouped by class, with the jnsqs
+		if (node_rank == LOCAL_ROOT_RANK)
+		{
+			memcpy(dataset.n_observations_per_class, preprocessed_class_counts,
+				   dataset.n_classes * sizeof(uint64_t));
 
-	TOCK;
+			free(preprocessed_class_counts);
+			preprocessed_class_counts = NULL;
+		}
 
-	if (rank == ROOT_RANK)
-	{
 		for (uint64_t i = 0; i < dataset.n_classes; i++)
 		{
 			ROOT_SHOWS("  Class %lu: ", i);
 			ROOT_SHOWS("%lu item(s)\n", dataset.n_observations_per_class[i]);
 		}
+
+		ROOT_SHOWS("  JNSQ bits: %d\n", dataset.n_bits_for_jnsqs);
 	}
+	else if (node_rank == LOCAL_ROOT_RANK)
+	{
+		// Fill class arrays
+		ROOT_SAYS("Checking classes: ");
+		TICK;
 
-	// Must make sure everyone has finished before changing the dataset
-	MPI_Barrier(node_comm);
+		/**
+		 * The class of each line. The class bits are replaced by the
+		 * jnsqs, so we need to keep them until the dataset is grouped by
+		 * class
+		 */
+		uint32_t* classes
+			= (uint32_t*) malloc(dataset.n_observations * sizeof(uint32_t));
+		assert(classes != NULL);
 
-	// Set JNSQ
-	if (node_rank == LOCAL_ROOT_RANK)
-	{
+		/**
+		 * The attributes and words of the lines, while the class and the
+		 * jnsqs have a word of their own
+		 */
+		uint64_t n_attributes = dataset.n_attributes;
+		uint64_t n_words	  = dataset.n_words;
+
+		if (align_dataset_lines(&dataset) != OK
+			|| fill_class_arrays(&dataset, classes) != OK)
+		{
+			return EXIT_FAILURE;
+		}
+
+		TOCK;
+
+		for (uint64_t i = 0; i < dataset.n_classes; i++)
+		{
+			ROOT_SHOWS("  Class %lu: ", i);
+			ROOT_SHOWS("%lu item(s)\n", dataset.n_observations_per_class[i]);
+		}
+
+		// Set JNSQ
 		ROOT_SAYS("Setting up JNSQ attributes: ");
 		TICK;
 
-		uint64_t max_inconsistency = add_jnsqs(&dataset);
+		uint64_t max_inconsistency = add_jnsqs_omp(&dataset, n_node_threads);
 
 		// Update number of bits needed for jnsqs
 		if (max_inconsistency > 0)
@@ -326,8 +506,30 @@ int main(int argc, char** argv)
 		TOCK;
 		ROOT_SHOWS("  Max JNSQ: %lu", max_inconsistency);
 		ROOT_SHOWS(" [%d bits]\n", dataset.n_bits_for_jnsqs);
+
+		// Group lines by class
+		ROOT_SAYS("Grouping observations by class: ");
+		TICK;
+
+		if (group_by_class(&dataset, classes) != OK
+			|| pack_dataset_lines(&dataset, n_attributes, n_words) != OK)
+		{
+			return EXIT_FAILURE;
+		}
+
+		free(classes);
+		classes = NULL;
+
+		TOCK;
 	}
 
+	// Share the number of observations per class
+	MPI_Bcast(dataset.n_observations_per_class, dataset.n_classes,
+			  MPI_UINT64_T, LOCAL_ROOT_RANK, node_comm);
+
+	// Every process has its own pointer to the shared dataset
+	set_observations_per_class(&dataset);
+
 	// Update dataset data because only node_root knows if we added jnsqs
 	MPI_Bcast(&(dataset.n_bits_for_jnsqs), 1, MPI_UINT8_T, LOCAL_ROOT_RANK,
 			  node_comm);
@@ -344,61 +546,261 @@ int main(int argc, char** argv)
 	dataset.n_words = dataset.n_attributes / WORD_BITS
 		+ (dataset.n_attributes % WORD_BITS != 0);
 
-	// End setup dataset
+	/**
+	 * Transposed copy of the dataset, shared like the dataset, so the columns
+	 * are generated a word at a time. It is as big as the dataset, so it is
+	 * not used out-of-core or if it doesn't fit
+	 */
+	word_t* dset_columns = NULL;
 
-	MPI_Barrier(node_comm);
+	bool transposed = args.out_of_core_memory == 0;
 
-	// Setup disjoint matrix
+	if (transposed && node_rank == LOCAL_ROOT_RANK)
+	{
+		transposed
+			= can_transpose_dataset(&dataset, args.max_transposed_memory);
+	}
 
-	/**
-	 * The disjoint matrix info
-	 */
-	dm_t dm;
+	// The nodes remove the same attributes, so they all need the copy
+	MPI_Allreduce(MPI_IN_PLACE, &transposed, 1, MPI_C_BOOL, MPI_LAND, comm);
 
-	ROOT_SAYS("Calculating disjoint matrix lines to generate: ");
-	TICK;
+	if (!transposed)
+	{
+		// The copy of the last dataset of a batch is not needed either
+		free_shared_window(columns_window);
 
-	// Calculate the number of disjoint matrix lines
-	dm.n_matrix_lines = get_dm_n_lines(&dataset);
+		if (args.out_of_core_memory == 0)
+		{
+			ROOT_SAYS("Not transposing dataset: it doesn't fit in memory\n");
+		}
+	}
+	else
+	{
+		ROOT_SAYS("Transposing dataset: ");
+		TICK;
+
+		uint64_t columns_size = node_rank == LOCAL_ROOT_RANK
+			? get_transposed_size(&dataset)
+			: 0;
 
-	// Calculate the offset and number of lines for this process
-	dm.s_offset = BLOCK_LOW(rank, size, dm.n_matrix_lines);
-	dm.s_size	= BLOCK_SIZE(rank, size, dm.n_matrix_lines);
+		if (get_shared_window(node_comm, columns_size, columns_window) != OK)
+		{
+			fprintf(stderr, "Error allocating the transposed dataset\n");
+			return EXIT_FAILURE;
+		}
 
-	// Calculate initial offsets for each process
-	calculate_class_offsets(&dataset, dm.s_offset, &dm.initial_class_offsets);
+		dset_columns = columns_window->data;
 
-	TOCK;
+		if (set_columns_per_class(&dataset, dset_columns) != OK)
+		{
+			fprintf(stderr, "Error allocating the transposed dataset\n");
+			return EXIT_FAILURE;
+		}
 
-	if (rank == ROOT_RANK)
+		if (node_rank == LOCAL_ROOT_RANK)
+		{
+			transpose_dataset(&dataset, n_node_threads);
+		}
+
+		TOCK;
+	}
+
+	if (preprocessed)
 	{
-		double matrix_size = ((double) dm.n_matrix_lines * dataset.n_attributes)
-			/ (1024.0 * 1024 * 1024 * 8);
-		ROOT_SHOWS("  Estimated disjoint matrix size: %3.2fGB\n", matrix_size);
+		// The attributes were removed before the dataset was written
+		MPI_Bcast(&attributes_map.n_attributes, 1, MPI_UINT64_T,
+				  LOCAL_ROOT_RANK, node_comm);
+	}
 
-		fprintf(stdout, "  Number of lines in the disjoint matrix: %lu\n",
-				dm.n_matrix_lines);
+	if ((!preprocessed || node_rank != LOCAL_ROOT_RANK)
+		&& init_attributes_map(preprocessed ? attributes_map.n_attributes
+											: dataset.n_attributes,
+							   &attributes_map)
+			   != OK)
+	{
+		fprintf(stderr, "Error allocating the attributes map\n");
+		return EXIT_FAILURE;
+	}
 
-		for (int r = 0; r < size; r++)
+	if (preprocessed)
+	{
+		MPI_Bcast(&attributes_map.n_kept, 1, MPI_UINT64_T, LOCAL_ROOT_RANK,
+				  node_comm);
+		MPI_Bcast(attributes_map.original, attributes_map.n_kept, MPI_UINT64_T,
+				  LOCAL_ROOT_RANK, node_comm);
+		MPI_Bcast(attributes_map.kept, attributes_map.n_attributes,
+				  MPI_INT64_T, LOCAL_ROOT_RANK, node_comm);
+
+		ROOT_SHOWS("  %lu attribute(s) removed when it was preprocessed\n",
+				   attributes_map.n_attributes - attributes_map.n_kept);
+	}
+
+	// Only the transposed dataset is hashed
+	if (transposed && !preprocessed)
+	{
+		ROOT_SAYS("Removing redundant attributes: ");
+		TICK;
+
+		oknok_t reduced = OK;
+
+		if (node_rank == LOCAL_ROOT_RANK)
 		{
-			uint64_t s_offset = BLOCK_LOW(r, size, dm.n_matrix_lines);
-			uint64_t s_size	  = BLOCK_SIZE(r, size, dm.n_matrix_lines);
-			if (s_size > 0)
-			{
-				fprintf(stdout,
-						"    Process %d will generate %lu lines [%lu -> %lu]\n",
-						r, s_size, s_offset, s_offset + s_size - 1);
-			}
-			else
+			reduced = find_redundant_attributes(&dataset, &attributes_map,
+												n_node_threads);
+
+			if (reduced == OK)
 			{
-				fprintf(stdout, "    Process %d will generate 0 lines\n", r);
+				reduced = remove_redundant_attributes(&dataset, &attributes_map,
+													  n_node_threads);
 			}
 		}
+
+		MPI_Bcast(&reduced, 1, MPI_INT8_T, LOCAL_ROOT_RANK, node_comm);
+		if (reduced != OK)
+		{
+			fprintf(stderr, "Error allocating memory to remove attributes\n");
+			return EXIT_FAILURE;
+		}
+
+		MPI_Bcast(&attributes_map.n_kept, 1, MPI_UINT64_T, LOCAL_ROOT_RANK,
+				  node_comm);
+		MPI_Bcast(attributes_map.original, attributes_map.n_kept, MPI_UINT64_T,
+				  LOCAL_ROOT_RANK, node_comm);
+		MPI_Bcast(attributes_map.kept, attributes_map.n_attributes,
+				  MPI_INT64_T, LOCAL_ROOT_RANK, node_comm);
+
+		uint64_t n_constant = 0;
+		for (uint64_t a = 0; a < attributes_map.n_attributes; a++)
+		{
+			n_constant += attributes_map.kept[a] < 0;
+		}
+
+		dataset.n_attributes = attributes_map.n_kept;
+		dataset.n_words		 = dataset.n_attributes / WORD_BITS
+			+ (dataset.n_attributes % WORD_BITS != 0);
+
+		TOCK;
+
+		ROOT_SHOWS("  %lu constant and ", n_constant);
+		ROOT_SHOWS("%lu duplicate attribute(s) removed\n",
+				   attributes_map.n_attributes - attributes_map.n_kept
+					   - n_constant);
 	}
 
-	TICK;
+	if (args.write_preprocessed && !preprocessed && rank == ROOT_RANK)
+	{
+		ROOT_SAYS("Writing preprocessed dataset: ");
+		TICK;
 
-	/**
+		// The run goes on even if the dataset can't be written
+		oknok_t written = hdf5_write_preprocessed_dataset(
+			args.filename, preprocessed_name, &dataset, &attributes_map,
+			source_info);
+
+		TOCK;
+
+		if (written == OK)
+		{
+			ROOT_SHOWS("  Saved as '%s'\n", preprocessed_name);
+		}
+	}
+
+	free(preprocessed_name);
+	preprocessed_name = NULL;
+
+	// End setup dataset
+
+	MPI_Barrier(node_comm);
+
+	// Setup disjoint matrix
+
+	if (args.out_of_core_memory > 0)
+	{
+		// The memory of the node is split between all its threads
+		set_dm_blocks(&dataset, args.out_of_core_memory * 1024 * 1024
+									/ ((uint64_t) node_size * n_threads));
+
+		// All the processes number the lines the same way
+		MPI_Allreduce(MPI_IN_PLACE, &dataset.n_block_observations, 1,
+					  MPI_UINT64_T, MPI_MIN, comm);
+		MPI_Allreduce(MPI_IN_PLACE, &dataset.n_chunk_observations, 1,
+					  MPI_UINT64_T, MPI_MIN, comm);
+
+		ROOT_SHOWS("Streaming blocks of %lu observations ",
+				   dataset.n_block_observations);
+		ROOT_SHOWS("with chunks of %lu\n", dataset.n_chunk_observations);
+	}
+
+	/**
+	 * The disjoint matrix info
+	 */
+	dm_t dm;
+
+	ROOT_SAYS("Calculating disjoint matrix lines to generate: ");
+	TICK;
+
+	// Calculate the number of disjoint matrix lines
+	dm.n_matrix_lines = get_dm_n_lines(&dataset);
+
+	// Number of words of a full column. The lines of each process start on
+	// a word, so they can be moved between processes
+	uint64_t n_matrix_words = dm.n_matrix_lines / WORD_BITS
+		+ (dm.n_matrix_lines % WORD_BITS != 0);
+
+	// Calculate the offset and number of lines for this process, and its
+	// initial offsets
+	set_dm_words(&dataset, BLOCK_LOW(rank, size, n_matrix_words),
+				 BLOCK_SIZE(rank, size, n_matrix_words), &dm);
+
+	TOCK;
+
+	if (rank == ROOT_RANK)
+	{
+		double matrix_size = ((double) dm.n_matrix_lines * dataset.n_attributes)
+			/ (1024.0 * 1024 * 1024 * 8);
+		ROOT_SHOWS("  Estimated disjoint matrix size: %3.2fGB\n", matrix_size);
+
+		fprintf(stdout, "  Number of lines in the disjoint matrix: %lu\n",
+				dm.n_matrix_lines);
+
+		for (int r = 0; r < size; r++)
+		{
+			dm_t r_dm = { .n_matrix_lines = dm.n_matrix_lines };
+			set_dm_words(&dataset, BLOCK_LOW(r, size, n_matrix_words),
+						 BLOCK_SIZE(r, size, n_matrix_words), &r_dm);
+
+			uint64_t s_offset = r_dm.s_offset;
+			uint64_t s_size	  = r_dm.s_size;
+			if (s_size > 0)
+			{
+				fprintf(stdout,
+						"    Process %d will generate %lu lines [%lu -> %lu]\n",
+						r, s_size, s_offset, s_offset + s_size - 1);
+
+				// The class pairs, as (class, observation) x (class,
+				// observation), of the first and last lines
+				class_offsets_t last;
+				calculate_class_offsets(&dataset, s_offset + s_size - 1,
+										&last);
+
+				class_offsets_t* first = &r_dm.initial_class_offsets;
+				fprintf(stdout,
+						"      (%lu, %lu) x (%lu, %lu) -> (%lu, %lu) x (%lu, "
+						"%lu)\n",
+						first->classA, first->indexA, first->classB,
+						first->indexB, last.classA, last.indexA, last.classB,
+						last.indexB);
+			}
+			else
+			{
+				fprintf(stdout, "    Process %d will generate 0 lines\n", r);
+			}
+		}
+	}
+
+	TICK;
+
+	/**
 	 * All:
 	 *  - Setup line covered array -> 0
 	 *  - Setup attribute covered array -> 0
@@ -426,14 +828,42 @@ int main(int argc, char** argv)
 	 *  - goto loop
 	 */
 
-	ROOT_SAYS("Applying set covering algorithm:\n");
-	TICK;
+	/**
+	 * The part of the disjoint matrix of each thread
+	 */
+	dm_threads_t dm_threads;
+	if (init_dm_threads(&dataset, &dm, n_threads, &dm_threads) != OK)
+	{
+		fprintf(stderr, "Error allocating memory for the threads\n");
+		return EXIT_FAILURE;
+	}
 
 	/**
-	 * Number of words needed to store a column (attribute data)
+	 * The disjoint matrix lines of this process, if they fit in the memory
+	 * set by the user. Otherwise the lines are generated when needed
 	 */
-	dm.n_words_in_a_column
-		= dm.s_size / WORD_BITS + (dm.s_size % WORD_BITS != 0);
+	word_t* dm_cache = NULL;
+
+	uint64_t dm_cache_size = get_dm_cache_size(&dataset, &dm);
+	if (dm_cache_size > 0 && dm_cache_size <= args.max_dm_memory * 1024 * 1024)
+	{
+		dm_cache = (word_t*) malloc(dm_cache_size);
+	}
+
+	if (dm_cache != NULL)
+	{
+		ROOT_SAYS("Storing disjoint matrix lines in memory: ");
+		TICK;
+
+		build_dm_cache(&dataset, &dm_threads, &dm, dm_cache);
+
+		TOCK;
+		ROOT_SHOWS("  %3.2fMB per process\n",
+				   (double) dm_cache_size / (1024.0 * 1024));
+	}
+
+	ROOT_SAYS("Applying set covering algorithm:\n");
+	TICK;
 
 	/**
 	 * The best attribute data bit array
@@ -441,6 +871,28 @@ int main(int argc, char** argv)
 	word_t* best_column
 		= (word_t*) calloc(dm.n_words_in_a_column, sizeof(word_t));
 
+	/**
+	 * The column of the best local attribute, generated while the totals
+	 * are reduced. It is used if that attribute is the best global one
+	 */
+	word_t* speculative_column = NULL;
+	if (args.pipeline)
+	{
+		speculative_column
+			= (word_t*) calloc(dm.n_words_in_a_column, sizeof(word_t));
+	}
+
+	/**
+	 * Number of rounds where the speculative column was or wasn't used
+	 */
+	uint64_t speculative_stats[2] = { 0, 0 };
+
+	/**
+	 * The set cover state on the device, if the totals are offloaded
+	 */
+	offload_t offload;
+	bool use_offload = false;
+
 	/**
 	 * The covered lines bit array
 	 */
@@ -461,15 +913,44 @@ int main(int argc, char** argv)
 		= (uint64_t*) calloc(dataset.n_words * WORD_BITS, sizeof(uint64_t));
 
 	/**
-	 * Global totals. Only root needs these
+	 * Global totals
 	 */
 
 	/**
-	 * Full total for each attribute.
+	 * Full total for each attribute. Every process gets them, so all can
+	 * select the best attribute.
 	 * Use n_words instead of n_attributes on allocation to avoid
 	 * extra verifications on last word
 	 */
-	uint64_t* global_attribute_totals = NULL;
+	uint64_t* global_attribute_totals
+		= (uint64_t*) calloc(dataset.n_words * WORD_BITS, sizeof(uint64_t));
+
+	/**
+	 * The words of the dataset lines with attributes that can still be
+	 * selected, one bit for each word
+	 */
+	word_t* live_attribute_words = (word_t*) calloc(
+		dataset.n_words / WORD_BITS + (dataset.n_words % WORD_BITS != 0),
+		sizeof(word_t));
+
+	/**
+	 * The reduction of the totals between processes
+	 */
+	totals_reduce_t totals_reduce;
+	if (init_totals_reduce(comm, dataset.n_attributes, dm.n_matrix_lines,
+						   &totals_reduce)
+		!= OK)
+	{
+		fprintf(stderr, "Error allocating memory for the totals reduction\n");
+		return EXIT_FAILURE;
+	}
+
+	if (args.node_reduce && !args.lazy
+		&& set_node_totals_reduce(node_comm, roots_comm, &totals_reduce) != OK)
+	{
+		fprintf(stderr, "Error allocating memory for the node reduction\n");
+		return EXIT_FAILURE;
+	}
 
 	/**
 	 * Selected attributes bit array aka the solution
@@ -477,61 +958,424 @@ int main(int argc, char** argv)
 	word_t* selected_attributes = NULL;
 
 	/**
-	 * Number of uncovered lines in the full matrix. Only root needs this.
+	 * Number of uncovered lines in the full matrix
 	 */
 	uint64_t global_n_uncovered_lines = dm.n_matrix_lines;
 
 	if (rank == ROOT_RANK)
 	{
-		global_attribute_totals
-			= (uint64_t*) calloc(dataset.n_words * WORD_BITS, sizeof(uint64_t));
+		selected_attributes
+			= (word_t*) calloc(attributes_map.n_words, sizeof(word_t));
+	}
+
+	/**
+	 * Time spent by this process on each phase of the rounds
+	 */
+	round_stats_t stats;
+	if (init_round_stats(&stats) != OK)
+	{
+		fprintf(stderr, "Error allocating memory for the stats\n");
+		return EXIT_FAILURE;
+	}
+
+	/**
+	 * The covered lines were set from a checkpoint
+	 */
+	bool resumed = false;
+
+	/**
+	 * Number of attributes selected since the last checkpoint
+	 */
+	uint64_t rounds_since_checkpoint = 0;
+
+	if (args.resume)
+	{
+		// A missing checkpoint means the job is starting
+		if (rank == ROOT_RANK)
+		{
+			FILE* checkpoint_file = fopen(args.checkpoint, "r");
+			if (checkpoint_file != NULL)
+			{
+				resumed = true;
+				fclose(checkpoint_file);
+			}
+		}
+
+		MPI_Bcast(&resumed, 1, MPI_C_BOOL, ROOT_RANK, comm);
+	}
+
+	if (resumed)
+	{
+		uint64_t n_selected = 0;
+
+		if (resume_checkpoint(comm, args.checkpoint, &dataset, &attributes_map,
+							  &dm,
+							  &dm_threads, dm_cache, selected_attributes,
+							  covered_lines, best_column,
+							  &global_n_uncovered_lines, &n_selected)
+			!= OK)
+		{
+			return EXIT_FAILURE;
+		}
+
+		n_uncovered_lines = get_n_uncovered_lines(&dm, covered_lines);
+
+		ROOT_SHOWS("  Resumed %lu attribute(s) ", n_selected);
+		ROOT_SHOWS("from '%s' ", args.checkpoint);
+		TOCK;
+		TICK;
+
+		if (global_n_uncovered_lines == 0)
+		{
+			goto show_solution;
+		}
+	}
+
+	if (args.lazy)
+	{
+		begin_phase(&stats, STATS_TOTALS);
+
+		// Every process keeps the heap, so all need the global totals
+		lazy_heap_t heap;
+		if (init_lazy_heap(comm, &dataset, &dm, &dm_threads, dm_cache,
+						   resumed ? covered_lines : NULL, attribute_totals,
+						   global_attribute_totals, &heap)
+			!= OK)
+		{
+			fprintf(stderr, "Error allocating memory for the lazy heap\n");
+			return EXIT_FAILURE;
+		}
+
+		end_phase(&stats);
+
+		for (uint64_t round = 0; global_n_uncovered_lines > 0; round++)
+		{
+			int64_t best_attribute = -1;
+			uint64_t best_total	   = 0;
+
+			// The candidates are evaluated and reduced together
+			begin_phase(&stats, STATS_TOTALS);
+
+			if (get_lazy_best_attribute(comm, &dataset, &dm, &dm_threads,
+										dm_cache, covered_lines, round, &heap,
+										attribute_totals,
+										global_attribute_totals,
+										&best_attribute, &best_total,
+										best_column)
+				!= OK)
+			{
+				fprintf(stderr, "Error allocating memory for the candidates\n");
+				return EXIT_FAILURE;
+			}
+
+			end_phase(&stats);
+
+			// No more attributes available
+			if (best_attribute < 0)
+			{
+				break;
+			}
+
+			ROOT_SHOWS("  Selected attribute #%lu, ",
+					   attributes_map.original[best_attribute]);
+			ROOT_SHOWS("covers %lu lines ", best_total);
+			TOCK;
+			TICK;
+
+			if (rank == ROOT_RANK)
+			{
+				mark_attribute_as_selected(
+					selected_attributes,
+					(int64_t) attributes_map.original[best_attribute]);
+			}
+
+			// Update number of lines remaining in the disjoint matrix
+			global_n_uncovered_lines -= best_total;
+
+			if (args.checkpoint != NULL && rank == ROOT_RANK
+				&& ++rounds_since_checkpoint == args.checkpoint_rounds)
+			{
+				write_checkpoint(args.checkpoint, &attributes_map, &dm,
+								 selected_attributes, global_n_uncovered_lines);
+				rounds_since_checkpoint = 0;
+			}
+
+			update_covered_lines(best_column, dm.n_words_in_a_column,
+								 covered_lines);
+
+			uint64_t n_uncovered = get_n_uncovered_lines(&dm, covered_lines);
+
+			// The cached columns do not use the worklists
+			if (dm_cache == NULL
+				&& compact_dm_worklists(&dataset, &dm_threads, covered_lines,
+										n_uncovered)
+					!= OK)
+			{
+				fprintf(stderr, "Error allocating memory for the worklists\n");
+				return EXIT_FAILURE;
+			}
+
+			end_round(&stats, n_uncovered);
+		}
+
+		free_lazy_heap(&heap);
+
+		goto show_solution;
+	}
+
+	if (args.offload)
+	{
+		int device = get_offload_device();
 
-		selected_attributes = (word_t*) calloc(dataset.n_words, sizeof(word_t));
+		// The device generates the lines from the transposed dataset
+		use_offload = device >= 0 && dm_cache == NULL
+			&& dataset.columns_per_class != NULL;
+
+		if (!use_offload)
+		{
+			ROOT_SAYS("  The totals can't be offloaded, using the CPU\n");
+		}
+		else if (init_offload(&dataset, &dm, device, covered_lines,
+							  attribute_totals, &offload)
+				 != OK)
+		{
+			fprintf(stderr, "Error allocating memory for the offload\n");
+			return EXIT_FAILURE;
+		}
+		else if (is_host_offload_device(device))
+		{
+			ROOT_SAYS("  No target device, the offload runs on the host\n");
+		}
+		else
+		{
+			ROOT_SHOWS("  Offloading the totals to device %d\n", device);
+		}
 	}
 
+	begin_phase(&stats, STATS_TOTALS);
+
 	// Calculate the totals for all attributes
-	calculate_initial_attribute_totals(&dataset, &dm, attribute_totals);
+	if (use_offload)
+	{
+		calculate_attribute_totals_offload(&offload);
+	}
+	else if (resumed)
+	{
+		// Only the lines not covered by the checkpoint
+		if (dm_cache != NULL)
+		{
+			calculate_attribute_totals_add_cached(
+				&dataset, &dm, dm_threads.n_threads, dm_cache, covered_lines,
+				attribute_totals);
+		}
+		else
+		{
+			calculate_attribute_totals_add_omp(&dataset, &dm_threads,
+											   covered_lines, attribute_totals);
+		}
+	}
+	else if (dm_cache != NULL)
+	{
+		calculate_initial_attribute_totals_cached(
+			&dataset, &dm, dm_threads.n_threads, dm_cache, attribute_totals);
+	}
+	else
+	{
+		calculate_initial_attribute_totals_omp(&dataset, &dm_threads,
+											   attribute_totals);
+	}
+
+	end_phase(&stats);
 
-	while (true)
+	for (uint64_t round = 0;; round++)
 	{
+		begin_phase(&stats, STATS_BALANCE);
+
+		// Move lines between processes if some have many more uncovered lines
+		bool rebalanced = false;
+		if (rebalance_dm(comm, &dataset, &dm, round, n_uncovered_lines,
+						 &covered_lines, &best_column, &rebalanced)
+			!= OK)
+		{
+			fprintf(stderr, "Error moving the disjoint matrix lines\n");
+			return EXIT_FAILURE;
+		}
+
+		if (rebalanced)
+		{
+			ROOT_SAYS("  Moved lines between processes\n");
+
+			if (args.pipeline)
+			{
+				free(speculative_column);
+				speculative_column
+					= (word_t*) calloc(dm.n_words_in_a_column, sizeof(word_t));
+			}
+
+			free_dm_threads(&dm_threads);
+			if (init_dm_threads(&dataset, &dm, n_threads, &dm_threads) != OK)
+			{
+				fprintf(stderr, "Error allocating memory for the threads\n");
+				return EXIT_FAILURE;
+			}
+
+			n_uncovered_lines = get_n_uncovered_lines(&dm, covered_lines);
+
+			// The device gets the new lines
+			if (use_offload)
+			{
+				int device = offload.device;
+
+				free_offload(&offload);
+				if (init_offload(&dataset, &dm, device, covered_lines,
+								 attribute_totals, &offload)
+					!= OK)
+				{
+					fprintf(stderr, "Error allocating memory for the offload\n");
+					return EXIT_FAILURE;
+				}
+			}
+
+			// Store the new lines, if they still fit
+			if (dm_cache != NULL)
+			{
+				free(dm_cache);
+				dm_cache = NULL;
+
+				dm_cache_size = get_dm_cache_size(&dataset, &dm);
+				if (dm_cache_size > 0
+					&& dm_cache_size <= args.max_dm_memory * 1024 * 1024)
+				{
+					dm_cache = (word_t*) malloc(dm_cache_size);
+				}
+
+				if (dm_cache != NULL)
+				{
+					build_dm_cache(&dataset, &dm_threads, &dm, dm_cache);
+				}
+			}
+		}
+
+		end_phase(&stats);
+
+		if (rebalanced)
+		{
+			begin_phase(&stats, STATS_TOTALS);
+
+			// The totals of the new lines
+			if (use_offload)
+			{
+				calculate_attribute_totals_offload(&offload);
+			}
+			else if (dm_cache != NULL)
+			{
+				calculate_attribute_totals_add_cached(
+					&dataset, &dm, dm_threads.n_threads, dm_cache,
+					covered_lines, attribute_totals);
+			}
+			else
+			{
+				calculate_attribute_totals_add_omp(
+					&dataset, &dm_threads, covered_lines, attribute_totals);
+			}
+
+			end_phase(&stats);
+		}
+
 		// Calculate global totals
-		MPI_Reduce(attribute_totals, global_attribute_totals,
-				   dataset.n_attributes, MPI_UINT64_T, MPI_SUM, ROOT_RANK,
-				   comm);
+		begin_phase(&stats, STATS_REDUCE);
+
+		/**
+		 * Attribute of the speculative column of this round
+		 */
+		int64_t speculative_attribute = -1;
+
+		if (args.pipeline && !use_offload)
+		{
+			start_reduce_attribute_totals(comm, attribute_totals,
+										  &totals_reduce,
+										  global_attribute_totals);
+
+			end_phase(&stats);
+			begin_phase(&stats, STATS_COLUMN);
+
+			// The best local attribute is often the best global one
+			speculative_attribute = get_best_attribute_index(
+				attribute_totals, dataset.n_attributes);
+
+			if (speculative_attribute >= 0 && dm_cache != NULL)
+			{
+				get_column_cached(&dm, dm_cache, speculative_attribute,
+								  speculative_column);
+			}
+			else if (speculative_attribute >= 0)
+			{
+				get_column_omp(&dataset, &dm_threads, speculative_attribute,
+							   speculative_column);
+			}
+
+			end_phase(&stats);
+			begin_phase(&stats, STATS_REDUCE);
+
+			finish_reduce_attribute_totals(&totals_reduce,
+										   global_attribute_totals);
+		}
+		else
+		{
+			reduce_attribute_totals(comm, attribute_totals, &totals_reduce,
+									global_attribute_totals);
+		}
+
+		// The next totals skip the words left without a global total
+		if (!use_offload)
+		{
+			update_live_attribute_words(&dataset, global_attribute_totals,
+										live_attribute_words, &dm, &dm_threads);
+		}
+
+		end_phase(&stats);
 
 		// Get best attribute index
-		int64_t best_attribute = -1;
+		// Every process has the same global totals and selects the same one
+		int64_t best_attribute = get_best_attribute_index(
+			global_attribute_totals, dataset.n_attributes);
 
 		if (rank == ROOT_RANK)
 		{
-			best_attribute = get_best_attribute_index(global_attribute_totals,
-													  dataset.n_attributes);
-
-			ROOT_SHOWS("  Selected attribute #%ld, ", best_attribute);
+			ROOT_SHOWS("  Selected attribute #%lu, ",
+					   attributes_map.original[best_attribute]);
 			ROOT_SHOWS("covers %lu lines ",
 					   global_attribute_totals[best_attribute]);
 			TOCK;
 			TICK;
 
-			// Mark best attribute as selected
-			mark_attribute_as_selected(selected_attributes, best_attribute);
+			// Mark best attribute as selected, with its input index
+			mark_attribute_as_selected(
+				selected_attributes,
+				(int64_t) attributes_map.original[best_attribute]);
+		}
 
-			// Update number of lines remaining in the disjoint matrix
-			global_n_uncovered_lines -= global_attribute_totals[best_attribute];
+		// Update number of lines remaining in the disjoint matrix
+		global_n_uncovered_lines -= global_attribute_totals[best_attribute];
 
-			// If we covered all of them, we can leave earlier
-			if (global_n_uncovered_lines == 0)
-			{
-				best_attribute = -1;
-			}
+		if (args.checkpoint != NULL && rank == ROOT_RANK
+			&& ++rounds_since_checkpoint == args.checkpoint_rounds)
+		{
+			write_checkpoint(args.checkpoint, &attributes_map, &dm,
+							 selected_attributes, global_n_uncovered_lines);
+			rounds_since_checkpoint = 0;
 		}
 
-		// Share best attribute with everyone
-		MPI_Bcast(&best_attribute, 1, MPI_INT64_T, 0, comm);
+		// If we covered all of them, we can leave earlier
+		if (global_n_uncovered_lines == 0)
+		{
+			best_attribute = -1;
+		}
 
 		// If best_attribute is -1 we are done
 		if (best_attribute < 0)
 		{
+			end_round(&stats, n_uncovered_lines);
 			goto show_solution;
 		}
 
@@ -539,49 +1383,157 @@ int main(int argc, char** argv)
 		n_uncovered_lines -= attribute_totals[best_attribute];
 
 		// If we covered all of them, we can leave earlier?
-		// No we don't: We need to participate in the MPI_Reduce
+		// No we don't: We need to participate in the reduction
 		if (n_uncovered_lines == 0)
 		{
 			// Reset attributes totals because we can have some remaining values
 			// from previous run
 			memset(attribute_totals, 0,
 				   dataset.n_attributes * sizeof(uint64_t));
+
+			// All lines are covered, in case they are moved to other processes
+			memset(covered_lines, 0xff, dm.n_words_in_a_column * sizeof(word_t));
+
+			end_round(&stats, n_uncovered_lines);
 			continue;
 		}
 
-		get_column(&dataset, &dm, best_attribute, best_column);
+		// Add when fewer lines remain uncovered than the attribute covers
+		bool add_totals = n_uncovered_lines < attribute_totals[best_attribute];
+
+		// The column was generated during the reduction
+		bool speculated = best_attribute == speculative_attribute;
+
+		if (speculative_attribute >= 0)
+		{
+			speculative_stats[speculated]++;
+		}
+
+		if (use_offload)
+		{
+			begin_phase(&stats, STATS_TOTALS);
+
+			update_attribute_totals_offload(&offload, best_attribute);
+
+			end_phase(&stats);
+			end_round(&stats, n_uncovered_lines);
+			continue;
+		}
+
+		if (dm_cache == NULL && !speculated)
+		{
+			// Get the column, update the covered lines and the totals in a
+			// single pass over the lines
+			begin_phase(&stats, STATS_TOTALS);
+
+			update_attribute_totals_omp(&dataset, &dm_threads, best_attribute,
+										!add_totals, covered_lines,
+										best_column, attribute_totals);
+
+			// Stop visiting the lines that are covered now
+			if (compact_dm_worklists(&dataset, &dm_threads, covered_lines,
+									 n_uncovered_lines)
+				!= OK)
+			{
+				fprintf(stderr, "Error allocating memory for the worklists\n");
+				return EXIT_FAILURE;
+			}
+
+			end_phase(&stats);
+			end_round(&stats, n_uncovered_lines);
+			continue;
+		}
+
+		word_t* column = speculated ? speculative_column : best_column;
+
+		if (!speculated)
+		{
+			begin_phase(&stats, STATS_COLUMN);
+
+			get_column_cached(&dm, dm_cache, best_attribute, best_column);
+
+			end_phase(&stats);
+		}
+
+		begin_phase(&stats, STATS_TOTALS);
 
-		if (n_uncovered_lines < attribute_totals[best_attribute])
+		if (add_totals)
 		{
 			// Add
 			// Update covered lines
-			update_covered_lines(best_column, dm.n_words_in_a_column,
+			update_covered_lines(column, dm.n_words_in_a_column,
 								 covered_lines);
 
-			calculate_attribute_totals_add(&dataset, &dm, covered_lines,
-										   attribute_totals);
+			if (dm_cache != NULL)
+			{
+				calculate_attribute_totals_add_cached(
+					&dataset, &dm, dm_threads.n_threads, dm_cache,
+					covered_lines, attribute_totals);
+			}
+			else
+			{
+				calculate_attribute_totals_add_omp(
+					&dataset, &dm_threads, covered_lines, attribute_totals);
+			}
 		}
 		else
 		{
 			// Sub
 			for (uint64_t w = 0; w < dm.n_words_in_a_column; w++)
 			{
-				best_column[w] &= ~covered_lines[w];
+				column[w] &= ~covered_lines[w];
 			}
 
-			calculate_attribute_totals_sub(&dataset, &dm, best_column,
-										   attribute_totals);
+			if (dm_cache != NULL)
+			{
+				calculate_attribute_totals_sub_cached(
+					&dataset, &dm, dm_threads.n_threads, dm_cache, column,
+					attribute_totals);
+			}
+			else
+			{
+				calculate_attribute_totals_sub_omp(&dataset, &dm_threads,
+												   column, attribute_totals);
+			}
 
 			// Update covered lines
-			update_covered_lines(best_column, dm.n_words_in_a_column,
+			update_covered_lines(column, dm.n_words_in_a_column,
 								 covered_lines);
 		}
+
+		// Stop visiting the lines that are covered now
+		if (dm_cache == NULL
+			&& compact_dm_worklists(&dataset, &dm_threads, covered_lines,
+									n_uncovered_lines)
+				!= OK)
+		{
+			fprintf(stderr, "Error allocating memory for the worklists\n");
+			return EXIT_FAILURE;
+		}
+
+		end_phase(&stats);
+		end_round(&stats, n_uncovered_lines);
 	}
 
 show_solution:
 	// wait for everyone
 	MPI_Barrier(comm);
 
+	if (args.stats != NULL)
+	{
+		write_round_stats(comm, &stats, args.stats);
+	}
+
+	free_round_stats(&stats);
+
+	// The speculative columns of all processes
+	if (args.pipeline && !args.lazy)
+	{
+		MPI_Reduce(rank == ROOT_RANK ? MPI_IN_PLACE : speculative_stats,
+				   speculative_stats, 2, MPI_UINT64_T, MPI_SUM, ROOT_RANK,
+				   comm);
+	}
+
 	if (rank == ROOT_RANK)
 	{
 		fprintf(stdout, "Solution: { ");
@@ -589,10 +1541,10 @@ show_solution:
 		uint64_t current_attribute = 0;
 		uint64_t solution_size	   = 0;
 
-		for (uint64_t w = 0; w < dataset.n_words; w++)
+		for (uint64_t w = 0; w < attributes_map.n_words; w++)
 		{
 			for (int8_t bit = WORD_BITS - 1;
-				 bit >= 0 && current_attribute < dataset.n_attributes;
+				 bit >= 0 && current_attribute < attributes_map.n_attributes;
 				 bit--, current_attribute++)
 			{
 				if (selected_attributes[w] & AND_MASK_TABLE[bit])
@@ -605,34 +1557,294 @@ show_solution:
 		}
 
 		fprintf(stdout, "}\nSolution has %lu attributes: %lu / %lu = %3.4f%%\n",
-				solution_size, solution_size, dataset.n_attributes,
-				((float) solution_size / (float) dataset.n_attributes) * 100);
+				solution_size, solution_size, attributes_map.n_attributes,
+				((float) solution_size / (float) attributes_map.n_attributes)
+					* 100);
+
+		if (!args.lazy)
+		{
+			fprintf(stdout, "Totals reductions: %lu sparse, %lu dense\n",
+					totals_reduce.n_sparse, totals_reduce.n_dense);
+		}
+
+		if (args.pipeline && !args.lazy)
+		{
+			fprintf(stdout, "Speculative columns: %lu used, %lu discarded\n",
+					speculative_stats[1], speculative_stats[0]);
+		}
 
 		fprintf(stdout, "All done! ");
 
-		free(global_attribute_totals);
-		global_attribute_totals = NULL;
+		if (result != NULL)
+		{
+			*result = get_batch_result(args.filename, args.datasetname,
+									   &attributes_map, selected_attributes);
+			assert(*result != NULL);
+		}
 
 		free(selected_attributes);
 		selected_attributes = NULL;
 	}
 
+	free(global_attribute_totals);
+	global_attribute_totals = NULL;
+
+	free(live_attribute_words);
+	live_attribute_words = NULL;
+
+	free_totals_reduce(&totals_reduce);
+
+	if (use_offload)
+	{
+		free_offload(&offload);
+	}
+
 	free(covered_lines);
 	covered_lines = NULL;
 
 	free(best_column);
 	best_column = NULL;
 
+	free(speculative_column);
+	speculative_column = NULL;
+
 	free(attribute_totals);
 	attribute_totals = NULL;
 
-	// Free shared dataset
-	MPI_Win_free(&win_shared_dset);
+	free(dm_cache);
+	dm_cache = NULL;
+
+	free_dm_threads(&dm_threads);
+
+	free_attributes_map(&attributes_map);
+
+	// The shared windows are kept for the next dataset
+	unmap_dataset_data(&data_mapping);
 	dataset.data = NULL;
+
 	free_dataset(&dataset);
 
 	PRINT_TIMING_GLOBAL;
 
+	return EXIT_SUCCESS;
+}
+
+/**
+ * Runs the set cover of the dataset given by the user or, in batch mode, of
+ * every dataset of the manifest. The processes of a group run the same
+ * dataset, and the node and roots communicators and the shared windows are
+ * kept between the datasets of the group
+ */
+int main(int argc, char** argv)
+{
+	/**
+	 * Command line arguments set by the user
+	 */
+	clargs_t args;
+
+	/**
+	 * Parse command line arguments
+	 */
+	if (read_args(argc, argv, &args) == READ_CL_ARGS_NOK)
+	{
+		return EXIT_FAILURE;
+	}
+
+	/**
+	 * Select the XOR kernels for this CPU
+	 */
+	if (select_xor_kernels(args.kernels) != OK)
+	{
+		return EXIT_FAILURE;
+	}
+
+	/*
+	 * Initialize MPI
+	 * Only the master thread makes MPI calls
+	 */
+	int thread_support = MPI_THREAD_SINGLE;
+	if (MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &thread_support)
+		!= MPI_SUCCESS)
+	{
+		printf("Error initializing MPI environment!\n");
+		return EXIT_FAILURE;
+	}
+
+	/**
+	 * Rank of process
+	 */
+	int rank;
+
+	/**
+	 * Number of processes
+	 */
+	int size;
+
+	/**
+	 * Global communicator group
+	 */
+	MPI_Comm comm = MPI_COMM_WORLD;
+
+	/**
+	 * Setup global rank and size
+	 */
+	MPI_Comm_size(comm, &size);
+	MPI_Comm_rank(comm, &rank);
+
+	/**
+	 * Number of processes on this node, whatever their batch group, that
+	 * share its cores
+	 */
+	int host_size;
+	MPI_Comm host_comm;
+	MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL,
+						&host_comm);
+	MPI_Comm_size(host_comm, &host_size);
+	MPI_Comm_free(&host_comm);
+
+	/**
+	 * Number of OpenMP threads in each process
+	 */
+	uint64_t n_threads = get_n_threads(host_size);
+
+	if (thread_support < MPI_THREAD_FUNNELED)
+	{
+		n_threads = 1;
+	}
+
+	/**
+	 * The datasets of the batch run
+	 */
+	batch_t batch;
+
+	/**
+	 * Number of groups that run the batch datasets
+	 */
+	uint64_t n_groups = 1;
+
+	/**
+	 * Communicator of the processes that run the same dataset
+	 */
+	MPI_Comm group_comm = comm;
+
+	/**
+	 * Rank of process in group_comm
+	 */
+	int group_rank = rank;
+
+	if (args.batch != NULL)
+	{
+		if (read_batch(comm, args.batch, &batch) != OK)
+		{
+			return EXIT_FAILURE;
+		}
+
+		n_groups = args.batch_groups < (uint64_t) size ? args.batch_groups
+													   : (uint64_t) size;
+
+		// Consecutive ranks share a group, so the groups keep to a node
+		MPI_Comm_split(comm, (int) ((uint64_t) rank * n_groups / size), rank,
+					   &group_comm);
+		MPI_Comm_rank(group_comm, &group_rank);
+	}
+
+	/**
+	 * Node communicator group
+	 */
+	MPI_Comm node_comm = MPI_COMM_NULL;
+
+	/**
+	 * Create node-local communicator
+	 * This communicator is used to share memory with processes intranode
+	 */
+	MPI_Comm_split_type(group_comm, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL,
+						&node_comm);
+
+	/**
+	 * In-node rank of process
+	 */
+	int node_rank;
+	MPI_Comm_rank(node_comm, &node_rank);
+
+	/**
+	 * Communicator of the node roots, the processes that read the dataset
+	 */
+	MPI_Comm roots_comm = MPI_COMM_NULL;
+	MPI_Comm_split(group_comm, node_rank == LOCAL_ROOT_RANK ? 0 : MPI_UNDEFINED,
+				   rank, &roots_comm);
+
+	/**
+	 * The shared dataset and transposed dataset, kept between the datasets
+	 * of a batch
+	 */
+	shared_window_t dset_window;
+	shared_window_t columns_window;
+	init_shared_window(&dset_window);
+	init_shared_window(&columns_window);
+
+	if (args.batch == NULL)
+	{
+		if (run_laid(args, comm, node_comm, roots_comm, n_threads,
+					 &dset_window, &columns_window, NULL)
+			!= EXIT_SUCCESS)
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	else
+	{
+		/**
+		 * Timing for the full batch
+		 */
+		SETUP_TIMING_GLOBAL;
+
+		ROOT_SHOWS("Running %lu dataset(s)", batch.n_entries);
+		ROOT_SHOWS(" in %lu group(s)\n\n", n_groups);
+
+		for (int64_t e = get_next_batch_entry(group_comm, &batch); e >= 0;
+			 e = get_next_batch_entry(group_comm, &batch))
+		{
+			args.filename	 = batch.filenames[e];
+			args.datasetname = batch.datasetnames[e];
+
+			int status = run_laid(args, group_comm, node_comm, roots_comm,
+								  n_threads, &dset_window, &columns_window,
+								  &batch.results[e]);
+
+			// The failure is recorded and the next dataset is run
+			if (status == EXIT_NOT_OPENED && group_rank == ROOT_RANK)
+			{
+				batch.results[e]
+					= get_batch_failure(args.filename, args.datasetname);
+			}
+			else if (status != EXIT_SUCCESS && status != EXIT_NOT_OPENED)
+			{
+				return EXIT_FAILURE;
+			}
+		}
+
+		if (write_batch_results(comm, &batch, args.batch_results) != OK)
+		{
+			return EXIT_FAILURE;
+		}
+
+		ROOT_SHOWS("\nBatch results saved as '%s'\n", args.batch_results);
+		ROOT_SAYS("Batch done! ");
+		PRINT_TIMING_GLOBAL;
+
+		free_batch(&batch);
+		MPI_Comm_free(&group_comm);
+	}
+
+	// Free shared dataset
+	free_shared_window(&dset_window);
+	free_shared_window(&columns_window);
+
+	if (roots_comm != MPI_COMM_NULL)
+	{
+		MPI_Comm_free(&roots_comm);
+	}
+
 	/* shut down MPI */
 	MPI_Finalize();
 
@@ -8,13 +8,17 @@
 
 #include "set_cover.h"
 
+#include "disjoint_matrix_mpi.h"
 #include "types/class_offsets_t.h"
 #include "types/dataset_t.h"
+#include "types/dm_segment_t.h"
 #include "types/dm_t.h"
+#include "types/dm_threads_t.h"
 #include "types/oknok_t.h"
 #include "types/word_t.h"
 #include "utils/bit.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -36,262 +40,196 @@ int64_t get_best_attribute_index(const uint64_t* totals,
 	return max_attribute;
 }
 
-oknok_t calculate_initial_attribute_totals(const dataset_t* dataset,
-										   const dm_t* dm, uint64_t* totals)
+oknok_t update_live_attribute_words(const dataset_t* dataset,
+									const uint64_t* global_totals,
+									word_t* live_words, dm_t* dm,
+									dm_threads_t* threads)
 {
-	// Reset attributes totals
-	memset(totals, 0, dataset->n_attributes * sizeof(uint64_t));
+	uint64_t n_words	  = dataset->n_words;
+	uint64_t n_attributes = dataset->n_attributes;
 
-	uint64_t nc	   = dataset->n_classes;
-	uint64_t nobs  = dataset->n_observations;
-	word_t** opc   = dataset->observations_per_class;
-	uint64_t* nopc = dataset->n_observations_per_class;
+	memset(live_words, 0,
+		   (n_words / WORD_BITS + (n_words % WORD_BITS != 0))
+			   * sizeof(word_t));
 
-	for (uint64_t cw = 0; cw < dataset->n_words; cw += N_WORDS_PER_CYCLE)
+	for (uint64_t w = 0; w < n_words; w++)
 	{
-
-		uint64_t ew = cw + N_WORDS_PER_CYCLE;
-		if (ew > dataset->n_words)
+		uint64_t end = (w + 1) * WORD_BITS;
+		if (end > n_attributes)
 		{
-			ew = dataset->n_words;
+			end = n_attributes;
 		}
 
-		uint64_t ca = dm->initial_class_offsets.classA;
-		uint64_t ia = dm->initial_class_offsets.indexA;
-		uint64_t cb = dm->initial_class_offsets.classB;
-		uint64_t ib = dm->initial_class_offsets.indexB;
-
-		uint64_t cl = 0;
-
-		while (ca < nc - 1 && cl < dm->s_size)
+		for (uint64_t a = w * WORD_BITS; a < end; a++)
 		{
-			while (ia < nopc[ca] && cl < dm->s_size)
+			if (global_totals[a] != 0)
 			{
-				while (cb < nc && cl < dm->s_size)
-				{
-					while (ib < nopc[cb] && cl < dm->s_size)
-					{
-						// Add attributes totals
-
-						word_t** bla = opc + ca * nobs;
-						word_t* la	 = *(bla + ia);
-						word_t** blb = opc + cb * nobs;
-						word_t* lb	 = *(blb + ib);
-
-						/**
-						 * Current attribute
-						 */
-						uint64_t catt = cw * WORD_BITS;
-
-						// Process words
-						for (uint64_t ccw = cw; ccw < ew; ccw++)
-						{
-							word_t lxor = la[ccw] ^ lb[ccw];
-
-							for (int8_t bit = WORD_BITS - 1; bit >= 0;
-								 bit--, catt++)
-							{
-								totals[catt] += BIT_CHECK(lxor, bit);
-							}
-						}
-
-						ib++;
-						cl++;
-					}
-					cb++;
-					ib = 0;
-				}
-				ia++;
-				cb = ca + 1;
-				ib = 0;
+				BIT_SET(live_words[w / WORD_BITS],
+						WORD_BITS - w % WORD_BITS - 1);
+				break;
 			}
-			ca++;
-			ia = 0;
-			cb = ca + 1;
-			ib = 0;
 		}
 	}
 
+	dm->live_attribute_words = live_words;
+
+	for (uint64_t t = 0; t < threads->n_threads; t++)
+	{
+		threads->dms[t].live_attribute_words = live_words;
+	}
+
 	return OK;
 }
 
-oknok_t calculate_attribute_totals_add(const dataset_t* dataset, const dm_t* dm,
-									   const word_t* covered_lines,
-									   uint64_t* totals)
+bool is_live_attribute_word(const dm_t* dm, const uint64_t w)
 {
-	// Reset attributes totals
-	memset(totals, 0, dataset->n_attributes * sizeof(uint64_t));
+	return dm->live_attribute_words == NULL
+		|| BIT_CHECK(dm->live_attribute_words[w / WORD_BITS],
+					 WORD_BITS - w % WORD_BITS - 1);
+}
 
-	uint64_t nc	   = dataset->n_classes;
-	uint64_t nobs  = dataset->n_observations;
-	word_t** opc   = dataset->observations_per_class;
-	uint64_t* nopc = dataset->n_observations_per_class;
+bool get_totals_cycle(const dataset_t* dataset, const dm_t* dm,
+					  const uint64_t from, uint64_t* cw, uint64_t* ew)
+{
+	uint64_t n_words = dataset->n_words;
 
-	for (uint64_t cw = 0; cw < dataset->n_words; cw += N_WORDS_PER_CYCLE)
+	uint64_t w = from;
+	while (w < n_words && !is_live_attribute_word(dm, w))
 	{
+		w++;
+	}
 
-		uint64_t ew = cw + N_WORDS_PER_CYCLE;
-		if (ew > dataset->n_words)
+	if (w == n_words)
+	{
+		return false;
+	}
+
+	*cw = w;
+	*ew = w + 1;
+
+	for (w++; w < *cw + N_WORDS_PER_CYCLE && w < n_words; w++)
+	{
+		if (is_live_attribute_word(dm, w))
 		{
-			ew = dataset->n_words;
+			*ew = w + 1;
 		}
+	}
 
-		uint64_t ca = dm->initial_class_offsets.classA;
-		uint64_t ia = dm->initial_class_offsets.indexA;
-		uint64_t cb = dm->initial_class_offsets.classB;
-		uint64_t ib = dm->initial_class_offsets.indexB;
+	return true;
+}
+
+/**
+ * Adds (or subtracts) the bits of the lines of dm to the totals of the
+ * attributes of words [cw, ew). If lines is not NULL only the lines with
+ * the bit equal to set are counted
+ */
+static void count_lines(const dataset_t* dataset, const dm_t* dm,
+						const word_t* lines, const bool set,
+						const bool subtract, const uint64_t cw,
+						const uint64_t ew, uint64_t* totals)
+{
+	uint64_t stride = dataset->line_stride;
+	word_t** opc	= dataset->observations_per_class;
+
+	dm_segment_t segment;
 
-		uint64_t cl = 0;
+	for (bool more = first_dm_segment(dataset, dm, &segment); more;
+		 more = next_dm_segment(dataset, dm, &segment))
+	{
+		word_t* la = opc[segment.classA] + segment.indexA * stride;
+		word_t* lb = opc[segment.classB] + segment.indexB * stride;
 
-		while (ca < nc - 1 && cl < dm->s_size)
+		for (uint64_t i = 0; i < segment.n_lines; i++, lb += stride)
 		{
-			while (ia < nopc[ca] && cl < dm->s_size)
+			if (lines != NULL)
 			{
-				while (cb < nc && cl < dm->s_size)
+				uint64_t cl		 = segment.line + i;
+				uint64_t cl_word = cl / WORD_BITS;
+				uint8_t cl_bit	 = WORD_BITS - cl % WORD_BITS - 1;
+
+				if (BIT_CHECK(lines[cl_word], cl_bit) != set)
 				{
-					while (ib < nopc[cb] && cl < dm->s_size)
+					continue;
+				}
+			}
+
+			/**
+			 * Current attribute
+			 */
+			uint64_t catt = cw * WORD_BITS;
+
+			// Process words
+			for (uint64_t ccw = cw; ccw < ew; ccw++)
+			{
+				word_t lxor = la[ccw] ^ lb[ccw];
+
+				for (int8_t bit = WORD_BITS - 1; bit >= 0; bit--, catt++)
+				{
+					if (subtract)
+					{
+						totals[catt] -= BIT_CHECK(lxor, bit);
+					}
+					else
 					{
-						/**
-						 * Is this line covered?
-						 * Yes: skip
-						 * No: add
-						 */
-						uint64_t cl_word = cl / WORD_BITS;
-						uint8_t cl_bit	 = WORD_BITS - cl % WORD_BITS - 1;
-
-						// Is this line not covered?
-						if (!BIT_CHECK(covered_lines[cl_word], cl_bit))
-						{
-							// This line is uncovered: calculate attributes
-							// totals
-
-							word_t** bla = opc + ca * nobs;
-							word_t* la	 = *(bla + ia);
-							word_t** blb = opc + cb * nobs;
-							word_t* lb	 = *(blb + ib);
-
-							/**
-							 * Current attribute
-							 */
-							uint64_t catt = cw * WORD_BITS;
-
-							// Process words
-							for (uint64_t ccw = cw; ccw < ew; ccw++)
-							{
-								word_t lxor = la[ccw] ^ lb[ccw];
-
-								for (int8_t bit = WORD_BITS - 1; bit >= 0;
-									 bit--, catt++)
-								{
-									totals[catt] += BIT_CHECK(lxor, bit);
-								}
-							}
-						}
-
-						ib++;
-						cl++;
+						totals[catt] += BIT_CHECK(lxor, bit);
 					}
-					cb++;
-					ib = 0;
 				}
-				ia++;
-				cb = ca + 1;
-				ib = 0;
 			}
-			ca++;
-			ia = 0;
-			cb = ca + 1;
-			ib = 0;
 		}
 	}
-
-	return OK;
 }
-oknok_t calculate_attribute_totals_sub(const dataset_t* dataset, const dm_t* dm,
-									   const word_t* covered_lines,
-									   uint64_t* totals)
-{
-	uint64_t nc	   = dataset->n_classes;
-	uint64_t nobs  = dataset->n_observations;
-	word_t** opc   = dataset->observations_per_class;
-	uint64_t* nopc = dataset->n_observations_per_class;
 
+/**
+ * Updates the totals with count_lines, N_WORDS_PER_CYCLE words at a time.
+ * Every word is visited, so the totals of the kernels, that skip the dead
+ * words, are checked against these in DEBUG builds
+ */
+static void calculate_totals(const dataset_t* dataset, const dm_t* dm,
+							 const word_t* lines, const bool set,
+							 const bool subtract, uint64_t* totals)
+{
 	for (uint64_t cw = 0; cw < dataset->n_words; cw += N_WORDS_PER_CYCLE)
 	{
-
 		uint64_t ew = cw + N_WORDS_PER_CYCLE;
 		if (ew > dataset->n_words)
 		{
 			ew = dataset->n_words;
 		}
 
-		uint64_t ca = dm->initial_class_offsets.classA;
-		uint64_t ia = dm->initial_class_offsets.indexA;
-		uint64_t cb = dm->initial_class_offsets.classB;
-		uint64_t ib = dm->initial_class_offsets.indexB;
+		count_lines(dataset, dm, lines, set, subtract, cw, ew, totals);
+	}
+}
 
-		uint64_t cl = 0;
+oknok_t calculate_initial_attribute_totals(const dataset_t* dataset,
+										   const dm_t* dm, uint64_t* totals)
+{
+	// Reset attributes totals
+	memset(totals, 0, dataset->n_attributes * sizeof(uint64_t));
 
-		while (ca < nc - 1 && cl < dm->s_size)
-		{
-			while (ia < nopc[ca] && cl < dm->s_size)
-			{
-				while (cb < nc && cl < dm->s_size)
-				{
-					while (ib < nopc[cb] && cl < dm->s_size)
-					{
-						/**
-						 * Is this line covered?
-						 * Yes: sub
-						 * No: skip
-						 */
-						uint64_t clw = cl / WORD_BITS;
-						uint8_t clb	 = WORD_BITS - cl % WORD_BITS - 1;
-
-						// Is this line not covered?
-						if (BIT_CHECK(covered_lines[clw], clb))
-						{
-							// This line is covered: calculate attributes totals
-
-							word_t** bla = opc + ca * nobs;
-							word_t* la	 = *(bla + ia);
-							word_t** blb = opc + cb * nobs;
-							word_t* lb	 = *(blb + ib);
-
-							/**
-							 * Current attribute
-							 */
-							uint64_t catt = cw * WORD_BITS;
-
-							// Process words
-							for (uint64_t ccw = cw; ccw < ew; ccw++)
-							{
-								word_t lxor = la[ccw] ^ lb[ccw];
-
-								for (int8_t bit = WORD_BITS - 1; bit >= 0;
-									 bit--, catt++)
-								{
-									totals[catt] -= BIT_CHECK(lxor, bit);
-								}
-							}
-						}
-
-						ib++;
-						cl++;
-					}
-					cb++;
-					ib = 0;
-				}
-				ia++;
-				cb = ca + 1;
-				ib = 0;
-			}
-			ca++;
-			ia = 0;
-			cb = ca + 1;
-			ib = 0;
-		}
-	}
+	calculate_totals(dataset, dm, NULL, false, false, totals);
+
+	return OK;
+}
+
+oknok_t calculate_attribute_totals_add(const dataset_t* dataset, const dm_t* dm,
+									   const word_t* covered_lines,
+									   uint64_t* totals)
+{
+	// Reset attributes totals
+	memset(totals, 0, dataset->n_attributes * sizeof(uint64_t));
+
+	// Only the lines that are not covered
+	calculate_totals(dataset, dm, covered_lines, false, false, totals);
+
+	return OK;
+}
+
+oknok_t calculate_attribute_totals_sub(const dataset_t* dataset, const dm_t* dm,
+									   const word_t* covered_lines,
+									   uint64_t* totals)
+{
+	// Only the lines that are covered
+	calculate_totals(dataset, dm, covered_lines, true, true, totals);
 
 	return OK;
 }
@@ -12,9 +12,11 @@
 #include "types/class_offsets_t.h"
 #include "types/dataset_t.h"
 #include "types/dm_t.h"
+#include "types/dm_threads_t.h"
 #include "types/oknok_t.h"
 #include "types/word_t.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
 /**
@@ -30,6 +32,35 @@
 int64_t get_best_attribute_index(const uint64_t* totals,
 								 const uint64_t n_attributes);
 
+/**
+ * An attribute with a global total of 0 covers none of the uncovered lines,
+ * so its total stays 0 until the end. The words of the dataset lines where
+ * every attribute has a global total of 0 are marked as dead in
+ * live_words (one bit for each dataset word), and the totals of dm and of
+ * the parts of threads skip them from then on.
+ * Every process has the same global totals, so they all skip the same
+ * words
+ */
+oknok_t update_live_attribute_words(const dataset_t* dataset,
+									const uint64_t* global_totals,
+									word_t* live_words, dm_t* dm,
+									dm_threads_t* threads);
+
+/**
+ * Checks if the attributes of word w of the dataset lines are visited by dm
+ */
+bool is_live_attribute_word(const dm_t* dm, const uint64_t w);
+
+/**
+ * Finds the next cycle of words of the dataset lines whose totals are
+ * calculated in the same pass over the lines of dm. The cycle [cw, ew)
+ * starts on the first live attribute word at or after from and ends after
+ * the last live word of the next N_WORDS_PER_CYCLE.
+ * Returns false if there are no more live words
+ */
+bool get_totals_cycle(const dataset_t* dataset, const dm_t* dm,
+					  const uint64_t from, uint64_t* cw, uint64_t* ew);
+
 /**
  * Calculates the current attributes totals
  */
@@ -0,0 +1,272 @@
+/*
+ ============================================================================
+ Name        : set_cover_checkpoint.c
+ Author      : Eduardo Ribeiro
+ Description : Saves the set cover state and restarts from it
+ ============================================================================
+ */
+
+#include "set_cover_checkpoint.h"
+
+#include "dataset_hdf5.h"
+#include "disjoint_matrix_balance.h"
+#include "disjoint_matrix_cache.h"
+#include "set_cover.h"
+#include "set_cover_omp.h"
+#include "types/attributes_map_t.h"
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/bit.h"
+#include "utils/ranks.h"
+
+#include "hdf5.h"
+#include "mpi.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Suffix of the file being written
+ */
+#define CHECKPOINT_TMP_SUFFIX ".tmp"
+
+oknok_t write_checkpoint(const char* filename, const attributes_map_t* map,
+						 const dm_t* dm, const word_t* selected_attributes,
+						 const uint64_t n_uncovered_lines)
+{
+	size_t length = strlen(filename) + strlen(CHECKPOINT_TMP_SUFFIX) + 1;
+
+	char* tmp_filename = (char*) malloc(length);
+	if (tmp_filename == NULL)
+	{
+		return NOK;
+	}
+
+	snprintf(tmp_filename, length, "%s%s", filename, CHECKPOINT_TMP_SUFFIX);
+
+	hid_t file_id
+		= H5Fcreate(tmp_filename, H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+	if (file_id < 1)
+	{
+		fprintf(stderr, "Error creating file %s\n", tmp_filename);
+		free(tmp_filename);
+		return NOK;
+	}
+
+	hsize_t n_words = map->n_words;
+	hid_t space_id	= H5Screate_simple(1, &n_words, NULL);
+
+	hid_t dataset_id
+		= H5Dcreate(file_id, CHECKPOINT_SELECTED_DATASET, H5T_STD_U64LE,
+					space_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+	H5Sclose(space_id);
+
+	oknok_t status = dataset_id < 1 ? NOK : OK;
+
+	if (status == OK
+		&& H5Dwrite(dataset_id, H5T_NATIVE_UINT64, H5S_ALL, H5S_ALL,
+					H5P_DEFAULT, selected_attributes)
+			< 0)
+	{
+		status = NOK;
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id, N_ATTRIBUTES_ATTR,
+									  H5T_NATIVE_UINT64, 1, &map->n_attributes);
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id,
+									  CHECKPOINT_N_MATRIX_LINES_ATTR,
+									  H5T_NATIVE_UINT64, 1, &dm->n_matrix_lines);
+	}
+
+	if (status == OK)
+	{
+		status = hdf5_write_attribute(dataset_id,
+									  CHECKPOINT_N_UNCOVERED_LINES_ATTR,
+									  H5T_NATIVE_UINT64, 1, &n_uncovered_lines);
+	}
+
+	if (dataset_id >= 1)
+	{
+		H5Dclose(dataset_id);
+	}
+	H5Fclose(file_id);
+
+	if (status == OK && rename(tmp_filename, filename) != 0)
+	{
+		status = NOK;
+	}
+
+	if (status != OK)
+	{
+		fprintf(stderr, "Error writing checkpoint %s\n", filename);
+		remove(tmp_filename);
+	}
+
+	free(tmp_filename);
+
+	return status;
+}
+
+/**
+ * Reads the selected attributes and the number of uncovered lines from the
+ * checkpoint file, checking that it belongs to this dataset
+ */
+static oknok_t read_checkpoint(const char* filename,
+							   const attributes_map_t* map, const dm_t* dm,
+							   word_t* selected_attributes,
+							   uint64_t* n_uncovered_lines)
+{
+	hid_t file_id = H5Fopen(filename, H5F_ACC_RDONLY, H5P_DEFAULT);
+	if (file_id < 1)
+	{
+		fprintf(stderr, "Error opening checkpoint %s\n", filename);
+		return NOK;
+	}
+
+	hid_t dataset_id = H5Dopen(file_id, CHECKPOINT_SELECTED_DATASET,
+							   H5P_DEFAULT);
+	if (dataset_id < 1)
+	{
+		fprintf(stderr, "Checkpoint %s has no selected attributes\n",
+				filename);
+		H5Fclose(file_id);
+		return NOK;
+	}
+
+	uint64_t n_attributes	= 0;
+	uint64_t n_matrix_lines = 0;
+
+	oknok_t status = OK;
+
+	if (hdf5_read_attribute(dataset_id, N_ATTRIBUTES_ATTR, H5T_NATIVE_UINT64,
+							&n_attributes)
+			!= OK
+		|| hdf5_read_attribute(dataset_id, CHECKPOINT_N_MATRIX_LINES_ATTR,
+							   H5T_NATIVE_UINT64, &n_matrix_lines)
+			!= OK
+		|| hdf5_read_attribute(dataset_id, CHECKPOINT_N_UNCOVERED_LINES_ATTR,
+							   H5T_NATIVE_UINT64, n_uncovered_lines)
+			!= OK)
+	{
+		status = NOK;
+	}
+	else if (n_attributes != map->n_attributes
+			 || n_matrix_lines != dm->n_matrix_lines)
+	{
+		fprintf(stderr, "Checkpoint %s is from another dataset\n", filename);
+		status = NOK;
+	}
+	else if (hdf5_read_dataset_data(dataset_id, selected_attributes) != OK)
+	{
+		status = NOK;
+	}
+
+	H5Dclose(dataset_id);
+	H5Fclose(file_id);
+
+	return status;
+}
+
+oknok_t resume_checkpoint(MPI_Comm comm, const char* filename,
+						  const dataset_t* dataset,
+						  const attributes_map_t* map, const dm_t* dm,
+						  const dm_threads_t* threads, const word_t* cache,
+						  word_t* selected_attributes, word_t* covered_lines,
+						  word_t* column, uint64_t* n_uncovered_lines,
+						  uint64_t* n_selected)
+{
+	int rank;
+	MPI_Comm_rank(comm, &rank);
+
+	// Every process needs the selected attributes to cover its lines
+	word_t* selected = (word_t*) calloc(map->n_words, sizeof(word_t));
+	if (selected == NULL)
+	{
+		return NOK;
+	}
+
+	int status = OK;
+
+	if (rank == ROOT_RANK)
+	{
+		status = read_checkpoint(filename, map, dm, selected,
+								 n_uncovered_lines);
+	}
+
+	MPI_Bcast(&status, 1, MPI_INT, ROOT_RANK, comm);
+	if (status != OK)
+	{
+		free(selected);
+		return NOK;
+	}
+
+	MPI_Bcast(selected, map->n_words, MPI_UINT64_T, ROOT_RANK, comm);
+	MPI_Bcast(n_uncovered_lines, 1, MPI_UINT64_T, ROOT_RANK, comm);
+
+	*n_selected = 0;
+
+	// The checkpoint has the input attributes
+	for (uint64_t a = 0; a < map->n_attributes; a++)
+	{
+		if (!(selected[a / WORD_BITS]
+			  & AND_MASK_TABLE[WORD_BITS - 1 - a % WORD_BITS]))
+		{
+			continue;
+		}
+
+		(*n_selected)++;
+
+		// A removed attribute covers no lines
+		int64_t kept = map->kept[a];
+		if (kept < 0)
+		{
+			continue;
+		}
+
+		if (cache != NULL)
+		{
+			get_column_cached(dm, cache, kept, column);
+		}
+		else
+		{
+			get_column_omp(dataset, threads, kept, column);
+		}
+
+		update_covered_lines(column, dm->n_words_in_a_column, covered_lines);
+	}
+
+	if (rank == ROOT_RANK)
+	{
+		memcpy(selected_attributes, selected,
+			   map->n_words * sizeof(word_t));
+	}
+
+	free(selected);
+
+	// The selected attributes must cover the same lines as before
+	uint64_t n_uncovered = get_n_uncovered_lines(dm, covered_lines);
+	MPI_Allreduce(MPI_IN_PLACE, &n_uncovered, 1, MPI_UINT64_T, MPI_SUM, comm);
+
+	if (n_uncovered != *n_uncovered_lines)
+	{
+		if (rank == ROOT_RANK)
+		{
+			fprintf(stderr, "Checkpoint %s doesn't match the dataset\n",
+					filename);
+		}
+		return NOK;
+	}
+
+	return OK;
+}
@@ -0,0 +1,71 @@
+/*
+ ============================================================================
+ Name        : set_cover_checkpoint.h
+ Author      : Eduardo Ribeiro
+ Description : Saves the set cover state and restarts from it
+ ============================================================================
+ */
+
+#ifndef SET_COVER_CHECKPOINT_H
+#define SET_COVER_CHECKPOINT_H
+
+#include "types/attributes_map_t.h"
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include "mpi.h"
+
+#include <stdint.h>
+
+/**
+ * The checkpoint only stores the selected attributes. The covered lines of
+ * each process are the lines covered by those attributes, so they are
+ * generated again when the run is resumed, with any number of processes,
+ * and the attribute totals follow from the covered lines.
+ */
+
+/**
+ * Dataset with the selected attributes bit array
+ */
+#define CHECKPOINT_SELECTED_DATASET "selected_attributes"
+
+/**
+ * Attribute for number of lines of the disjoint matrix
+ */
+#define CHECKPOINT_N_MATRIX_LINES_ATTR "n_matrix_lines"
+
+/**
+ * Attribute for number of lines not covered by the selected attributes
+ */
+#define CHECKPOINT_N_UNCOVERED_LINES_ATTR "n_uncovered_lines"
+
+/**
+ * Writes the selected attributes to the checkpoint file, with the input
+ * attribute indexes of map.
+ * The file is written next to the old one and then renamed, so a job killed
+ * while writing keeps the previous checkpoint
+ */
+oknok_t write_checkpoint(const char* filename, const attributes_map_t* map,
+						 const dm_t* dm, const word_t* selected_attributes,
+						 const uint64_t n_uncovered_lines);
+
+/**
+ * Reads the checkpoint on the root and sets the covered lines of every
+ * process. selected_attributes is only used on the root, with the input
+ * attribute indexes of map.
+ * The number of lines covered in all the processes must match the
+ * checkpoint. The global number of uncovered lines is stored in
+ * n_uncovered_lines and the number of selected attributes in n_selected
+ */
+oknok_t resume_checkpoint(MPI_Comm comm, const char* filename,
+						  const dataset_t* dataset,
+						  const attributes_map_t* map, const dm_t* dm,
+						  const dm_threads_t* threads, const word_t* cache,
+						  word_t* selected_attributes, word_t* covered_lines,
+						  word_t* column, uint64_t* n_uncovered_lines,
+						  uint64_t* n_selected);
+
+#endif // SET_COVER_CHECKPOINT_H
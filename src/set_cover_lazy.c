@@ -0,0 +1,393 @@
+/*
+ ============================================================================
+ Name        : set_cover_lazy.c
+ Author      : Eduardo Ribeiro
+ Description : Lazy evaluation of the greedy set cover algorithm
+ ============================================================================
+ */
+
+#include "set_cover_lazy.h"
+
+#include "disjoint_matrix_cache.h"
+#include "set_cover_omp.h"
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/lazy_heap_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include "mpi.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Returns true if candidate a must be selected before candidate b
+ */
+static bool is_better_candidate(const lazy_candidate_t* a,
+								const lazy_candidate_t* b)
+{
+	return a->bound > b->bound
+		|| (a->bound == b->bound && a->attribute < b->attribute);
+}
+
+static void sift_down(lazy_heap_t* heap, uint64_t i)
+{
+	lazy_candidate_t* c = heap->candidates;
+
+	while (true)
+	{
+		uint64_t best  = i;
+		uint64_t left  = 2 * i + 1;
+		uint64_t right = 2 * i + 2;
+
+		if (left < heap->size && is_better_candidate(c + left, c + best))
+		{
+			best = left;
+		}
+
+		if (right < heap->size && is_better_candidate(c + right, c + best))
+		{
+			best = right;
+		}
+
+		if (best == i)
+		{
+			return;
+		}
+
+		lazy_candidate_t tmp = c[i];
+		c[i]				 = c[best];
+		c[best]				 = tmp;
+
+		i = best;
+	}
+}
+
+static void push_candidate(lazy_heap_t* heap, const lazy_candidate_t* candidate)
+{
+	lazy_candidate_t* c = heap->candidates;
+
+	uint64_t i = heap->size++;
+	c[i]	   = *candidate;
+
+	while (i > 0)
+	{
+		uint64_t parent = (i - 1) / 2;
+
+		if (!is_better_candidate(c + i, c + parent))
+		{
+			return;
+		}
+
+		lazy_candidate_t tmp = c[i];
+		c[i]				 = c[parent];
+		c[parent]			 = tmp;
+
+		i = parent;
+	}
+}
+
+static lazy_candidate_t pop_candidate(lazy_heap_t* heap)
+{
+	lazy_candidate_t top = heap->candidates[0];
+
+	heap->size--;
+	heap->candidates[0] = heap->candidates[heap->size];
+	sift_down(heap, 0);
+
+	return top;
+}
+
+/**
+ * Fills the heap with the attributes that cover some line, with bounds
+ * calculated on round
+ */
+static void fill_lazy_heap(const uint64_t* totals, const uint64_t n_attributes,
+						   const uint64_t round, lazy_heap_t* heap)
+{
+	heap->size = 0;
+
+	// Attributes that don't cover any line are never selected
+	for (uint64_t a = 0; a < n_attributes; a++)
+	{
+		if (totals[a] > 0)
+		{
+			lazy_candidate_t* c = heap->candidates + heap->size++;
+
+			c->bound	 = totals[a];
+			c->attribute = a;
+			c->round	 = round;
+		}
+	}
+
+	for (uint64_t i = heap->size / 2; i > 0; i--)
+	{
+		sift_down(heap, i - 1);
+	}
+}
+
+/**
+ * Returns the time elapsed since start, in nanoseconds.
+ * The times are summed as integers between processes, so every process gets
+ * exactly the same value and makes the same choices
+ */
+static uint64_t get_elapsed_ns(const double start)
+{
+	return (uint64_t) ((MPI_Wtime() - start) * 1e9);
+}
+
+oknok_t init_lazy_heap(MPI_Comm comm, const dataset_t* dataset,
+					   const dm_t* dm, dm_threads_t* threads,
+					   const word_t* cache, const word_t* covered_lines,
+					   uint64_t* totals, uint64_t* global_totals,
+					   lazy_heap_t* heap)
+{
+	heap->size			 = 0;
+	heap->full_pass_time = 0;
+	heap->candidates	 = (lazy_candidate_t*) malloc(dataset->n_attributes
+													  * sizeof(lazy_candidate_t));
+
+	if (heap->candidates == NULL)
+	{
+		return NOK;
+	}
+
+	double start = MPI_Wtime();
+
+	// The bounds of round 0 are taken as exact, so they can't count the
+	// lines covered before a resume
+	if (covered_lines != NULL && cache != NULL)
+	{
+		calculate_attribute_totals_add_cached(dataset, dm, threads->n_threads,
+											  cache, covered_lines, totals);
+	}
+	else if (covered_lines != NULL)
+	{
+		calculate_attribute_totals_add_omp(dataset, threads, covered_lines,
+										   totals);
+	}
+	else if (cache != NULL)
+	{
+		calculate_initial_attribute_totals_cached(
+			dataset, dm, threads->n_threads, cache, totals);
+	}
+	else
+	{
+		calculate_initial_attribute_totals_omp(dataset, threads, totals);
+	}
+
+	uint64_t elapsed = get_elapsed_ns(start);
+
+	MPI_Allreduce(totals, global_totals, dataset->n_attributes, MPI_UINT64_T,
+				  MPI_SUM, comm);
+	MPI_Allreduce(&elapsed, &heap->full_pass_time, 1, MPI_UINT64_T, MPI_SUM,
+				  comm);
+
+	fill_lazy_heap(global_totals, dataset->n_attributes, 0, heap);
+
+	return OK;
+}
+
+void free_lazy_heap(lazy_heap_t* heap)
+{
+	free(heap->candidates);
+	heap->candidates = NULL;
+	heap->size		 = 0;
+}
+
+/**
+ * Gets the column of attribute from the cache, or generates it if there is
+ * no cache
+ */
+static void get_candidate_column(const dataset_t* dataset, const dm_t* dm,
+								 const dm_threads_t* threads,
+								 const word_t* cache, const int64_t attribute,
+								 word_t* column)
+{
+	if (cache != NULL)
+	{
+		get_column_cached(dm, cache, attribute, column);
+	}
+	else
+	{
+		get_column_omp(dataset, threads, attribute, column);
+	}
+}
+
+/**
+ * Counts the lines of column not yet covered
+ */
+static uint64_t count_uncovered_lines(const word_t* column,
+									  const word_t* covered_lines,
+									  const uint64_t n_words)
+{
+	uint64_t total = 0;
+
+	for (uint64_t w = 0; w < n_words; w++)
+	{
+		total += __builtin_popcountll(column[w] & ~covered_lines[w]);
+	}
+
+	return total;
+}
+
+/**
+ * Calculates the exact totals of all attributes and rebuilds the heap
+ */
+static void refresh_lazy_heap(MPI_Comm comm, const dataset_t* dataset,
+							  const dm_t* dm, dm_threads_t* threads,
+							  const word_t* cache, const word_t* covered_lines,
+							  const uint64_t round, lazy_heap_t* heap,
+							  uint64_t* totals, uint64_t* global_totals)
+{
+	double start = MPI_Wtime();
+
+	if (cache != NULL)
+	{
+		calculate_attribute_totals_add_cached(dataset, dm, threads->n_threads,
+											  cache, covered_lines, totals);
+	}
+	else
+	{
+		calculate_attribute_totals_add_omp(dataset, threads, covered_lines,
+										   totals);
+	}
+
+	uint64_t elapsed = get_elapsed_ns(start);
+
+	MPI_Allreduce(totals, global_totals, dataset->n_attributes, MPI_UINT64_T,
+				  MPI_SUM, comm);
+	MPI_Allreduce(&elapsed, &heap->full_pass_time, 1, MPI_UINT64_T, MPI_SUM,
+				  comm);
+
+	fill_lazy_heap(global_totals, dataset->n_attributes, round, heap);
+}
+
+oknok_t get_lazy_best_attribute(MPI_Comm comm, const dataset_t* dataset,
+								const dm_t* dm, dm_threads_t* threads,
+								const word_t* cache,
+								const word_t* covered_lines,
+								const uint64_t round, lazy_heap_t* heap,
+								uint64_t* totals, uint64_t* global_totals,
+								int64_t* best_attribute, uint64_t* best_total,
+								word_t* best_column)
+{
+	uint64_t n_words = dm->n_words_in_a_column;
+
+	/**
+	 * The columns of the candidates evaluated together
+	 */
+	word_t* columns
+		= (word_t*) malloc(N_LAZY_CANDIDATES * n_words * sizeof(word_t));
+	if (columns == NULL && n_words > 0)
+	{
+		return NOK;
+	}
+
+	lazy_candidate_t candidates[N_LAZY_CANDIDATES];
+	uint64_t n_candidates = 0;
+
+	/**
+	 * The totals of the candidates, followed by the time spent evaluating
+	 * them
+	 */
+	uint64_t local_totals[N_LAZY_CANDIDATES + 1];
+	uint64_t global_candidate_totals[N_LAZY_CANDIDATES + 1];
+
+	/**
+	 * Time spent evaluating candidates on this round, summed over all
+	 * processes. Past a fraction of the last full pass time it's cheaper to
+	 * calculate all the totals again
+	 */
+	uint64_t max_time  = heap->full_pass_time / LAZY_FULL_PASS_RATIO;
+	uint64_t eval_time = 0;
+
+	// Every process makes the same choices, so all reach the same collectives
+	while (heap->size > 0 && heap->candidates[0].round != round)
+	{
+		if (eval_time >= max_time)
+		{
+			refresh_lazy_heap(comm, dataset, dm, threads, cache,
+							  covered_lines, round, heap, totals,
+							  global_totals);
+			n_candidates = 0;
+			break;
+		}
+
+		n_candidates = 0;
+
+		while (n_candidates < N_LAZY_CANDIDATES && heap->size > 0
+			   && heap->candidates[0].round != round)
+		{
+			candidates[n_candidates++] = pop_candidate(heap);
+		}
+
+		double start = MPI_Wtime();
+
+		for (uint64_t i = 0; i < n_candidates; i++)
+		{
+			word_t* column = columns + i * n_words;
+
+			get_candidate_column(dataset, dm, threads, cache,
+								 candidates[i].attribute, column);
+
+			local_totals[i]
+				= count_uncovered_lines(column, covered_lines, n_words);
+		}
+
+		local_totals[n_candidates] = get_elapsed_ns(start);
+
+		MPI_Allreduce(local_totals, global_candidate_totals, n_candidates + 1,
+					  MPI_UINT64_T, MPI_SUM, comm);
+
+		for (uint64_t i = 0; i < n_candidates; i++)
+		{
+			if (global_candidate_totals[i] > 0)
+			{
+				candidates[i].bound = global_candidate_totals[i];
+				candidates[i].round = round;
+
+				push_candidate(heap, candidates + i);
+			}
+		}
+
+		eval_time += global_candidate_totals[n_candidates];
+	}
+
+	if (heap->size == 0)
+	{
+		*best_attribute = -1;
+		*best_total		= 0;
+
+		free(columns);
+		return OK;
+	}
+
+	lazy_candidate_t best = pop_candidate(heap);
+
+	*best_attribute = best.attribute;
+	*best_total		= best.bound;
+
+	// Reuse the column if it was evaluated on the last pass
+	for (uint64_t i = 0; i < n_candidates; i++)
+	{
+		if (candidates[i].attribute == best.attribute)
+		{
+			memcpy(best_column, columns + i * n_words,
+				   n_words * sizeof(word_t));
+
+			free(columns);
+			return OK;
+		}
+	}
+
+	get_candidate_column(dataset, dm, threads, cache, best.attribute,
+						 best_column);
+
+	free(columns);
+	return OK;
+}
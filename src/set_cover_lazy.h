@@ -0,0 +1,83 @@
+/*
+ ============================================================================
+ Name        : set_cover_lazy.h
+ Author      : Eduardo Ribeiro
+ Description : Lazy evaluation of the greedy set cover algorithm
+ ============================================================================
+ */
+
+#ifndef SET_COVER_LAZY_H
+#define SET_COVER_LAZY_H
+
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/lazy_heap_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include "mpi.h"
+
+#include <stdint.h>
+
+/**
+ * Number of candidates evaluated with each MPI_Allreduce
+ */
+#define N_LAZY_CANDIDATES 4
+
+/**
+ * Each round spends at most 1 / LAZY_FULL_PASS_RATIO of the time of a full
+ * totals pass evaluating candidates, before calculating the totals of all
+ * attributes again
+ */
+#define LAZY_FULL_PASS_RATIO 4
+
+/**
+ * The attribute totals can only go down from one round to the next, so the
+ * totals from previous rounds are upper bounds for the current totals.
+ *
+ * Every process keeps the same heap of upper bounds. On each round the top
+ * candidates are evaluated, each process counting the uncovered lines of the
+ * candidate column, until the best candidate has an exact total.
+ * Ties are broken by the lowest attribute index, so the solution is the same
+ * as the one from get_best_attribute_index.
+ *
+ * If evaluating the candidates of one round takes too long, the totals of
+ * all attributes are calculated again and the heap is rebuilt.
+ */
+
+/**
+ * Calculates the initial attributes totals and builds the heap from the
+ * global totals, that are stored in global_totals.
+ * If covered_lines is not NULL, like after a resume, only the lines not yet
+ * covered are counted
+ */
+oknok_t init_lazy_heap(MPI_Comm comm, const dataset_t* dataset,
+					   const dm_t* dm, dm_threads_t* threads,
+					   const word_t* cache, const word_t* covered_lines,
+					   uint64_t* totals, uint64_t* global_totals,
+					   lazy_heap_t* heap);
+
+/**
+ * Frees the heap memory
+ */
+void free_lazy_heap(lazy_heap_t* heap);
+
+/**
+ * Searches the heap for the best attribute of round and removes it from the
+ * heap. The column of the attribute is stored in best_column and its global
+ * total in best_total.
+ * Returns -1 in best_attribute if there are no more attributes available.
+ * If cache is not NULL the columns are read from it.
+ * The totals and global_totals arrays are used when the heap is rebuilt.
+ */
+oknok_t get_lazy_best_attribute(MPI_Comm comm, const dataset_t* dataset,
+								const dm_t* dm, dm_threads_t* threads,
+								const word_t* cache,
+								const word_t* covered_lines,
+								const uint64_t round, lazy_heap_t* heap,
+								uint64_t* totals, uint64_t* global_totals,
+								int64_t* best_attribute, uint64_t* best_total,
+								word_t* best_column);
+
+#endif // SET_COVER_LAZY_H
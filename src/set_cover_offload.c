@@ -0,0 +1,421 @@
+/*
+ ============================================================================
+ Name        : set_cover_offload.c
+ Author      : Eduardo Ribeiro
+ Description : Set cover totals and columns on an OpenMP target device
+ ============================================================================
+ */
+
+#include "set_cover_offload.h"
+
+#include "dataset_transposed.h"
+#include "disjoint_matrix_mpi.h"
+#include "types/dataset_t.h"
+#include "types/dm_segment_t.h"
+#include "types/dm_t.h"
+#include "types/offload_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include <omp.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#pragma omp declare target
+
+/**
+ * Returns the n bits of array starting at bit o on the top of a word.
+ * The other bits of the word are not cleared
+ */
+static word_t get_bits_at(const word_t* array, const uint64_t o,
+						  const uint64_t n)
+{
+	uint64_t w = o / WORD_BITS;
+	uint64_t b = o % WORD_BITS;
+
+	word_t bits = array[w] << b;
+
+	// Only read the next word if it has some of the bits
+	if (b != 0 && b + n > WORD_BITS)
+	{
+		bits |= array[w + 1] >> (WORD_BITS - b);
+	}
+
+	return bits;
+}
+
+/**
+ * Returns a word with all the bits set if observation i is set in column
+ */
+static word_t get_invert_mask(const word_t* column, const uint64_t i)
+{
+	return (column[i / WORD_BITS] >> (WORD_BITS - 1 - i % WORD_BITS)) & 1
+		? ~0UL
+		: 0;
+}
+
+/**
+ * Counts the lines of the segments with attribute set that are also set
+ * in lines
+ */
+static uint64_t count_attribute_lines(const word_t* columns,
+									  const uint64_t* class_offsets,
+									  const uint64_t* class_words,
+									  const dm_segment_t* segments,
+									  const uint64_t n_segments,
+									  const word_t* lines,
+									  const uint64_t attribute)
+{
+	uint64_t total = 0;
+
+	for (uint64_t s = 0; s < n_segments; s++)
+	{
+		const dm_segment_t* segment = segments + s;
+
+		const word_t* column_a = columns + class_offsets[segment->classA]
+			+ attribute * class_words[segment->classA];
+		const word_t* column_b = columns + class_offsets[segment->classB]
+			+ attribute * class_words[segment->classB];
+
+		word_t invert = get_invert_mask(column_a, segment->indexA);
+
+		for (uint64_t i = 0; i < segment->n_lines; i += WORD_BITS)
+		{
+			uint64_t n = segment->n_lines - i;
+			if (n > WORD_BITS)
+			{
+				n = WORD_BITS;
+			}
+
+			word_t mask = ~0UL << (WORD_BITS - n);
+
+			word_t selected = get_bits_at(lines, segment->line + i, n) & mask;
+			if (selected == 0)
+			{
+				continue;
+			}
+
+			word_t bits = get_bits_at(column_b, segment->indexB + i, n);
+
+			total += __builtin_popcountll((bits ^ invert) & selected);
+		}
+	}
+
+	return total;
+}
+
+/**
+ * Returns word w of the column of attribute
+ */
+static word_t get_column_word(const word_t* columns,
+							  const uint64_t* class_offsets,
+							  const uint64_t* class_words,
+							  const dm_segment_t* segments,
+							  const uint64_t n_segments,
+							  const uint64_t attribute, const uint64_t w)
+{
+	uint64_t first = w * WORD_BITS;
+	uint64_t last  = first + WORD_BITS;
+
+	// The last segment that starts before the word
+	uint64_t low  = 0;
+	uint64_t high = n_segments;
+
+	while (high - low > 1)
+	{
+		uint64_t middle = low + (high - low) / 2;
+
+		if (segments[middle].line <= first)
+		{
+			low = middle;
+		}
+		else
+		{
+			high = middle;
+		}
+	}
+
+	word_t word = 0;
+
+	for (uint64_t s = low; s < n_segments && segments[s].line < last; s++)
+	{
+		const dm_segment_t* segment = segments + s;
+
+		uint64_t from = segment->line > first ? segment->line : first;
+		uint64_t to	  = segment->line + segment->n_lines;
+		if (to > last)
+		{
+			to = last;
+		}
+
+		if (from >= to)
+		{
+			continue;
+		}
+
+		uint64_t n = to - from;
+
+		const word_t* column_a = columns + class_offsets[segment->classA]
+			+ attribute * class_words[segment->classA];
+		const word_t* column_b = columns + class_offsets[segment->classB]
+			+ attribute * class_words[segment->classB];
+
+		word_t bits = get_bits_at(column_b,
+								  segment->indexB + (from - segment->line), n)
+			^ get_invert_mask(column_a, segment->indexA);
+
+		bits &= ~0UL << (WORD_BITS - n);
+
+		word |= bits >> (from - first);
+	}
+
+	return word;
+}
+
+#pragma omp end declare target
+
+int get_offload_device(void)
+{
+	// The target regions run on the host without a device
+	return omp_get_num_devices() > 0 ? omp_get_default_device()
+									 : omp_get_initial_device();
+}
+
+bool is_host_offload_device(const int device)
+{
+	return device == omp_get_initial_device();
+}
+
+/**
+ * Allocates size bytes on the device and copies them from host, if it's
+ * not NULL
+ */
+static void* copy_to_device(const void* host, const size_t size,
+							const int device)
+{
+	// Zero bytes may not be allocated
+	void* array = omp_target_alloc(size > 0 ? size : 1, device);
+
+	if (array != NULL && host != NULL && size > 0
+		&& omp_target_memcpy(array, host, size, 0, 0, device,
+							 omp_get_initial_device())
+			!= 0)
+	{
+		omp_target_free(array, device);
+		return NULL;
+	}
+
+	return array;
+}
+
+oknok_t init_offload(const dataset_t* dataset, const dm_t* dm,
+					 const int device, word_t* covered_lines,
+					 uint64_t* totals, offload_t* offload)
+{
+	uint64_t n_classes = dataset->n_classes;
+	uint64_t n_words   = dm->n_words_in_a_column;
+
+	offload->device				 = device;
+	offload->n_attributes		 = dataset->n_attributes;
+	offload->n_classes			 = n_classes;
+	offload->n_words_in_a_column = n_words;
+	offload->covered_lines		 = covered_lines;
+	offload->totals				 = totals;
+
+	// Number of segments of the lines
+	uint64_t n_segments = 0;
+
+	dm_segment_t segment;
+
+	for (bool more = first_dm_segment(dataset, dm, &segment); more;
+		 more = next_dm_segment(dataset, dm, &segment))
+	{
+		n_segments++;
+	}
+
+	uint64_t* class_offsets = (uint64_t*) malloc(n_classes * sizeof(uint64_t));
+	uint64_t* class_words	= (uint64_t*) malloc(n_classes * sizeof(uint64_t));
+	dm_segment_t* segments	= (dm_segment_t*) malloc(
+		 (n_segments > 0 ? n_segments : 1) * sizeof(dm_segment_t));
+
+	if (class_offsets == NULL || class_words == NULL || segments == NULL)
+	{
+		free(class_offsets);
+		free(class_words);
+		free(segments);
+		return NOK;
+	}
+
+	n_segments = 0;
+
+	for (bool more = first_dm_segment(dataset, dm, &segment); more;
+		 more = next_dm_segment(dataset, dm, &segment))
+	{
+		segments[n_segments++] = segment;
+	}
+
+	// The kept attributes are at the start of the columns of each class
+	word_t** cpc = dataset->columns_per_class;
+
+	for (uint64_t c = 0; c < n_classes; c++)
+	{
+		class_offsets[c] = (uint64_t) (cpc[c] - cpc[0]);
+		class_words[c]	 = get_class_column_words(dataset, c);
+	}
+
+	uint64_t n_columns_words = class_offsets[n_classes - 1]
+		+ dataset->n_attributes * class_words[n_classes - 1];
+
+	offload->n_segments = n_segments;
+
+	offload->device_columns = (word_t*) copy_to_device(
+		cpc[0], n_columns_words * sizeof(word_t), device);
+	offload->device_class_offsets = (uint64_t*) copy_to_device(
+		class_offsets, n_classes * sizeof(uint64_t), device);
+	offload->device_class_words = (uint64_t*) copy_to_device(
+		class_words, n_classes * sizeof(uint64_t), device);
+	offload->device_segments = (dm_segment_t*) copy_to_device(
+		segments, n_segments * sizeof(dm_segment_t), device);
+	offload->device_covered_lines = (word_t*) copy_to_device(
+		covered_lines, n_words * sizeof(word_t), device);
+	offload->device_totals = (uint64_t*) copy_to_device(
+		NULL, dataset->n_attributes * sizeof(uint64_t), device);
+	offload->device_lines
+		= (word_t*) copy_to_device(NULL, n_words * sizeof(word_t), device);
+
+	free(class_offsets);
+	free(class_words);
+	free(segments);
+
+	if (offload->device_columns == NULL
+		|| offload->device_class_offsets == NULL
+		|| offload->device_class_words == NULL
+		|| offload->device_segments == NULL
+		|| offload->device_covered_lines == NULL
+		|| offload->device_totals == NULL || offload->device_lines == NULL)
+	{
+		free_offload(offload);
+		return NOK;
+	}
+
+	return OK;
+}
+
+void free_offload(offload_t* offload)
+{
+	int device = offload->device;
+
+	omp_target_free(offload->device_columns, device);
+	omp_target_free(offload->device_class_offsets, device);
+	omp_target_free(offload->device_class_words, device);
+	omp_target_free(offload->device_segments, device);
+	omp_target_free(offload->device_covered_lines, device);
+	omp_target_free(offload->device_totals, device);
+	omp_target_free(offload->device_lines, device);
+
+	offload->device_columns		  = NULL;
+	offload->device_class_offsets = NULL;
+	offload->device_class_words	  = NULL;
+	offload->device_segments	  = NULL;
+	offload->device_covered_lines = NULL;
+	offload->device_totals		  = NULL;
+	offload->device_lines		  = NULL;
+}
+
+/**
+ * Copies size bytes of the device array to the host array
+ */
+static oknok_t copy_from_device(void* host, const void* array,
+								const size_t size, const int device)
+{
+	return omp_target_memcpy(host, array, size, 0, 0,
+							 omp_get_initial_device(), device)
+			== 0
+		? OK
+		: NOK;
+}
+
+oknok_t calculate_attribute_totals_offload(offload_t* offload)
+{
+	int device = offload->device;
+
+	const word_t* columns		  = offload->device_columns;
+	const uint64_t* class_offsets = offload->device_class_offsets;
+	const uint64_t* class_words	  = offload->device_class_words;
+	const dm_segment_t* segments  = offload->device_segments;
+	uint64_t n_segments			  = offload->n_segments;
+	uint64_t n_words			  = offload->n_words_in_a_column;
+	uint64_t n_attributes		  = offload->n_attributes;
+	const word_t* covered_lines	  = offload->device_covered_lines;
+	uint64_t* totals			  = offload->device_totals;
+	word_t* lines				  = offload->device_lines;
+
+	// Count the lines not covered
+#pragma omp target teams distribute parallel for device(device)              \
+	is_device_ptr(covered_lines, lines)
+	for (uint64_t w = 0; w < n_words; w++)
+	{
+		lines[w] = ~covered_lines[w];
+	}
+
+#pragma omp target teams distribute parallel for device(device)              \
+	is_device_ptr(columns, class_offsets, class_words, segments, lines, totals)
+	for (uint64_t a = 0; a < n_attributes; a++)
+	{
+		totals[a] = count_attribute_lines(columns, class_offsets, class_words,
+										  segments, n_segments, lines, a);
+	}
+
+	return copy_from_device(offload->totals, totals,
+							n_attributes * sizeof(uint64_t), device);
+}
+
+oknok_t update_attribute_totals_offload(offload_t* offload,
+										const int64_t attribute)
+{
+	int device = offload->device;
+
+	const word_t* columns		  = offload->device_columns;
+	const uint64_t* class_offsets = offload->device_class_offsets;
+	const uint64_t* class_words	  = offload->device_class_words;
+	const dm_segment_t* segments  = offload->device_segments;
+	uint64_t n_segments			  = offload->n_segments;
+	uint64_t n_words			  = offload->n_words_in_a_column;
+	uint64_t n_attributes		  = offload->n_attributes;
+	word_t* covered_lines		  = offload->device_covered_lines;
+	uint64_t* totals			  = offload->device_totals;
+	word_t* lines				  = offload->device_lines;
+
+	// The lines covered now
+#pragma omp target teams distribute parallel for device(device)              \
+	is_device_ptr(columns, class_offsets, class_words, segments,              \
+				  covered_lines, lines)
+	for (uint64_t w = 0; w < n_words; w++)
+	{
+		word_t column
+			= get_column_word(columns, class_offsets, class_words, segments,
+							  n_segments, (uint64_t) attribute, w);
+
+		lines[w] = column & ~covered_lines[w];
+		covered_lines[w] |= lines[w];
+	}
+
+#pragma omp target teams distribute parallel for device(device)              \
+	is_device_ptr(columns, class_offsets, class_words, segments, lines, totals)
+	for (uint64_t a = 0; a < n_attributes; a++)
+	{
+		totals[a] -= count_attribute_lines(columns, class_offsets, class_words,
+										   segments, n_segments, lines, a);
+	}
+
+	if (copy_from_device(offload->totals, totals,
+						 n_attributes * sizeof(uint64_t), device)
+		!= OK)
+	{
+		return NOK;
+	}
+
+	return copy_from_device(offload->covered_lines, covered_lines,
+							n_words * sizeof(word_t), device);
+}
@@ -0,0 +1,71 @@
+/*
+ ============================================================================
+ Name        : set_cover_offload.h
+ Author      : Eduardo Ribeiro
+ Description : Set cover totals and columns on an OpenMP target device
+ ============================================================================
+ */
+
+#ifndef SET_COVER_OFFLOAD_H
+#define SET_COVER_OFFLOAD_H
+
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/offload_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * The device works with the transposed dataset. The line of segment
+ * (classA, indexA) x (classB, indexB + i) has the attribute set if bit
+ * indexA of the classA column and bit indexB + i of the classB column are
+ * different, so each device thread gets 64 lines of a column with two
+ * shifts and counts them without generating the lines.
+ *
+ * The dataset, the covered lines and the totals stay on the device. Only
+ * the totals and the covered lines are copied back after each round, so
+ * the reduction and the rebalance still run on the host.
+ */
+
+/**
+ * Returns the device used by the offload, or the host (initial device) if
+ * there is none
+ */
+int get_offload_device(void);
+
+/**
+ * Checks if device is the host
+ */
+bool is_host_offload_device(const int device);
+
+/**
+ * Copies the transposed dataset and the lines of dm to device, where
+ * covered_lines and totals are also kept until free_offload
+ */
+oknok_t init_offload(const dataset_t* dataset, const dm_t* dm,
+					 const int device, word_t* covered_lines,
+					 uint64_t* totals, offload_t* offload);
+
+/**
+ * Frees the device memory. The host arrays are kept
+ */
+void free_offload(offload_t* offload);
+
+/**
+ * Calculates the totals of the lines not covered on the device and copies
+ * them to the host
+ */
+oknok_t calculate_attribute_totals_offload(offload_t* offload);
+
+/**
+ * Gets the column of attribute on the device, covers its lines and
+ * subtracts them from the totals. Copies the totals and the covered lines
+ * to the host
+ */
+oknok_t update_attribute_totals_offload(offload_t* offload,
+										const int64_t attribute);
+
+#endif // SET_COVER_OFFLOAD_H
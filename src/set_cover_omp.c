@@ -0,0 +1,272 @@
+/*
+ ============================================================================
+ Name        : set_cover_omp.c
+ Author      : Eduardo Ribeiro
+ Description : Splits the set cover work of one process between OpenMP
+			   threads
+ ============================================================================
+ */
+
+#include "set_cover_omp.h"
+
+#include "disjoint_matrix_mpi.h"
+#include "disjoint_matrix_worklist.h"
+#include "set_cover_tiled.h"
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/block.h"
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Which totals are calculated by the threads
+ */
+typedef enum omp_totals_t
+{
+	INITIAL_TOTALS,
+	ADD_TOTALS,
+	SUB_TOTALS,
+	UPDATE_ADD_TOTALS,
+	UPDATE_SUB_TOTALS
+} omp_totals_t;
+
+uint64_t get_n_threads(const int node_size)
+{
+#ifdef _OPENMP
+	uint64_t n_threads = (uint64_t) omp_get_max_threads();
+
+	// Otherwise every process starts a thread for each core of the node
+	if (getenv("OMP_NUM_THREADS") == NULL && node_size > 1)
+	{
+		n_threads /= (uint64_t) node_size;
+	}
+
+	return n_threads > 0 ? n_threads : 1;
+#else
+	(void) node_size;
+
+	return 1;
+#endif
+}
+
+oknok_t init_dm_threads(const dataset_t* dataset, const dm_t* dm,
+						const uint64_t n_threads, dm_threads_t* threads)
+{
+	threads->n_threads = n_threads;
+	threads->s_offset  = dm->s_offset;
+	threads->n_totals  = dataset->n_words * WORD_BITS;
+
+	threads->dms = (dm_t*) calloc(n_threads, sizeof(dm_t));
+	threads->totals
+		= (uint64_t*) calloc(n_threads * threads->n_totals, sizeof(uint64_t));
+
+	if (threads->dms == NULL || threads->totals == NULL)
+	{
+		free_dm_threads(threads);
+		return NOK;
+	}
+
+	for (uint64_t t = 0; t < n_threads; t++)
+	{
+		dm_t* part = threads->dms + t;
+
+		// Split the words of the columns, so no word is shared by 2 threads
+		uint64_t first_word
+			= BLOCK_LOW(t, n_threads, dm->n_words_in_a_column);
+		uint64_t n_words = BLOCK_SIZE(t, n_threads, dm->n_words_in_a_column);
+
+		uint64_t first_line = first_word * WORD_BITS;
+		uint64_t n_lines	= n_words * WORD_BITS;
+
+		if (first_line >= dm->s_size)
+		{
+			n_lines = 0;
+		}
+		else if (first_line + n_lines > dm->s_size)
+		{
+			n_lines = dm->s_size - first_line;
+		}
+
+		part->n_matrix_lines	  = dm->n_matrix_lines;
+		part->n_words_in_a_column = n_words;
+		part->s_offset			  = dm->s_offset + first_line;
+		part->s_size			  = n_lines;
+		part->dense_2_classes	  = dm->dense_2_classes;
+
+		if (n_lines > 0)
+		{
+			calculate_class_offsets(dataset, part->s_offset,
+									&part->initial_class_offsets);
+		}
+	}
+
+	return OK;
+}
+
+void free_dm_threads(dm_threads_t* threads)
+{
+	for (uint64_t t = 0; threads->dms != NULL && t < threads->n_threads; t++)
+	{
+		free_dm_worklist(threads->dms + t);
+	}
+
+	free(threads->dms);
+	free(threads->totals);
+
+	threads->dms	   = NULL;
+	threads->totals	   = NULL;
+	threads->n_threads = 0;
+}
+
+/**
+ * Each thread calculates the totals of its parts in its own array, and
+ * then all threads sum a slice of the attributes.
+ * The update modes also get the column of attribute and update the covered
+ * lines (see update_attribute_totals_tiled)
+ */
+static void calculate_totals_omp(const dataset_t* dataset,
+								 dm_threads_t* threads,
+								 const omp_totals_t mode, const word_t* lines,
+								 const int64_t attribute,
+								 word_t* covered_lines, word_t* column,
+								 uint64_t* totals)
+{
+	uint64_t n_attributes = dataset->n_attributes;
+	uint64_t n_threads	  = threads->n_threads;
+	uint64_t n_totals	  = threads->n_totals;
+
+#pragma omp parallel num_threads(n_threads)
+	{
+#pragma omp for schedule(static, 1)
+		for (uint64_t t = 0; t < n_threads; t++)
+		{
+			const dm_t* dm = threads->dms + t;
+			uint64_t* tt   = threads->totals + t * n_totals;
+
+			// This part of the lines arrays
+			uint64_t offset = (dm->s_offset - threads->s_offset) / WORD_BITS;
+
+			const word_t* tl = lines == NULL ? NULL : lines + offset;
+			word_t* tcl
+				= covered_lines == NULL ? NULL : covered_lines + offset;
+			word_t* tc = column == NULL ? NULL : column + offset;
+
+			switch (mode)
+			{
+				case INITIAL_TOTALS:
+					calculate_initial_attribute_totals_tiled(dataset, dm, tt);
+					break;
+				case ADD_TOTALS:
+					calculate_attribute_totals_add_tiled(dataset, dm, tl, tt);
+					break;
+				case SUB_TOTALS:
+					// The modular sum of what each thread subtracts
+					memset(tt, 0, n_attributes * sizeof(uint64_t));
+					calculate_attribute_totals_sub_tiled(dataset, dm, tl, tt);
+					break;
+				case UPDATE_ADD_TOTALS:
+					update_attribute_totals_tiled(dataset, dm, attribute, false,
+												  tcl, tc, tt);
+					break;
+				case UPDATE_SUB_TOTALS:
+					memset(tt, 0, n_attributes * sizeof(uint64_t));
+					update_attribute_totals_tiled(dataset, dm, attribute, true,
+												  tcl, tc, tt);
+					break;
+			}
+		}
+
+		// Reduce the thread totals
+#pragma omp for schedule(static)
+		for (uint64_t a = 0; a < n_attributes; a++)
+		{
+			uint64_t sum = 0;
+
+			for (uint64_t t = 0; t < n_threads; t++)
+			{
+				sum += threads->totals[t * n_totals + a];
+			}
+
+			if (mode == SUB_TOTALS || mode == UPDATE_SUB_TOTALS)
+			{
+				totals[a] += sum;
+			}
+			else
+			{
+				totals[a] = sum;
+			}
+		}
+	}
+}
+
+oknok_t calculate_initial_attribute_totals_omp(const dataset_t* dataset,
+											   dm_threads_t* threads,
+											   uint64_t* totals)
+{
+	calculate_totals_omp(dataset, threads, INITIAL_TOTALS, NULL, -1, NULL, NULL,
+						 totals);
+
+	return OK;
+}
+
+oknok_t calculate_attribute_totals_add_omp(const dataset_t* dataset,
+										   dm_threads_t* threads,
+										   const word_t* covered_lines,
+										   uint64_t* totals)
+{
+	calculate_totals_omp(dataset, threads, ADD_TOTALS, covered_lines, -1, NULL,
+						 NULL, totals);
+
+	return OK;
+}
+
+oknok_t calculate_attribute_totals_sub_omp(const dataset_t* dataset,
+										   dm_threads_t* threads,
+										   const word_t* covered_lines,
+										   uint64_t* totals)
+{
+	calculate_totals_omp(dataset, threads, SUB_TOTALS, covered_lines, -1, NULL,
+						 NULL, totals);
+
+	return OK;
+}
+
+oknok_t update_attribute_totals_omp(const dataset_t* dataset,
+									dm_threads_t* threads,
+									const int64_t attribute,
+									const bool subtract, word_t* covered_lines,
+									word_t* column, uint64_t* totals)
+{
+	omp_totals_t mode = subtract ? UPDATE_SUB_TOTALS : UPDATE_ADD_TOTALS;
+
+	calculate_totals_omp(dataset, threads, mode, NULL, attribute,
+						 covered_lines, column, totals);
+
+	return OK;
+}
+
+oknok_t get_column_omp(const dataset_t* dataset, const dm_threads_t* threads,
+					   const int64_t attribute, word_t* column)
+{
+	uint64_t n_threads = threads->n_threads;
+
+#pragma omp parallel for num_threads(n_threads) schedule(static, 1)
+	for (uint64_t t = 0; t < n_threads; t++)
+	{
+		const dm_t* dm = threads->dms + t;
+
+		get_column(dataset, dm, attribute,
+				   column + (dm->s_offset - threads->s_offset) / WORD_BITS);
+	}
+
+	return OK;
+}
@@ -0,0 +1,87 @@
+/*
+ ============================================================================
+ Name        : set_cover_omp.h
+ Author      : Eduardo Ribeiro
+ Description : Splits the set cover work of one process between OpenMP
+			   threads
+ ============================================================================
+ */
+
+#ifndef SET_COVER_OMP_H
+#define SET_COVER_OMP_H
+
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/dm_threads_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Returns the number of OpenMP threads available to each of the node_size
+ * processes of a node. Without OMP_NUM_THREADS, the threads of the node are
+ * split between them
+ */
+uint64_t get_n_threads(const int node_size);
+
+/**
+ * Splits the lines of dm between the threads.
+ * The threads share the dataset and the dm arrays (covered lines, best
+ * column), so every part starts on a word boundary of those arrays
+ */
+oknok_t init_dm_threads(const dataset_t* dataset, const dm_t* dm,
+						const uint64_t n_threads, dm_threads_t* threads);
+
+/**
+ * Frees the threads memory
+ */
+void free_dm_threads(dm_threads_t* threads);
+
+/**
+ * These functions have the same behaviour as the ones in set_cover_tiled.h.
+ * Each thread works on its own part of the matrix and then the threads sum
+ * their totals in shared memory.
+ */
+
+/**
+ * Calculates the initial attributes totals
+ */
+oknok_t calculate_initial_attribute_totals_omp(const dataset_t* dataset,
+											   dm_threads_t* threads,
+											   uint64_t* totals);
+
+/**
+ * Calculates the attributes totals for the lines not yet covered
+ */
+oknok_t calculate_attribute_totals_add_omp(const dataset_t* dataset,
+										   dm_threads_t* threads,
+										   const word_t* covered_lines,
+										   uint64_t* totals);
+
+/**
+ * Removes from the attributes totals the lines set in covered_lines
+ */
+oknok_t calculate_attribute_totals_sub_omp(const dataset_t* dataset,
+										   dm_threads_t* threads,
+										   const word_t* covered_lines,
+										   uint64_t* totals);
+
+/**
+ * Gets the column of attribute, updates the covered lines and the totals in
+ * the same pass over the lines (see update_attribute_totals_tiled)
+ */
+oknok_t update_attribute_totals_omp(const dataset_t* dataset,
+									dm_threads_t* threads,
+									const int64_t attribute,
+									const bool subtract, word_t* covered_lines,
+									word_t* column, uint64_t* totals);
+
+/**
+ * Gets the column of attribute, each thread generating its part
+ */
+oknok_t get_column_omp(const dataset_t* dataset, const dm_threads_t* threads,
+					   const int64_t attribute, word_t* column);
+
+#endif // SET_COVER_OMP_H
@@ -0,0 +1,430 @@
+/*
+ ============================================================================
+ Name        : set_cover_reduce.c
+ Author      : Eduardo Ribeiro
+ Description : Global reduction of the attribute totals
+ ============================================================================
+ */
+
+#include "set_cover_reduce.h"
+
+#include "types/oknok_t.h"
+#include "types/totals_reduce_t.h"
+#include "utils/ranks.h"
+
+#include "mpi.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+oknok_t init_totals_reduce(MPI_Comm comm, const uint64_t n_attributes,
+						   const uint64_t n_matrix_lines,
+						   totals_reduce_t* reduce)
+{
+	MPI_Comm_size(comm, &reduce->size);
+
+	reduce->n_attributes = n_attributes;
+	reduce->first_live	 = 0;
+	reduce->n_live		 = n_attributes;
+	reduce->n_sparse	 = 0;
+	reduce->n_dense		 = 0;
+	reduce->request		 = MPI_REQUEST_NULL;
+	reduce->total_words	 = 0;
+	reduce->dense		 = false;
+
+	// No total can be larger than the number of lines
+	reduce->narrow
+		= n_matrix_lines <= UINT32_MAX && n_attributes <= UINT32_MAX;
+
+	reduce->narrow_totals		 = NULL;
+	reduce->narrow_global_totals = NULL;
+
+	reduce->node_comm		   = MPI_COMM_NULL;
+	reduce->roots_comm		   = MPI_COMM_NULL;
+	reduce->node_window		   = MPI_WIN_NULL;
+	reduce->node_slots		   = NULL;
+	reduce->node_totals		   = NULL;
+	reduce->node_global_totals = NULL;
+
+	if (reduce->narrow)
+	{
+		reduce->narrow_totals
+			= (uint32_t*) malloc(n_attributes * sizeof(uint32_t));
+		reduce->narrow_global_totals
+			= (uint32_t*) malloc(n_attributes * sizeof(uint32_t));
+	}
+
+	reduce->last_totals = (uint64_t*) calloc(n_attributes, sizeof(uint64_t));
+	reduce->pairs = (uint64_t*) malloc(2 * n_attributes * sizeof(uint64_t));
+
+	// The pairs are only gathered if they fit in n_attributes words
+	reduce->all_pairs = (uint64_t*) malloc(n_attributes * sizeof(uint64_t));
+
+	reduce->counts = (int*) malloc(reduce->size * sizeof(int));
+	reduce->displs = (int*) malloc(reduce->size * sizeof(int));
+
+	if (reduce->last_totals == NULL || reduce->pairs == NULL
+		|| reduce->all_pairs == NULL || reduce->counts == NULL
+		|| reduce->displs == NULL
+		|| (reduce->narrow
+			&& (reduce->narrow_totals == NULL
+				|| reduce->narrow_global_totals == NULL)))
+	{
+		free_totals_reduce(reduce);
+		return NOK;
+	}
+
+	return OK;
+}
+
+oknok_t set_node_totals_reduce(MPI_Comm node_comm, MPI_Comm roots_comm,
+							   totals_reduce_t* reduce)
+{
+	MPI_Comm_rank(node_comm, &reduce->node_rank);
+	MPI_Comm_size(node_comm, &reduce->node_size);
+
+	uint64_t n_attributes = reduce->n_attributes;
+	bool root			  = reduce->node_rank == LOCAL_ROOT_RANK;
+
+	// The roots reduce the node totals between them
+	if (root)
+	{
+		MPI_Comm_size(roots_comm, &reduce->size);
+
+		free(reduce->counts);
+		free(reduce->displs);
+
+		reduce->counts = (int*) malloc(reduce->size * sizeof(int));
+		reduce->displs = (int*) malloc(reduce->size * sizeof(int));
+
+		if (reduce->counts == NULL || reduce->displs == NULL)
+		{
+			return NOK;
+		}
+	}
+
+	// One slot for each process, the node totals and the global totals
+	MPI_Aint window_size = root
+		? (reduce->node_size + 2) * n_attributes * sizeof(uint64_t)
+		: 0;
+
+	uint64_t* node_memory = NULL;
+
+	MPI_Win_allocate_shared(window_size, sizeof(uint64_t), MPI_INFO_NULL,
+							node_comm, &node_memory, &reduce->node_window);
+
+	if (!root)
+	{
+		MPI_Aint root_size;
+		int root_disp;
+		MPI_Win_shared_query(reduce->node_window, LOCAL_ROOT_RANK,
+							 &root_size, &root_disp, &node_memory);
+	}
+
+	reduce->node_comm		   = node_comm;
+	reduce->roots_comm		   = roots_comm;
+	reduce->node_slots		   = node_memory;
+	reduce->node_totals		   = node_memory + reduce->node_size * n_attributes;
+	reduce->node_global_totals = reduce->node_totals + n_attributes;
+
+	if (root)
+	{
+		memset(reduce->node_global_totals, 0, n_attributes * sizeof(uint64_t));
+	}
+
+	// The processes read and write the window directly
+	MPI_Win_lock_all(MPI_MODE_NOCHECK, reduce->node_window);
+
+	MPI_Win_sync(reduce->node_window);
+	MPI_Barrier(node_comm);
+
+	return OK;
+}
+
+void free_totals_reduce(totals_reduce_t* reduce)
+{
+	if (reduce->node_window != MPI_WIN_NULL)
+	{
+		MPI_Win_unlock_all(reduce->node_window);
+		MPI_Win_free(&reduce->node_window);
+	}
+
+	reduce->node_comm		   = MPI_COMM_NULL;
+	reduce->node_slots		   = NULL;
+	reduce->node_totals		   = NULL;
+	reduce->node_global_totals = NULL;
+
+	free(reduce->last_totals);
+	free(reduce->pairs);
+	free(reduce->all_pairs);
+	free(reduce->counts);
+	free(reduce->displs);
+	free(reduce->narrow_totals);
+	free(reduce->narrow_global_totals);
+
+	reduce->last_totals			 = NULL;
+	reduce->pairs				 = NULL;
+	reduce->all_pairs			 = NULL;
+	reduce->counts				 = NULL;
+	reduce->displs				 = NULL;
+	reduce->narrow_totals		 = NULL;
+	reduce->narrow_global_totals = NULL;
+
+	reduce->node_comm		   = MPI_COMM_NULL;
+	reduce->roots_comm		   = MPI_COMM_NULL;
+	reduce->node_window		   = MPI_WIN_NULL;
+	reduce->node_slots		   = NULL;
+	reduce->node_totals		   = NULL;
+	reduce->node_global_totals = NULL;
+}
+
+/**
+ * Makes the writes to the node window visible to the other processes of
+ * the node, after they all get here
+ */
+static void sync_node(const totals_reduce_t* reduce)
+{
+	MPI_Win_sync(reduce->node_window);
+	MPI_Barrier(reduce->node_comm);
+	MPI_Win_sync(reduce->node_window);
+}
+
+/**
+ * Starts the reduction of totals between the processes of comm
+ */
+static void start_reduce(MPI_Comm comm, const uint64_t* totals,
+						 totals_reduce_t* reduce, uint64_t* global_totals)
+{
+	uint64_t n_attributes = reduce->n_attributes;
+
+	// Build the pairs of the totals that changed
+	uint64_t n_words = 0;
+	for (uint64_t a = 0; a < n_attributes; a++)
+	{
+		if (totals[a] != reduce->last_totals[a])
+		{
+			// The deltas are summed modulo 2^64 (2^32), like the totals
+			uint64_t delta = totals[a] - reduce->last_totals[a];
+
+			if (reduce->narrow)
+			{
+				reduce->pairs[n_words++] = (a << 32) | (uint32_t) delta;
+			}
+			else
+			{
+				reduce->pairs[n_words++] = a;
+				reduce->pairs[n_words++] = delta;
+			}
+
+			reduce->last_totals[a] = totals[a];
+		}
+	}
+
+	// The sizes are needed to choose and post the reduction
+	int count = (int) n_words;
+	MPI_Allgather(&count, 1, MPI_INT, reduce->counts, 1, MPI_INT, comm);
+
+	uint64_t total_words = 0;
+	for (int r = 0; r < reduce->size; r++)
+	{
+		reduce->displs[r] = (int) total_words;
+		total_words += reduce->counts[r];
+	}
+
+	reduce->total_words = total_words;
+
+	// Words of the totals of the live attributes
+	uint64_t first		 = reduce->first_live;
+	uint64_t n_live		 = reduce->n_live;
+	uint64_t dense_words = reduce->narrow ? n_live / 2 + n_live % 2 : n_live;
+
+	reduce->dense = total_words > dense_words;
+
+	if (reduce->dense && reduce->narrow)
+	{
+		for (uint64_t a = first; a < first + n_live; a++)
+		{
+			reduce->narrow_totals[a] = (uint32_t) totals[a];
+		}
+
+		MPI_Iallreduce(reduce->narrow_totals + first,
+					   reduce->narrow_global_totals + first, n_live,
+					   MPI_UINT32_T, MPI_SUM, comm, &reduce->request);
+
+		reduce->n_dense++;
+		return;
+	}
+
+	if (reduce->dense)
+	{
+		MPI_Iallreduce(totals + first, global_totals + first, n_live,
+					   MPI_UINT64_T, MPI_SUM, comm, &reduce->request);
+
+		reduce->n_dense++;
+		return;
+	}
+
+	// Sparse
+	reduce->n_sparse++;
+
+	// Nothing changed
+	if (total_words == 0)
+	{
+		reduce->request = MPI_REQUEST_NULL;
+		return;
+	}
+
+	MPI_Iallgatherv(reduce->pairs, count, MPI_UINT64_T, reduce->all_pairs,
+					reduce->counts, reduce->displs, MPI_UINT64_T, comm,
+					&reduce->request);
+
+}
+
+/**
+ * Finishes the reduction started by start_reduce
+ */
+static void finish_reduce(totals_reduce_t* reduce, uint64_t* global_totals)
+{
+	MPI_Wait(&reduce->request, MPI_STATUS_IGNORE);
+
+	if (reduce->dense && reduce->narrow)
+	{
+		for (uint64_t a = reduce->first_live;
+			 a < reduce->first_live + reduce->n_live; a++)
+		{
+			global_totals[a] = reduce->narrow_global_totals[a];
+		}
+
+		return;
+	}
+
+	// The dense reduction is already in global_totals
+	if (reduce->dense)
+	{
+		return;
+	}
+
+	if (reduce->narrow)
+	{
+		for (uint64_t i = 0; i < reduce->total_words; i++)
+		{
+			uint64_t a = reduce->all_pairs[i] >> 32;
+
+			// The global total is below 2^32
+			global_totals[a] = (uint32_t) (global_totals[a]
+										   + (uint32_t) reduce->all_pairs[i]);
+		}
+
+		return;
+	}
+
+	for (uint64_t i = 0; i < reduce->total_words; i += 2)
+	{
+		global_totals[reduce->all_pairs[i]] += reduce->all_pairs[i + 1];
+	}
+
+}
+
+/**
+ * Shrinks the live range of the reductions to the attributes between the
+ * first and the last with a global total
+ */
+static void update_live_range(totals_reduce_t* reduce,
+							  const uint64_t* global_totals)
+{
+	uint64_t first = reduce->first_live;
+	uint64_t end   = reduce->first_live + reduce->n_live;
+
+	while (first < end && global_totals[first] == 0)
+	{
+		first++;
+	}
+
+	while (end > first && global_totals[end - 1] == 0)
+	{
+		end--;
+	}
+
+	reduce->first_live = first;
+	reduce->n_live	   = end - first;
+}
+
+oknok_t start_reduce_attribute_totals(MPI_Comm comm, const uint64_t* totals,
+									  totals_reduce_t* reduce,
+									  uint64_t* global_totals)
+{
+	if (reduce->node_comm == MPI_COMM_NULL)
+	{
+		start_reduce(comm, totals, reduce, global_totals);
+		return OK;
+	}
+
+	uint64_t n_attributes = reduce->n_attributes;
+
+	memcpy(reduce->node_slots + reduce->node_rank * n_attributes, totals,
+		   n_attributes * sizeof(uint64_t));
+
+	sync_node(reduce);
+
+	// Each process sums a slice of the attributes of all the slots
+	uint64_t slice = n_attributes / reduce->node_size
+		+ (n_attributes % reduce->node_size != 0);
+	uint64_t first = reduce->node_rank * slice;
+	uint64_t last  = first + slice < n_attributes ? first + slice : n_attributes;
+
+	for (uint64_t a = first; a < last; a++)
+	{
+		uint64_t sum = 0;
+		for (int r = 0; r < reduce->node_size; r++)
+		{
+			sum += reduce->node_slots[r * n_attributes + a];
+		}
+
+		reduce->node_totals[a] = sum;
+	}
+
+	sync_node(reduce);
+
+	if (reduce->node_rank == LOCAL_ROOT_RANK)
+	{
+		start_reduce(reduce->roots_comm, reduce->node_totals, reduce,
+					 reduce->node_global_totals);
+	}
+
+	return OK;
+}
+
+oknok_t finish_reduce_attribute_totals(totals_reduce_t* reduce,
+									   uint64_t* global_totals)
+{
+	if (reduce->node_comm == MPI_COMM_NULL)
+	{
+		finish_reduce(reduce, global_totals);
+		update_live_range(reduce, global_totals);
+		return OK;
+	}
+
+	if (reduce->node_rank == LOCAL_ROOT_RANK)
+	{
+		finish_reduce(reduce, reduce->node_global_totals);
+		update_live_range(reduce, reduce->node_global_totals);
+	}
+
+	sync_node(reduce);
+
+	memcpy(global_totals, reduce->node_global_totals,
+		   reduce->n_attributes * sizeof(uint64_t));
+
+	return OK;
+}
+
+oknok_t reduce_attribute_totals(MPI_Comm comm, const uint64_t* totals,
+								totals_reduce_t* reduce,
+								uint64_t* global_totals)
+{
+	start_reduce_attribute_totals(comm, totals, reduce, global_totals);
+
+	return finish_reduce_attribute_totals(reduce, global_totals);
+}
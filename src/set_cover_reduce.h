@@ -0,0 +1,96 @@
+/*
+ ============================================================================
+ Name        : set_cover_reduce.h
+ Author      : Eduardo Ribeiro
+ Description : Global reduction of the attribute totals
+ ============================================================================
+ */
+
+#ifndef SET_COVER_REDUCE_H
+#define SET_COVER_REDUCE_H
+
+#include "types/oknok_t.h"
+#include "types/totals_reduce_t.h"
+
+#include "mpi.h"
+
+#include <stdint.h>
+
+/**
+ * After the first rounds most attribute totals don't change from one round
+ * to the next (they are 0 or the attribute doesn't cover the new lines), so
+ * each process only sends the (attribute, delta) pairs of the totals that
+ * changed since the last reduction.
+ *
+ * On each round the number of pairs of all processes is shared, and the
+ * totals are reduced with:
+ *  - MPI_Allgatherv of the pairs if they need fewer words than the totals
+ *  - MPI_Allreduce of the full totals otherwise
+ *
+ * Every process gets the global totals, so the best attribute doesn't need
+ * to be broadcasted.
+ *
+ * If the matrix has at most 2^32 - 1 lines no total needs more than 32 bits,
+ * so the full totals are reduced as 32 bit counts and each pair is packed
+ * in one word, with the attribute on the top half.
+ *
+ * The reduction can be started and finished later, so the processes work
+ * while the totals are sent. Only the number of pairs is shared before the
+ * start returns, the rest uses the non-blocking collectives.
+ *
+ * With the node reduction the processes of each node first sum their totals
+ * in a shared memory window: each process copies its totals to its slot and
+ * sums a slice of the attributes of all the slots. Only the node roots then
+ * reduce the node totals as above, and the processes of the node read the
+ * global totals from the window, so the network only carries one set of
+ * pairs for each node.
+ */
+
+/**
+ * Allocates the reduction memory
+ */
+oknok_t init_totals_reduce(MPI_Comm comm, const uint64_t n_attributes,
+						   const uint64_t n_matrix_lines,
+						   totals_reduce_t* reduce);
+
+/**
+ * Sums the totals of the processes of node_comm before reducing them between
+ * the node roots in roots_comm (MPI_COMM_NULL on the other processes).
+ * Must be called after init_totals_reduce by all the processes of node_comm
+ */
+oknok_t set_node_totals_reduce(MPI_Comm node_comm, MPI_Comm roots_comm,
+							   totals_reduce_t* reduce);
+
+/**
+ * Frees the reduction memory
+ */
+void free_totals_reduce(totals_reduce_t* reduce);
+
+/**
+ * Starts summing the totals of all processes in global_totals.
+ * totals and global_totals can't be changed or read until the reduction is
+ * finished, and global_totals must keep the result of the previous
+ * reduction (zeros on the first one).
+ * With the node reduction comm is not used
+ */
+oknok_t start_reduce_attribute_totals(MPI_Comm comm, const uint64_t* totals,
+									  totals_reduce_t* reduce,
+									  uint64_t* global_totals);
+
+/**
+ * Waits for the reduction started by start_reduce_attribute_totals and
+ * updates global_totals
+ */
+oknok_t finish_reduce_attribute_totals(totals_reduce_t* reduce,
+									   uint64_t* global_totals);
+
+/**
+ * Sums the totals of all processes in global_totals.
+ * global_totals must keep the result of the previous call (zeros on the
+ * first one)
+ */
+oknok_t reduce_attribute_totals(MPI_Comm comm, const uint64_t* totals,
+								totals_reduce_t* reduce,
+								uint64_t* global_totals);
+
+#endif // SET_COVER_REDUCE_H
@@ -0,0 +1,268 @@
+/*
+ ============================================================================
+ Name        : set_cover_stats.c
+ Author      : Eduardo Ribeiro
+ Description : Records the time spent by every process on each phase of
+			   the set cover rounds
+ ============================================================================
+ */
+
+#include "set_cover_stats.h"
+
+#include "types/oknok_t.h"
+#include "types/round_stats_t.h"
+#include "utils/ranks.h"
+
+#include "mpi.h"
+
+#ifdef WITH_CALIPER
+#include <caliper/cali.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Number of rounds allocated at the start, doubled when needed
+ */
+#define STATS_INITIAL_ROUNDS 64
+
+/**
+ * Names of the phases, in the CSV header and the Caliper regions
+ */
+static const char* PHASE_NAMES[N_STATS_PHASES]
+	= { "totals", "column", "reduce", "balance" };
+
+oknok_t init_round_stats(round_stats_t* stats)
+{
+	stats->n_rounds = 0;
+	stats->capacity = STATS_INITIAL_ROUNDS;
+	stats->phase	= STATS_TOTALS;
+	stats->start	= 0;
+
+	stats->times = (double*) calloc(stats->capacity * N_STATS_PHASES,
+									sizeof(double));
+	stats->n_uncovered_lines
+		= (uint64_t*) calloc(stats->capacity, sizeof(uint64_t));
+
+	if (stats->times == NULL || stats->n_uncovered_lines == NULL)
+	{
+		free_round_stats(stats);
+		return NOK;
+	}
+
+	return OK;
+}
+
+void free_round_stats(round_stats_t* stats)
+{
+	free(stats->times);
+	free(stats->n_uncovered_lines);
+
+	stats->times			 = NULL;
+	stats->n_uncovered_lines = NULL;
+	stats->n_rounds			 = 0;
+	stats->capacity			 = 0;
+}
+
+void begin_phase(round_stats_t* stats, const stats_phase_t phase)
+{
+#ifdef WITH_CALIPER
+	CALI_MARK_BEGIN(PHASE_NAMES[phase]);
+#endif
+
+	stats->phase = phase;
+	stats->start = MPI_Wtime();
+}
+
+void end_phase(round_stats_t* stats)
+{
+	stats->times[stats->n_rounds * N_STATS_PHASES + stats->phase]
+		+= MPI_Wtime() - stats->start;
+
+#ifdef WITH_CALIPER
+	CALI_MARK_END(PHASE_NAMES[stats->phase]);
+#endif
+}
+
+oknok_t end_round(round_stats_t* stats, const uint64_t n_uncovered_lines)
+{
+	stats->n_uncovered_lines[stats->n_rounds] = n_uncovered_lines;
+	stats->n_rounds++;
+
+	if (stats->n_rounds < stats->capacity)
+	{
+		return OK;
+	}
+
+	// The current round must always have its place
+	uint64_t capacity = stats->capacity * 2;
+
+	double* times = (double*) realloc(
+		stats->times, capacity * N_STATS_PHASES * sizeof(double));
+	if (times == NULL)
+	{
+		return NOK;
+	}
+	stats->times = times;
+
+	uint64_t* n_uncovered = (uint64_t*) realloc(
+		stats->n_uncovered_lines, capacity * sizeof(uint64_t));
+	if (n_uncovered == NULL)
+	{
+		return NOK;
+	}
+	stats->n_uncovered_lines = n_uncovered;
+
+	memset(stats->times + stats->capacity * N_STATS_PHASES, 0,
+		   (capacity - stats->capacity) * N_STATS_PHASES * sizeof(double));
+	memset(stats->n_uncovered_lines + stats->capacity, 0,
+		   (capacity - stats->capacity) * sizeof(uint64_t));
+
+	stats->capacity = capacity;
+
+	return OK;
+}
+
+/**
+ * Writes the stats of all processes as CSV and shows the phase totals
+ */
+static oknok_t write_csv(const char* filename, const int size,
+						 const int* n_rounds, const int* displs,
+						 const double* times, const uint64_t* n_uncovered)
+{
+	FILE* file = fopen(filename, "w");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Error creating file %s\n", filename);
+		return NOK;
+	}
+
+	fprintf(file, "rank,round");
+	for (int p = 0; p < N_STATS_PHASES; p++)
+	{
+		fprintf(file, ",%s", PHASE_NAMES[p]);
+	}
+	fprintf(file, ",uncovered_lines\n");
+
+	double sum[N_STATS_PHASES] = { 0 };
+	double max[N_STATS_PHASES] = { 0 };
+
+	for (int r = 0; r < size; r++)
+	{
+		double rank_sum[N_STATS_PHASES] = { 0 };
+
+		for (int i = 0; i < n_rounds[r]; i++)
+		{
+			const double* round_times
+				= times + (uint64_t) (displs[r] + i) * N_STATS_PHASES;
+
+			fprintf(file, "%d,%d", r, i);
+			for (int p = 0; p < N_STATS_PHASES; p++)
+			{
+				fprintf(file, ",%0.9f", round_times[p]);
+				rank_sum[p] += round_times[p];
+			}
+			fprintf(file, ",%lu\n", n_uncovered[displs[r] + i]);
+		}
+
+		for (int p = 0; p < N_STATS_PHASES; p++)
+		{
+			sum[p] += rank_sum[p];
+			max[p] = rank_sum[p] > max[p] ? rank_sum[p] : max[p];
+		}
+	}
+
+	fclose(file);
+
+	fprintf(stdout, "Time per phase (average / max of processes):\n");
+	for (int p = 0; p < N_STATS_PHASES; p++)
+	{
+		fprintf(stdout, "  %-8s %0.6fs / %0.6fs\n", PHASE_NAMES[p],
+				sum[p] / size, max[p]);
+	}
+	fprintf(stdout, "  Saved in '%s'\n", filename);
+
+	return OK;
+}
+
+oknok_t write_round_stats(MPI_Comm comm, const round_stats_t* stats,
+						  const char* filename)
+{
+	int rank;
+	int size;
+
+	MPI_Comm_rank(comm, &rank);
+	MPI_Comm_size(comm, &size);
+
+	int count = (int) stats->n_rounds;
+
+	int* n_rounds = NULL;
+	int* displs	  = NULL;
+	int* counts	  = NULL;
+	int* t_displs = NULL;
+
+	double* times		  = NULL;
+	uint64_t* n_uncovered = NULL;
+
+	int status = OK;
+
+	if (rank == ROOT_RANK)
+	{
+		n_rounds = (int*) malloc(size * sizeof(int));
+		displs	 = (int*) malloc(size * sizeof(int));
+		counts	 = (int*) malloc(size * sizeof(int));
+		t_displs = (int*) malloc(size * sizeof(int));
+	}
+
+	MPI_Gather(&count, 1, MPI_INT, n_rounds, 1, MPI_INT, ROOT_RANK, comm);
+
+	if (rank == ROOT_RANK)
+	{
+		int total = 0;
+		for (int r = 0; r < size; r++)
+		{
+			displs[r]	= total;
+			counts[r]	= n_rounds[r] * N_STATS_PHASES;
+			t_displs[r] = total * N_STATS_PHASES;
+			total += n_rounds[r];
+		}
+
+		times = (double*) malloc((uint64_t) total * N_STATS_PHASES
+								 * sizeof(double));
+		n_uncovered = (uint64_t*) malloc((uint64_t) total * sizeof(uint64_t));
+
+		if (times == NULL || n_uncovered == NULL)
+		{
+			status = NOK;
+		}
+	}
+
+	MPI_Bcast(&status, 1, MPI_INT, ROOT_RANK, comm);
+
+	if (status == OK)
+	{
+		MPI_Gatherv(stats->times, count * N_STATS_PHASES, MPI_DOUBLE, times,
+					counts, t_displs, MPI_DOUBLE, ROOT_RANK, comm);
+		MPI_Gatherv(stats->n_uncovered_lines, count, MPI_UINT64_T,
+					n_uncovered, n_rounds, displs, MPI_UINT64_T, ROOT_RANK,
+					comm);
+
+		if (rank == ROOT_RANK)
+		{
+			status = write_csv(filename, size, n_rounds, displs, times,
+							   n_uncovered);
+		}
+	}
+
+	free(n_rounds);
+	free(displs);
+	free(counts);
+	free(t_displs);
+	free(times);
+	free(n_uncovered);
+
+	return status;
+}
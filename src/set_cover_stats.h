@@ -0,0 +1,62 @@
+/*
+ ============================================================================
+ Name        : set_cover_stats.h
+ Author      : Eduardo Ribeiro
+ Description : Records the time spent by every process on each phase of
+			   the set cover rounds
+ ============================================================================
+ */
+
+#ifndef SET_COVER_STATS_H
+#define SET_COVER_STATS_H
+
+#include "types/oknok_t.h"
+#include "types/round_stats_t.h"
+
+#include "mpi.h"
+
+#include <stdint.h>
+
+/**
+ * Every process records its own times, so the load imbalance and the cost of
+ * the communication can be seen. The records are gathered on the root at the
+ * end and written as CSV, one line per process and round.
+ *
+ * Compiling with -DWITH_CALIPER also marks the phases as Caliper regions.
+ */
+
+/**
+ * Allocates the stats memory
+ */
+oknok_t init_round_stats(round_stats_t* stats);
+
+/**
+ * Frees the stats memory
+ */
+void free_round_stats(round_stats_t* stats);
+
+/**
+ * Starts timing a phase of the current round
+ */
+void begin_phase(round_stats_t* stats, const stats_phase_t phase);
+
+/**
+ * Adds the time since begin_phase to the phase of the current round
+ */
+void end_phase(round_stats_t* stats);
+
+/**
+ * Finishes the current round, with n_uncovered_lines lines of the process
+ * still not covered
+ */
+oknok_t end_round(round_stats_t* stats, const uint64_t n_uncovered_lines);
+
+/**
+ * Gathers the stats of all processes and writes them to filename on the
+ * root. The root also shows the total time of each phase, the average and
+ * the maximum between processes
+ */
+oknok_t write_round_stats(MPI_Comm comm, const round_stats_t* stats,
+						  const char* filename);
+
+#endif // SET_COVER_STATS_H
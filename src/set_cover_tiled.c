@@ -0,0 +1,556 @@
+/*
+ ============================================================================
+ Name        : set_cover_tiled.c
+ Author      : Eduardo Ribeiro
+ Description : Attribute totals calculated from transposed tiles of
+			   disjoint matrix lines
+ ============================================================================
+ */
+
+#include "set_cover_tiled.h"
+
+#include "disjoint_matrix_mpi.h"
+#include "set_cover.h"
+#include "types/dataset_t.h"
+#include "types/dm_segment_t.h"
+#include "types/dm_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/bit.h"
+#include "xor_kernels.h"
+
+#ifdef DEBUG
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#endif
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * Which lines of the disjoint matrix are added to the tiles
+ */
+typedef enum tile_filter_t
+{
+	ALL_LINES,
+	LINES_NOT_SET,
+	LINES_SET
+} tile_filter_t;
+
+/**
+ * How the column of the selected attribute updates the covered lines, when
+ * it's generated in the same pass as the totals
+ */
+typedef struct column_update_t
+{
+	/**
+	 * Word and bit of the selected attribute
+	 */
+	uint64_t attribute_word;
+	uint8_t attribute_bit;
+
+	/**
+	 * The covered lines, updated with the lines of the column
+	 */
+	word_t* covered_lines;
+
+	/**
+	 * The column. When subtracting only the lines that were not covered
+	 * are stored
+	 */
+	word_t* column;
+} column_update_t;
+
+/**
+ * Sends the lines stored in the tile to the kernels
+ */
+static void count_tile(const xor_kernels_t* kernels, xor_counters_t* counters,
+					   const word_t* const* la, const word_t* const* lb,
+					   const uint64_t cw, const uint64_t n_lines,
+					   const bool subtract, uint64_t* totals)
+{
+	if (counters->n_lines + n_lines > kernels->max_lines)
+	{
+		kernels->flush(counters, subtract, totals);
+	}
+
+	kernels->count_lines(counters, la, lb, cw, n_lines);
+}
+
+/**
+ * The lines of one word of the covered lines array, and the lines already
+ * selected to be sent to the kernels
+ */
+typedef struct tile_t
+{
+	const word_t* block_la[TILE_LINES];
+	const word_t* block_lb[TILE_LINES];
+
+	const word_t* tile_la[TILE_LINES];
+	const word_t* tile_lb[TILE_LINES];
+
+	uint64_t n_block_lines;
+	uint64_t n_tile_lines;
+
+	/**
+	 * The lines of the block that are visited, line i is bit
+	 * WORD_BITS - 1 - i. The other lines are a line XORed with itself
+	 */
+	word_t block_mask;
+} tile_t;
+
+/**
+ * Adds the lines of block w selected by filter to the tile, and sends the
+ * tile to the kernels when it's full.
+ * If update is not NULL the column bits of the block are generated first.
+ */
+static void add_block_to_tile(const xor_kernels_t* kernels,
+							  xor_counters_t* counters, tile_t* tile,
+							  const tile_filter_t filter, const word_t* lines,
+							  const column_update_t* update, const uint64_t w,
+							  const uint64_t cw, const bool subtract,
+							  uint64_t* totals)
+{
+	uint64_t n = tile->n_block_lines;
+
+	if (update != NULL)
+	{
+		word_t bits
+			= kernels->column_bits(tile->block_la, tile->block_lb,
+								   update->attribute_word,
+								   update->attribute_bit, n);
+
+		update->column[w]
+			= subtract ? bits & ~update->covered_lines[w] : bits;
+		update->covered_lines[w] |= bits;
+	}
+
+	// Line i of the block is bit WORD_BITS - 1 - i
+	word_t full_mask = n == WORD_BITS ? ~0UL : ~(~0UL >> n);
+
+	word_t mask = tile->block_mask;
+	if (filter == LINES_NOT_SET)
+	{
+		mask &= ~lines[w];
+	}
+	else if (filter == LINES_SET)
+	{
+		mask &= lines[w];
+	}
+
+	tile->n_block_lines = 0;
+	tile->block_mask	= 0;
+
+	// The full block is a tile
+	if (mask == full_mask && tile->n_tile_lines == 0)
+	{
+		count_tile(kernels, counters, tile->block_la, tile->block_lb, cw, n,
+				   subtract, totals);
+		return;
+	}
+
+	while (mask != 0)
+	{
+		uint64_t i = __builtin_clzll(mask);
+		mask &= ~AND_MASK_TABLE[WORD_BITS - 1 - i];
+
+		tile->tile_la[tile->n_tile_lines] = tile->block_la[i];
+		tile->tile_lb[tile->n_tile_lines] = tile->block_lb[i];
+		tile->n_tile_lines++;
+
+		if (tile->n_tile_lines == TILE_LINES)
+		{
+			count_tile(kernels, counters, tile->tile_la, tile->tile_lb, cw,
+					   tile->n_tile_lines, subtract, totals);
+			tile->n_tile_lines = 0;
+		}
+	}
+}
+
+/**
+ * Adds the lines of the segments of dm to the tiles. The lines that are not
+ * visited, as the worklist may skip some, are left out of the block mask.
+ * block_word is set to the word of the last block, that is added to the
+ * tiles by the caller
+ */
+static void add_segment_lines(const dataset_t* dataset, const dm_t* dm,
+							  const xor_kernels_t* kernels,
+							  xor_counters_t* counters, tile_t* tile,
+							  const tile_filter_t filter, const word_t* lines,
+							  const column_update_t* update, const uint64_t cw,
+							  const bool subtract, uint64_t* block_word,
+							  uint64_t* totals)
+{
+	uint64_t stride = dataset->line_stride;
+	word_t** opc	= dataset->observations_per_class;
+
+	dm_segment_t segment;
+
+	for (bool more = first_dm_segment(dataset, dm, &segment); more;
+		 more = next_dm_segment(dataset, dm, &segment))
+	{
+		word_t* la = opc[segment.classA] + segment.indexA * stride;
+		word_t* lb = opc[segment.classB] + segment.indexB * stride;
+
+		for (uint64_t i = 0; i < segment.n_lines; i++, lb += stride)
+		{
+			uint64_t cl = segment.line + i;
+
+			// The worklist may skip the rest of the block
+			if (tile->n_block_lines > 0 && cl / WORD_BITS != *block_word)
+			{
+				add_block_to_tile(kernels, counters, tile, filter, lines,
+								  update, *block_word, cw, subtract, totals);
+			}
+
+			*block_word = cl / WORD_BITS;
+
+			// And the lines before cl
+			uint64_t position = cl % WORD_BITS;
+			while (tile->n_block_lines < position)
+			{
+				tile->block_la[tile->n_block_lines] = la;
+				tile->block_lb[tile->n_block_lines] = la;
+				tile->n_block_lines++;
+			}
+
+			tile->block_la[position] = la;
+			tile->block_lb[position] = lb;
+			tile->n_block_lines		 = position + 1;
+			tile->block_mask |= AND_MASK_TABLE[WORD_BITS - 1 - position];
+
+			if (tile->n_block_lines == TILE_LINES)
+			{
+				add_block_to_tile(kernels, counters, tile, filter, lines,
+								  update, *block_word, cw, subtract, totals);
+			}
+		}
+	}
+}
+
+/**
+ * Adds the lines of dm to the tiles, for the dense 2-class lines: each block
+ * has the next TILE_LINES lines, so every line of the block is visited.
+ * block_word is set to the word of the last block, that is added to the
+ * tiles by the caller if it's not full
+ */
+static void add_dense_lines(const dataset_t* dataset, const dm_t* dm,
+							const xor_kernels_t* kernels,
+							xor_counters_t* counters, tile_t* tile,
+							const tile_filter_t filter, const word_t* lines,
+							const column_update_t* update, const uint64_t cw,
+							const bool subtract, uint64_t* block_word,
+							uint64_t* totals)
+{
+	uint64_t stride	 = dataset->line_stride;
+	uint64_t n_obs_b = dataset->n_observations_per_class[1];
+
+	const word_t* la = dataset->observations_per_class[0]
+		+ dm->initial_class_offsets.indexA * stride;
+	uint64_t ib = dm->initial_class_offsets.indexB;
+
+	*block_word = 0;
+
+	for (uint64_t line = 0; line < dm->s_size; la += stride, ib = 0)
+	{
+		// The observations of class 1 on this row of class 0
+		uint64_t n = n_obs_b - ib;
+		if (n > dm->s_size - line)
+		{
+			n = dm->s_size - line;
+		}
+
+		const word_t* lb = dataset->observations_per_class[1] + ib * stride;
+
+		for (uint64_t i = 0; i < n; i++, lb += stride)
+		{
+			tile->block_la[tile->n_block_lines] = la;
+			tile->block_lb[tile->n_block_lines] = lb;
+			tile->n_block_lines++;
+
+			if (tile->n_block_lines == TILE_LINES)
+			{
+				tile->block_mask = ~0UL;
+
+				add_block_to_tile(kernels, counters, tile, filter, lines,
+								  update, *block_word, cw, subtract, totals);
+				(*block_word)++;
+			}
+		}
+
+		line += n;
+	}
+
+	if (tile->n_block_lines > 0)
+	{
+		tile->block_mask = ~(~0UL >> tile->n_block_lines);
+	}
+}
+
+/**
+ * Walks the lines of the disjoint matrix assigned to this process and
+ * updates the totals with the lines selected by filter.
+ * If update is not NULL, the column is generated and the covered lines
+ * updated on the first cycle, before the lines are filtered
+ */
+static void calculate_totals_tiled(const dataset_t* dataset, const dm_t* dm,
+								   const tile_filter_t filter,
+								   const word_t* lines, const bool subtract,
+								   const column_update_t* update,
+								   uint64_t* totals)
+{
+	const xor_kernels_t* kernels = get_xor_kernels();
+
+	/**
+	 * Counters for the words processed in a cycle
+	 */
+	xor_counters_t counters;
+
+	/**
+	 * The lines of the current block and tile
+	 */
+	tile_t tile;
+
+	/**
+	 * Words of the current cycle. The words without live attributes are
+	 * skipped, and their totals stay 0
+	 */
+	uint64_t cw = 0;
+	uint64_t ew = 0;
+
+	// The column is only generated once. The selected attribute has a
+	// total, so its word is live and there is a first cycle
+	const column_update_t* cycle_update = update;
+
+	for (bool more_cycles = get_totals_cycle(dataset, dm, 0, &cw, &ew);
+		 more_cycles; more_cycles = get_totals_cycle(dataset, dm, ew, &cw, &ew))
+	{
+		reset_xor_counters(&counters, ew - cw);
+
+		tile.n_block_lines = 0;
+		tile.n_tile_lines  = 0;
+		tile.block_mask	   = 0;
+
+		/**
+		 * Word of the covered lines array of the current block
+		 */
+		uint64_t block_word = 0;
+
+		if (is_dense_dm(dm))
+		{
+			add_dense_lines(dataset, dm, kernels, &counters, &tile, filter,
+							lines, cycle_update, cw, subtract, &block_word,
+							totals + cw * WORD_BITS);
+		}
+		else
+		{
+			add_segment_lines(dataset, dm, kernels, &counters, &tile, filter,
+							  lines, cycle_update, cw, subtract, &block_word,
+							  totals + cw * WORD_BITS);
+		}
+
+		if (tile.n_block_lines > 0)
+		{
+			add_block_to_tile(kernels, &counters, &tile, filter, lines,
+							  cycle_update, block_word, cw, subtract,
+							  totals + cw * WORD_BITS);
+		}
+
+		if (tile.n_tile_lines > 0)
+		{
+			count_tile(kernels, &counters, tile.tile_la, tile.tile_lb, cw,
+					   tile.n_tile_lines, subtract, totals + cw * WORD_BITS);
+		}
+
+		if (counters.n_lines > 0)
+		{
+			kernels->flush(&counters, subtract, totals + cw * WORD_BITS);
+		}
+
+		cycle_update = NULL;
+	}
+}
+
+#ifdef DEBUG
+/**
+ * Compares the totals calculated by the kernels with the ones calculated
+ * bit by bit
+ */
+static bool has_same_totals(const uint64_t* totals, const uint64_t* expected,
+							const uint64_t n_attributes)
+{
+	for (uint64_t i = 0; i < n_attributes; i++)
+	{
+		if (totals[i] != expected[i])
+		{
+			fprintf(stderr,
+					"%s kernels totals mismatch on attribute %lu: %lu != %lu\n",
+					get_xor_kernels()->name, i, totals[i], expected[i]);
+			return false;
+		}
+	}
+
+	return true;
+}
+#endif
+
+oknok_t calculate_initial_attribute_totals_tiled(const dataset_t* dataset,
+												 const dm_t* dm,
+												 uint64_t* totals)
+{
+	// Reset attributes totals
+	memset(totals, 0, dataset->n_attributes * sizeof(uint64_t));
+
+	calculate_totals_tiled(dataset, dm, ALL_LINES, NULL, false, NULL, totals);
+
+#ifdef DEBUG
+	uint64_t* expected
+		= (uint64_t*) calloc(dataset->n_words * WORD_BITS, sizeof(uint64_t));
+	assert(expected != NULL);
+
+	calculate_initial_attribute_totals(dataset, dm, expected);
+	assert(has_same_totals(totals, expected, dataset->n_attributes));
+
+	free(expected);
+#endif
+
+	return OK;
+}
+
+oknok_t calculate_attribute_totals_add_tiled(const dataset_t* dataset,
+											 const dm_t* dm,
+											 const word_t* covered_lines,
+											 uint64_t* totals)
+{
+	// Reset attributes totals
+	memset(totals, 0, dataset->n_attributes * sizeof(uint64_t));
+
+	calculate_totals_tiled(dataset, dm, LINES_NOT_SET, covered_lines, false,
+						   NULL, totals);
+
+#ifdef DEBUG
+	uint64_t* expected
+		= (uint64_t*) calloc(dataset->n_words * WORD_BITS, sizeof(uint64_t));
+	assert(expected != NULL);
+
+	calculate_attribute_totals_add(dataset, dm, covered_lines, expected);
+	assert(has_same_totals(totals, expected, dataset->n_attributes));
+
+	free(expected);
+#endif
+
+	return OK;
+}
+
+oknok_t calculate_attribute_totals_sub_tiled(const dataset_t* dataset,
+											 const dm_t* dm,
+											 const word_t* covered_lines,
+											 uint64_t* totals)
+{
+#ifdef DEBUG
+	uint64_t* expected
+		= (uint64_t*) calloc(dataset->n_words * WORD_BITS, sizeof(uint64_t));
+	assert(expected != NULL);
+
+	memcpy(expected, totals, dataset->n_words * WORD_BITS * sizeof(uint64_t));
+	calculate_attribute_totals_sub(dataset, dm, covered_lines, expected);
+#endif
+
+	calculate_totals_tiled(dataset, dm, LINES_SET, covered_lines, true, NULL,
+						   totals);
+
+#ifdef DEBUG
+	assert(has_same_totals(totals, expected, dataset->n_attributes));
+
+	free(expected);
+#endif
+
+	return OK;
+}
+
+oknok_t update_attribute_totals_tiled(const dataset_t* dataset,
+									  const dm_t* dm, const int64_t attribute,
+									  const bool subtract,
+									  word_t* covered_lines, word_t* column,
+									  uint64_t* totals)
+{
+#ifdef DEBUG
+	uint64_t* expected
+		= (uint64_t*) calloc(dataset->n_words * WORD_BITS, sizeof(uint64_t));
+	word_t* expected_covered
+		= (word_t*) calloc(dm->n_words_in_a_column, sizeof(word_t));
+	word_t* expected_column
+		= (word_t*) calloc(dm->n_words_in_a_column, sizeof(word_t));
+	assert(expected != NULL && expected_covered != NULL
+		   && expected_column != NULL);
+
+	memcpy(expected, totals, dataset->n_words * WORD_BITS * sizeof(uint64_t));
+	memcpy(expected_covered, covered_lines,
+		   dm->n_words_in_a_column * sizeof(word_t));
+
+	get_column(dataset, dm, attribute, expected_column);
+
+	if (subtract)
+	{
+		for (uint64_t w = 0; w < dm->n_words_in_a_column; w++)
+		{
+			expected_column[w] &= ~expected_covered[w];
+		}
+
+		calculate_attribute_totals_sub(dataset, dm, expected_column, expected);
+		update_covered_lines(expected_column, dm->n_words_in_a_column,
+							 expected_covered);
+	}
+	else
+	{
+		update_covered_lines(expected_column, dm->n_words_in_a_column,
+							 expected_covered);
+		calculate_attribute_totals_add(dataset, dm, expected_covered,
+									   expected);
+	}
+#endif
+
+	// The words of the column without lines in the worklist are not visited
+	if (dm->segments != NULL)
+	{
+		memset(column, 0, dm->n_words_in_a_column * sizeof(word_t));
+	}
+
+	column_update_t update = { .attribute_word = attribute / WORD_BITS,
+							   .attribute_bit
+							   = WORD_BITS - (attribute % WORD_BITS) - 1,
+							   .covered_lines = covered_lines,
+							   .column		  = column };
+
+	if (subtract)
+	{
+		calculate_totals_tiled(dataset, dm, LINES_SET, column, true, &update,
+							   totals);
+	}
+	else
+	{
+		// Reset attributes totals
+		memset(totals, 0, dataset->n_attributes * sizeof(uint64_t));
+
+		calculate_totals_tiled(dataset, dm, LINES_NOT_SET, covered_lines,
+							   false, &update, totals);
+	}
+
+#ifdef DEBUG
+	assert(has_same_totals(totals, expected, dataset->n_attributes));
+	assert(memcmp(covered_lines, expected_covered,
+				  dm->n_words_in_a_column * sizeof(word_t))
+		   == 0);
+	assert(memcmp(column, expected_column,
+				  dm->n_words_in_a_column * sizeof(word_t))
+		   == 0);
+
+	free(expected);
+	free(expected_covered);
+	free(expected_column);
+#endif
+
+	return OK;
+}
@@ -0,0 +1,67 @@
+/*
+ ============================================================================
+ Name        : set_cover_tiled.h
+ Author      : Eduardo Ribeiro
+ Description : Attribute totals calculated from transposed tiles of
+			   disjoint matrix lines
+ ============================================================================
+ */
+
+#ifndef SET_COVER_TILED_H
+#define SET_COVER_TILED_H
+
+#include "types/dataset_t.h"
+#include "types/dm_t.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * These functions have the same behaviour as the ones in set_cover.h.
+ *
+ * Instead of checking every bit of every line, they send tiles of
+ * TILE_LINES lines of the disjoint matrix to the selected XOR kernels
+ * (see xor_kernels.h), that count the bits of each column at once.
+ *
+ * In DEBUG builds the results are checked against the set_cover.h versions.
+ */
+
+/**
+ * Calculates the initial attributes totals
+ */
+oknok_t calculate_initial_attribute_totals_tiled(const dataset_t* dataset,
+												 const dm_t* dm,
+												 uint64_t* totals);
+
+/**
+ * Calculates the attributes totals for the lines not yet covered
+ */
+oknok_t calculate_attribute_totals_add_tiled(const dataset_t* dataset,
+											 const dm_t* dm,
+											 const word_t* covered_lines,
+											 uint64_t* totals);
+
+/**
+ * Removes from the attributes totals the lines set in covered_lines
+ */
+oknok_t calculate_attribute_totals_sub_tiled(const dataset_t* dataset,
+											 const dm_t* dm,
+											 const word_t* covered_lines,
+											 uint64_t* totals);
+
+/**
+ * Gets the column of attribute, updates the covered lines and the totals in
+ * the same pass over the lines.
+ * If subtract is false the totals are calculated again for the lines not
+ * covered, otherwise the lines covered by attribute are removed from the
+ * totals and column only has the lines that were not covered before
+ */
+oknok_t update_attribute_totals_tiled(const dataset_t* dataset,
+									  const dm_t* dm, const int64_t attribute,
+									  const bool subtract,
+									  word_t* covered_lines, word_t* column,
+									  uint64_t* totals);
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ ============================================================================
+ Name        : attributes_map_t.h
+ Author      : Eduardo Ribeiro
+ Description : Datatype relating the attributes of the dataset that take
+			   part in the set cover to the attributes of the input
+ ============================================================================
+ */
+
+#ifndef ATTRIBUTES_MAP_T_H
+#define ATTRIBUTES_MAP_T_H
+
+#include <stdint.h>
+
+typedef struct attributes_map_t
+{
+	/**
+	 * Number of attributes of the input, with the jnsqs
+	 */
+	uint64_t n_attributes;
+
+	/**
+	 * Number of words needed to store the input attributes
+	 */
+	uint64_t n_words;
+
+	/**
+	 * Number of attributes kept for the set cover
+	 */
+	uint64_t n_kept;
+
+	/**
+	 * Input attribute of each kept attribute
+	 */
+	uint64_t* original;
+
+	/**
+	 * Kept attribute with the same disjoint matrix column as each input
+	 * attribute, or -1 if the column has no bits set
+	 */
+	int64_t* kept;
+} attributes_map_t;
+
+#endif // ATTRIBUTES_MAP_T_H
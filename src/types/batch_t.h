@@ -0,0 +1,47 @@
+/*
+ ============================================================================
+ Name        : batch_t.h
+ Author      : Eduardo Ribeiro
+ Description : Datatype representing the datasets of a batch run
+ ============================================================================
+ */
+
+#ifndef BATCH_T_H
+#define BATCH_T_H
+
+#include "mpi.h"
+
+#include <stdint.h>
+
+typedef struct batch_t
+{
+	/**
+	 * Number of datasets in the manifest
+	 */
+	uint64_t n_entries;
+
+	/**
+	 * The manifest text. The file and dataset names point to it
+	 */
+	char* manifest;
+
+	/**
+	 * The file and the dataset names of each entry
+	 */
+	char** filenames;
+	char** datasetnames;
+
+	/**
+	 * The result line of each entry, on the root of the group that ran it.
+	 * NULL for the other entries
+	 */
+	char** results;
+
+	/**
+	 * Index of the next entry to run, on the global root, and its window
+	 */
+	MPI_Win next_window;
+	uint64_t* next_entry;
+} batch_t;
+
+#endif // BATCH_T_H
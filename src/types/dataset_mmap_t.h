@@ -0,0 +1,28 @@
+/*
+ ============================================================================
+ Name        : dataset_mmap_t.h
+ Author      : Eduardo Ribeiro
+ Description : Datatype representing the dataset data mapped from its file
+ ============================================================================
+ */
+
+#ifndef DATASET_MMAP_T_H
+#define DATASET_MMAP_T_H
+
+#include <stddef.h>
+
+typedef struct dataset_mmap_t
+{
+	/**
+	 * Start of the mapping, aligned to a page
+	 */
+	void* address;
+
+	/**
+	 * Size of the mapping in bytes
+	 */
+	size_t length;
+
+} dataset_mmap_t;
+
+#endif // DATASET_MMAP_T_H
@@ -25,6 +25,13 @@ typedef struct dataset_t
 	 */
 	uint64_t n_words;
 
+	/**
+	 * Number of words between two lines in data.
+	 * Can be bigger than n_words if we need less bits for jnsqs than for
+	 * the class
+	 */
+	uint64_t line_stride;
+
 	/**
 	 * Number of bits needed to store jnsqs (max 32)
 	 */
@@ -56,11 +63,29 @@ typedef struct dataset_t
 	uint64_t* n_observations_per_class;
 
 	/**
-	 * Array with pointers for each observation per class.
-	 * They reference lines in *data
+	 * Array with pointers to the first observation of each class.
+	 * The observations are grouped by class, so observation i of class c
+	 * is observations_per_class[c] + i * line_stride
 	 */
 	word_t** observations_per_class;
 
+	/**
+	 * Array with pointers to the transposed attributes of each class, or NULL
+	 * if the dataset is not transposed.
+	 * Attribute a of class c is the bitset of the observations of class c at
+	 * columns_per_class[c] + a * get_class_column_words(dataset, c)
+	 */
+	word_t** columns_per_class;
+
+	/**
+	 * Number of observations of class A in each block of the disjoint
+	 * matrix, and of class B in each chunk, when the dataset is streamed from
+	 * the file (see set_dm_blocks). 0 if the lines of each observation of
+	 * class A are not split in blocks
+	 */
+	uint64_t n_block_observations;
+	uint64_t n_chunk_observations;
+
 } dataset_t;
 
 #endif // DATASET_T_H
@@ -0,0 +1,52 @@
+/*
+ ============================================================================
+ Name        : dm_segment_t.h
+ Author      : Eduardo Ribeiro
+ Description : Datatype representing a run of consecutive disjoint matrix
+			   lines of one pair of classes
+ ============================================================================
+ */
+
+#ifndef DM_SEGMENT_T_H
+#define DM_SEGMENT_T_H
+
+#include <stdint.h>
+
+/**
+ * The disjoint matrix is made of one block for each pair of classes, with
+ * one row for each observation of class A and one line in the row for each
+ * observation of class B. The rows of the blocks of class A are stored one
+ * after the other, so the lines of a process are a sequence of segments:
+ * one observation of class A with consecutive observations of class B
+ */
+typedef struct dm_segment_t
+{
+	/**
+	 * Class and index of the observation of class A
+	 */
+	uint64_t classA;
+	uint64_t indexA;
+
+	/**
+	 * Class and index of the first observation of class B
+	 */
+	uint64_t classB;
+	uint64_t indexB;
+
+	/**
+	 * First line of the segment, relative to the start of the dm lines
+	 */
+	uint64_t line;
+
+	/**
+	 * Number of lines of the segment
+	 */
+	uint64_t n_lines;
+
+	/**
+	 * Position of the segment in the worklist of the dm, if it has one
+	 */
+	uint64_t index;
+} dm_segment_t;
+
+#endif // DM_SEGMENT_T_H
@@ -11,7 +11,10 @@
 #define DM_T_H
 
 #include "class_offsets_t.h"
+#include "dm_segment_t.h"
+#include "word_t.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
 typedef struct dm_t
@@ -40,6 +43,31 @@ typedef struct dm_t
 	 * Number of lines we can generate
 	 */
 	uint64_t s_size;
+
+	/**
+	 * Worklist with the segments of the lines that were not covered when it
+	 * was compacted, or NULL to visit all the lines
+	 */
+	dm_segment_t* segments;
+
+	/**
+	 * Number of segments in the worklist, and their number of lines
+	 */
+	uint64_t n_segments;
+	uint64_t n_segment_lines;
+
+	/**
+	 * Bit w is set if word w of the dataset lines has attributes that can
+	 * still be selected, or NULL to visit all the words
+	 */
+	const word_t* live_attribute_words;
+
+	/**
+	 * The lines are the observations of class 0 against the observations of
+	 * class 1, so while there is no worklist they are walked with a dense
+	 * double loop instead of the segments. Set with the lines of dm
+	 */
+	bool dense_2_classes;
 } dm_t;
 
 #endif // DM_T_H
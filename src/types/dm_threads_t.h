@@ -0,0 +1,46 @@
+/*
+ ============================================================================
+ Name        : dm_threads_t.h
+ Author      : Eduardo Ribeiro
+ Description : Datatype representing the parts of the disjoint matrix of
+			   one process that are processed by each OpenMP thread
+ ============================================================================
+ */
+
+#ifndef DM_THREADS_T_H
+#define DM_THREADS_T_H
+
+#include "dm_t.h"
+
+#include <stdint.h>
+
+typedef struct dm_threads_t
+{
+	/**
+	 * Number of threads
+	 */
+	uint64_t n_threads;
+
+	/**
+	 * The offset of the process part in the full matrix
+	 */
+	uint64_t s_offset;
+
+	/**
+	 * The part of the matrix for each thread.
+	 * Every part starts on a word of the process covered lines array
+	 */
+	dm_t* dms;
+
+	/**
+	 * Number of totals for each thread
+	 */
+	uint64_t n_totals;
+
+	/**
+	 * Attribute totals for each thread
+	 */
+	uint64_t* totals;
+} dm_threads_t;
+
+#endif // DM_THREADS_T_H
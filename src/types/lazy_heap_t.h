@@ -0,0 +1,53 @@
+/*
+ ============================================================================
+ Name        : lazy_heap_t.h
+ Author      : Eduardo Ribeiro
+ Description : Datatype representing the max-heap of attribute totals upper
+			   bounds used by the lazy set cover
+ ============================================================================
+ */
+
+#ifndef LAZY_HEAP_T_H
+#define LAZY_HEAP_T_H
+
+#include <stdint.h>
+
+typedef struct lazy_candidate_t
+{
+	/**
+	 * Upper bound of the number of uncovered lines covered by the attribute
+	 */
+	uint64_t bound;
+
+	/**
+	 * The attribute index
+	 */
+	int64_t attribute;
+
+	/**
+	 * The round in which the bound was calculated.
+	 * If it's the current round the bound is the attribute total
+	 */
+	uint64_t round;
+} lazy_candidate_t;
+
+typedef struct lazy_heap_t
+{
+	/**
+	 * Number of candidates in the heap
+	 */
+	uint64_t size;
+
+	/**
+	 * The candidates, ordered by bound and then by attribute index
+	 */
+	lazy_candidate_t* candidates;
+
+	/**
+	 * Time (in nanoseconds) of the last full totals pass, summed over all
+	 * processes
+	 */
+	uint64_t full_pass_time;
+} lazy_heap_t;
+
+#endif // LAZY_HEAP_T_H
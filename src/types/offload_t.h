@@ -0,0 +1,70 @@
+/*
+ ============================================================================
+ Name        : offload_t.h
+ Author      : Eduardo Ribeiro
+ Description : Datatype representing the set cover state kept on an
+			   OpenMP target device
+ ============================================================================
+ */
+
+#ifndef OFFLOAD_T_H
+#define OFFLOAD_T_H
+
+#include "dm_segment_t.h"
+#include "word_t.h"
+
+#include <stdint.h>
+
+typedef struct offload_t
+{
+	/**
+	 * The OpenMP device number
+	 */
+	int device;
+
+	/**
+	 * Number of attributes and classes of the dataset
+	 */
+	uint64_t n_attributes;
+	uint64_t n_classes;
+
+	/**
+	 * Number of words of the lines arrays
+	 */
+	uint64_t n_words_in_a_column;
+
+	/**
+	 * The covered lines and attribute totals of the process, on the host
+	 */
+	word_t* covered_lines;
+	uint64_t* totals;
+
+	/**
+	 * The transposed dataset on the device, and where the columns of each
+	 * class start and how many words each column has
+	 */
+	word_t* device_columns;
+	uint64_t* device_class_offsets;
+	uint64_t* device_class_words;
+
+	/**
+	 * The segments of the disjoint matrix lines of this process on the
+	 * device
+	 */
+	dm_segment_t* device_segments;
+	uint64_t n_segments;
+
+	/**
+	 * The covered lines and attribute totals on the device
+	 */
+	word_t* device_covered_lines;
+	uint64_t* device_totals;
+
+	/**
+	 * The lines counted on the device: the uncovered lines or the lines
+	 * covered by the last attribute
+	 */
+	word_t* device_lines;
+} offload_t;
+
+#endif // OFFLOAD_T_H
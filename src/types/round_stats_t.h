@@ -0,0 +1,74 @@
+/*
+ ============================================================================
+ Name        : round_stats_t.h
+ Author      : Eduardo Ribeiro
+ Description : Datatype representing the time spent by one process on each
+			   phase of the set cover rounds
+ ============================================================================
+ */
+
+#ifndef ROUND_STATS_T_H
+#define ROUND_STATS_T_H
+
+#include <stdint.h>
+
+/**
+ * The phases of a set cover round
+ */
+typedef enum stats_phase_t
+{
+	/**
+	 * Calculating the attribute totals. When the column, the covered lines
+	 * and the totals are updated in a single pass it is counted here
+	 */
+	STATS_TOTALS,
+
+	/**
+	 * Getting the column of the best attribute
+	 */
+	STATS_COLUMN,
+
+	/**
+	 * Reducing the totals between processes
+	 */
+	STATS_REDUCE,
+
+	/**
+	 * Moving lines between processes
+	 */
+	STATS_BALANCE,
+
+	N_STATS_PHASES
+} stats_phase_t;
+
+typedef struct round_stats_t
+{
+	/**
+	 * Number of finished rounds
+	 */
+	uint64_t n_rounds;
+
+	/**
+	 * Number of rounds that fit in the arrays
+	 */
+	uint64_t capacity;
+
+	/**
+	 * Seconds spent on each phase of each round, N_STATS_PHASES per round
+	 */
+	double* times;
+
+	/**
+	 * Lines of the process not covered at the end of each round
+	 */
+	uint64_t* n_uncovered_lines;
+
+	/**
+	 * The phase being timed and when it started
+	 */
+	stats_phase_t phase;
+	double start;
+
+} round_stats_t;
+
+#endif // ROUND_STATS_T_H
@@ -0,0 +1,36 @@
+/*
+ ============================================================================
+ Name        : shared_window_t.h
+ Author      : Eduardo Ribeiro
+ Description : Datatype representing a shared memory window of a node
+ ============================================================================
+ */
+
+#ifndef SHARED_WINDOW_T_H
+#define SHARED_WINDOW_T_H
+
+#include "word_t.h"
+
+#include "mpi.h"
+
+#include <stdint.h>
+
+typedef struct shared_window_t
+{
+	/**
+	 * The window, allocated by the node root. MPI_WIN_NULL if there is none
+	 */
+	MPI_Win window;
+
+	/**
+	 * Number of words allocated by the node root
+	 */
+	uint64_t n_words;
+
+	/**
+	 * The memory of the node root, on every process of the node
+	 */
+	word_t* data;
+} shared_window_t;
+
+#endif // SHARED_WINDOW_T_H
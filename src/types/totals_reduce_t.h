@@ -0,0 +1,116 @@
+/*
+ ============================================================================
+ Name        : totals_reduce_t.h
+ Author      : Eduardo Ribeiro
+ Description : Datatype representing the state of the global reduction of
+			   the attribute totals
+ ============================================================================
+ */
+
+#ifndef TOTALS_REDUCE_T_H
+#define TOTALS_REDUCE_T_H
+
+#include "mpi.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct totals_reduce_t
+{
+	/**
+	 * Number of attributes
+	 */
+	uint64_t n_attributes;
+
+	/**
+	 * Number of processes
+	 */
+	int size;
+
+	/**
+	 * The global totals fit in 32 bits, so the full totals are reduced as
+	 * 32 bit counts and each pair is sent in one word
+	 */
+	bool narrow;
+
+	/**
+	 * The 32 bit local and global totals of the narrow reductions
+	 */
+	uint32_t* narrow_totals;
+	uint32_t* narrow_global_totals;
+
+	/**
+	 * The attributes before first_live or from first_live + n_live on have
+	 * a global total of 0, that can't change, so the dense reductions skip
+	 * them
+	 */
+	uint64_t first_live;
+	uint64_t n_live;
+
+	/**
+	 * The local totals sent on the last reduction
+	 */
+	uint64_t* last_totals;
+
+	/**
+	 * The (attribute, delta) pairs of this process
+	 */
+	uint64_t* pairs;
+
+	/**
+	 * The pairs of all processes
+	 */
+	uint64_t* all_pairs;
+
+	/**
+	 * Number of words of pairs sent by each process and where they are
+	 * stored in all_pairs
+	 */
+	int* counts;
+	int* displs;
+
+	/**
+	 * The reduction started and not finished yet
+	 */
+	MPI_Request request;
+
+	/**
+	 * Number of words of pairs of all processes in that reduction
+	 */
+	uint64_t total_words;
+
+	/**
+	 * That reduction sends the full totals
+	 */
+	bool dense;
+
+	/**
+	 * Processes of this node and node roots, when the totals of each node
+	 * are summed first. node_comm is MPI_COMM_NULL otherwise
+	 */
+	MPI_Comm node_comm;
+	MPI_Comm roots_comm;
+	int node_rank;
+	int node_size;
+
+	/**
+	 * Shared memory of the node, with the totals of each process of the
+	 * node, the node totals and the global totals
+	 */
+	MPI_Win node_window;
+	uint64_t* node_slots;
+	uint64_t* node_totals;
+	uint64_t* node_global_totals;
+
+	/**
+	 * Number of sparse reductions done so far
+	 */
+	uint64_t n_sparse;
+
+	/**
+	 * Number of dense reductions done so far
+	 */
+	uint64_t n_dense;
+} totals_reduce_t;
+
+#endif // TOTALS_REDUCE_T_H
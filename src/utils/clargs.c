@@ -10,21 +10,66 @@
 
 #include "utils/cargs.h"
 
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
 
+/**
+ * Reads the decimal number in value. Returns false if the value is missing
+ * or isn't a number
+ */
+static bool read_number(const char* value, uint64_t* number)
+{
+	// strtoull also takes leading spaces and signs
+	if (value == NULL || *value < '0' || *value > '9')
+	{
+		return false;
+	}
+
+	char* end;
+	errno	= 0;
+	*number = strtoull(value, &end, 10);
+
+	return *end == '\0' && errno == 0;
+}
+
 int read_args(int argc, char** argv, clargs_t* args)
 {
 	char identifier;
 	const char* value;
 	cag_option_context context;
 
+	/**
+	 * The numeric values read so far are valid
+	 */
+	bool valid_numbers = true;
+
 	/**
 	 * Init/Reset initial values
 	 */
-	args->datasetname = NULL;
-	args->filename	  = NULL;
+	args->datasetname	= NULL;
+	args->filename		= NULL;
+	args->kernels		= NULL;
+	args->max_dm_memory = 0;
+
+	args->max_transposed_memory = UINT64_MAX;
+	args->lazy			= false;
+	args->pipeline		= false;
+	args->offload		= false;
+	args->node_reduce	= false;
+
+	args->write_preprocessed = false;
+	args->out_of_core_memory = 0;
+	args->checkpoint		 = NULL;
+	args->checkpoint_rounds	 = 1;
+	args->resume			 = false;
+	args->stats				 = NULL;
+	args->batch				 = NULL;
+	args->batch_groups		 = 1;
+	args->batch_results		 = NULL;
 
 	/**
 	 * This is the main configuration of all options available.
@@ -41,6 +86,141 @@ int read_args(int argc, char** argv, clargs_t* args)
 							   .value_name	   = "dataset",
 							   .description	   = "Dataset identifier" },
 
+							 { .identifier	   = 'k',
+							   .access_letters = NULL,
+							   .access_name	   = "kernels",
+							   .value_name	   = "name",
+							   .description
+							   = "XOR kernels: generic, avx2 or avx512 (default: "
+								 "best for this CPU)" },
+
+							 { .identifier	   = 'm',
+							   .access_letters = NULL,
+							   .access_name	   = "max-dm-memory",
+							   .value_name	   = "MB",
+							   .description
+							   = "Store the disjoint matrix lines of each "
+								 "process in memory if they fit in MB "
+								 "megabytes (default: 0, never)" },
+
+							 { .identifier	   = 't',
+							   .access_letters = NULL,
+							   .access_name	   = "max-transposed-memory",
+							   .value_name	   = "MB",
+							   .description
+							   = "Keep a transposed copy of the dataset in "
+								 "each node, to generate the columns faster, "
+								 "if it fits in MB megabytes (default: the "
+								 "available memory, 0: never)" },
+
+							 { .identifier	   = 'l',
+							   .access_letters = NULL,
+							   .access_name	   = "lazy",
+							   .description
+							   = "Only evaluate the best candidate attributes "
+								 "on each round (lazy set cover)" },
+
+							 { .identifier	   = 'p',
+							   .access_letters = NULL,
+							   .access_name	   = "pipeline",
+							   .description
+							   = "Generate the column of the best local "
+								 "attribute while the totals are reduced. "
+								 "Not used with --lazy" },
+
+							 { .identifier	   = 'g',
+							   .access_letters = NULL,
+							   .access_name	   = "offload",
+							   .description
+							   = "Calculate the totals and the columns on the "
+								 "OpenMP target device (GPU), or on the host "
+								 "if there is none. Not used with --lazy, "
+								 "--max-dm-memory or without the transposed "
+								 "dataset" },
+
+							 { .identifier	   = 'n',
+							   .access_letters = NULL,
+							   .access_name	   = "node-reduce",
+							   .description
+							   = "Sum the totals of the processes of each "
+								 "node in shared memory and only reduce them "
+								 "between the nodes. Not used with --lazy" },
+
+							 { .identifier	   = 'w',
+							   .access_letters = NULL,
+							   .access_name	   = "write-preprocessed",
+							   .description
+							   = "Write the sorted dataset, without duplicates "
+								 "and with the JNSQs, to the file. The next "
+								 "runs use it without preprocessing" },
+
+							 { .identifier	   = 'o',
+							   .access_letters = NULL,
+							   .access_name	   = "out-of-core",
+							   .value_name	   = "MB",
+							   .description
+							   = "Stream the preprocessed dataset from the "
+								 "file in blocks, holding about MB "
+								 "megabytes of its lines in each node" },
+
+							 { .identifier	   = 'c',
+							   .access_letters = NULL,
+							   .access_name	   = "checkpoint",
+							   .value_name	   = "filename",
+							   .description
+							   = "Save the selected attributes to filename "
+								 "during the set cover" },
+
+							 { .identifier	   = 'i',
+							   .access_letters = NULL,
+							   .access_name	   = "checkpoint-rounds",
+							   .value_name	   = "N",
+							   .description
+							   = "Save the checkpoint every N selected "
+								 "attributes (default: 1)" },
+
+							 { .identifier	   = 'r',
+							   .access_letters = NULL,
+							   .access_name	   = "resume",
+							   .description
+							   = "Start from the checkpoint file, if it "
+								 "exists. Any number of processes can be "
+								 "used" },
+
+							 { .identifier	   = 's',
+							   .access_letters = NULL,
+							   .access_name	   = "stats",
+							   .value_name	   = "filename",
+							   .description
+							   = "Save the time of each set cover phase of "
+								 "every process and round to filename (CSV)" },
+
+							 { .identifier	   = 'b',
+							   .access_letters = NULL,
+							   .access_name	   = "batch",
+							   .value_name	   = "manifest",
+							   .description
+							   = "Run the datasets of manifest, a file and a "
+								 "dataset name on each line, instead of -f "
+								 "and -d. Needs --batch-results" },
+
+							 { .identifier	   = 'a',
+							   .access_letters = NULL,
+							   .access_name	   = "batch-groups",
+							   .value_name	   = "N",
+							   .description
+							   = "Split the processes in N groups that run "
+								 "the batch datasets at the same time "
+								 "(default: 1)" },
+
+							 { .identifier	   = 'e',
+							   .access_letters = NULL,
+							   .access_name	   = "batch-results",
+							   .value_name	   = "filename",
+							   .description
+							   = "Save the solutions of the batch datasets to "
+								 "filename" },
+
 							 { .identifier	   = 'h',
 							   .access_letters = "h",
 							   .access_name	   = "help",
@@ -65,6 +245,69 @@ int read_args(int argc, char** argv, clargs_t* args)
 				value			  = cag_option_get_value(&context);
 				args->datasetname = value;
 				break;
+			case 'k':
+				value		  = cag_option_get_value(&context);
+				args->kernels = value;
+				break;
+			case 'm':
+				value		  = cag_option_get_value(&context);
+				valid_numbers = read_number(value, &args->max_dm_memory)
+					&& valid_numbers;
+				break;
+			case 't':
+				value		  = cag_option_get_value(&context);
+				valid_numbers = read_number(value, &args->max_transposed_memory)
+					&& valid_numbers;
+				break;
+			case 'l':
+				args->lazy = true;
+				break;
+			case 'p':
+				args->pipeline = true;
+				break;
+			case 'g':
+				args->offload = true;
+				break;
+			case 'n':
+				args->node_reduce = true;
+				break;
+			case 'w':
+				args->write_preprocessed = true;
+				break;
+			case 'o':
+				value		  = cag_option_get_value(&context);
+				valid_numbers = read_number(value, &args->out_of_core_memory)
+					&& valid_numbers;
+				break;
+			case 'c':
+				value			 = cag_option_get_value(&context);
+				args->checkpoint = value;
+				break;
+			case 'i':
+				value		  = cag_option_get_value(&context);
+				valid_numbers = read_number(value, &args->checkpoint_rounds)
+					&& valid_numbers;
+				break;
+			case 'r':
+				args->resume = true;
+				break;
+			case 's':
+				value		= cag_option_get_value(&context);
+				args->stats = value;
+				break;
+			case 'b':
+				value		= cag_option_get_value(&context);
+				args->batch = value;
+				break;
+			case 'a':
+				value		  = cag_option_get_value(&context);
+				valid_numbers = read_number(value, &args->batch_groups)
+					&& valid_numbers;
+				break;
+			case 'e':
+				value				= cag_option_get_value(&context);
+				args->batch_results = value;
+				break;
 			case 'h':
 				printf("Usage: %s [OPTION]...\n", argv[0]);
 				cag_option_print(options, CAG_ARRAY_SIZE(options), stdout);
@@ -72,7 +315,14 @@ int read_args(int argc, char** argv, clargs_t* args)
 		}
 	}
 
-	if (args->filename == NULL || args->datasetname == NULL)
+	// The checkpoints and the stats are saved for a single dataset
+	bool batch_ok = args->batch == NULL
+		? args->filename != NULL && args->datasetname != NULL
+		: args->batch_results != NULL && args->batch_groups > 0
+			&& args->checkpoint == NULL && args->stats == NULL;
+
+	if (!valid_numbers || !batch_ok || args->checkpoint_rounds == 0
+		|| (args->resume && args->checkpoint == NULL))
 	{
 		printf("Usage: %s [OPTION]...\n", argv[0]);
 		cag_option_print(options, CAG_ARRAY_SIZE(options), stdout);
@@ -15,6 +15,9 @@
 #define READ_CL_ARGS_OK	 0
 #define READ_CL_ARGS_NOK 1
 
+#include <stdbool.h>
+#include <stdint.h>
+
 /**
  * Structure to store command line options
  */
@@ -29,6 +32,97 @@ typedef struct clargs_t
 	 * The dataset identifier
 	 */
 	const char* datasetname;
+
+	/**
+	 * The XOR kernels to use. NULL selects the best for this CPU
+	 */
+	const char* kernels;
+
+	/**
+	 * Max memory (in MB) each process can use to store its disjoint matrix
+	 * lines. 0 always generates the lines from the dataset
+	 */
+	uint64_t max_dm_memory;
+
+	/**
+	 * Max memory (in MB) of the transposed copy of the dataset in each node.
+	 * UINT64_MAX uses the memory available when it is made, and 0 always
+	 * generates the columns from the dataset lines
+	 */
+	uint64_t max_transposed_memory;
+
+	/**
+	 * Use the lazy evaluation of the set cover algorithm
+	 */
+	bool lazy;
+
+	/**
+	 * Generate the column of the best local attribute while the totals are
+	 * reduced
+	 */
+	bool pipeline;
+
+	/**
+	 * Calculate the totals on the OpenMP target device, if there is one
+	 */
+	bool offload;
+
+	/**
+	 * Sum the totals of each node in shared memory before reducing them
+	 * between the nodes
+	 */
+	bool node_reduce;
+
+	/**
+	 * Write the preprocessed dataset to the file, so the next runs don't
+	 * need to preprocess it
+	 */
+	bool write_preprocessed;
+
+	/**
+	 * Max memory (in MB) of the lines of the preprocessed dataset each node
+	 * holds while they are streamed from the file. 0 keeps the whole dataset
+	 * in memory
+	 */
+	uint64_t out_of_core_memory;
+
+	/**
+	 * File where the selected attributes are saved. NULL disables the
+	 * checkpoints
+	 */
+	const char* checkpoint;
+
+	/**
+	 * Number of selected attributes between checkpoints
+	 */
+	uint64_t checkpoint_rounds;
+
+	/**
+	 * Start from the checkpoint file, if it exists
+	 */
+	bool resume;
+
+	/**
+	 * File where the time of each phase of each round is saved, for every
+	 * process. NULL doesn't save them
+	 */
+	const char* stats;
+
+	/**
+	 * Manifest with the file and dataset names of the batch run. NULL runs
+	 * the filename and datasetname dataset
+	 */
+	const char* batch;
+
+	/**
+	 * Number of process groups that run the batch datasets at the same time
+	 */
+	uint64_t batch_groups;
+
+	/**
+	 * File where the solutions of the batch datasets are saved
+	 */
+	const char* batch_results;
 } clargs_t;
 
 /**
@@ -0,0 +1,226 @@
+/*
+ ============================================================================
+ Name        : xor_kernels.c
+ Author      : Eduardo Ribeiro
+ Description : Kernels that XOR and count the lines of the disjoint matrix.
+			   The best kernels for the CPU are selected at startup.
+ ============================================================================
+ */
+
+#include "xor_kernels.h"
+
+#include "set_cover.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+#include "utils/bit.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * The selected kernels
+ */
+static const xor_kernels_t* selected_kernels = &XOR_KERNELS_GENERIC;
+
+/**
+ * Stores the lines in the tiles, after the lines already there.
+ * The tile for word t is at data + t * TILE_LINES
+ */
+static void count_lines_generic(xor_counters_t* counters,
+								const word_t* const* la,
+								const word_t* const* lb, const uint64_t cw,
+								const uint64_t n_lines)
+{
+	for (uint64_t t = 0; t < counters->n_words; t++)
+	{
+		word_t* tile = counters->data + t * TILE_LINES + counters->n_lines;
+
+		for (uint64_t i = 0; i < n_lines; i++)
+		{
+			tile[i] = la[i][cw + t] ^ lb[i][cw + t];
+		}
+	}
+
+	counters->n_lines += n_lines;
+}
+
+/**
+ * Transposes the tiles and updates the totals with the number of bits set
+ * in each row. After the transpose, row i has the bits of the attribute i,
+ * for every line stored in the tile.
+ */
+static void flush_generic(xor_counters_t* counters, const bool subtract,
+						  uint64_t* totals)
+{
+	for (uint64_t t = 0; t < counters->n_words; t++)
+	{
+		word_t* tile = counters->data + t * TILE_LINES;
+
+		// Clear lines that were not filled in this round
+		if (counters->n_lines < TILE_LINES)
+		{
+			memset(tile + counters->n_lines, 0,
+				   (TILE_LINES - counters->n_lines) * sizeof(word_t));
+		}
+
+		transpose64(tile);
+
+		uint64_t* tt = totals + t * WORD_BITS;
+
+		if (subtract)
+		{
+			for (uint8_t i = 0; i < WORD_BITS; i++)
+			{
+				tt[i] -= __builtin_popcountll(tile[i]);
+			}
+		}
+		else
+		{
+			for (uint8_t i = 0; i < WORD_BITS; i++)
+			{
+				tt[i] += __builtin_popcountll(tile[i]);
+			}
+		}
+	}
+
+	counters->n_lines = 0;
+}
+
+static word_t column_bits_generic(const word_t* const* la,
+								  const word_t* const* lb,
+								  const uint64_t attribute_word,
+								  const uint8_t attribute_bit,
+								  const uint64_t n_lines)
+{
+	word_t bits = 0;
+
+	for (uint64_t i = 0; i < n_lines; i++)
+	{
+		word_t lxor = la[i][attribute_word] ^ lb[i][attribute_word];
+		if (BIT_CHECK(lxor, attribute_bit))
+		{
+			BIT_SET(bits, WORD_BITS - 1 - i);
+		}
+	}
+
+	return bits;
+}
+
+const xor_kernels_t XOR_KERNELS_GENERIC
+	= { .name		 = "generic",
+		.max_lines	 = TILE_LINES,
+		.count_lines = count_lines_generic,
+		.flush		 = flush_generic,
+		.column_bits = column_bits_generic };
+
+void flush_vertical_counters(xor_counters_t* counters, const bool subtract,
+							 uint64_t* totals)
+{
+	for (uint64_t p = 0; p < N_COUNTER_PLANES; p++)
+	{
+		uint64_t weight = (uint64_t) 1 << p;
+
+		for (uint64_t t = 0; t < counters->n_words; t++)
+		{
+			word_t plane = counters->data[p * N_WORDS_PER_CYCLE + t];
+
+			uint64_t* tt = totals + t * WORD_BITS;
+
+			// Attribute i is on bit WORD_BITS - 1 - i
+			while (plane != 0)
+			{
+				uint8_t i = __builtin_clzll(plane);
+
+				if (subtract)
+				{
+					tt[i] -= weight;
+				}
+				else
+				{
+					tt[i] += weight;
+				}
+
+				BIT_CLEAR(plane, WORD_BITS - 1 - i);
+			}
+		}
+	}
+
+	memset(counters->data, 0,
+		   N_COUNTER_PLANES * N_WORDS_PER_CYCLE * sizeof(word_t));
+	counters->n_lines = 0;
+}
+
+void reset_xor_counters(xor_counters_t* counters, const uint64_t n_words)
+{
+	counters->n_words = n_words;
+	counters->n_lines = 0;
+	memset(counters->data, 0, sizeof(counters->data));
+}
+
+/**
+ * Can this CPU run these kernels?
+ */
+static bool cpu_supports_kernels(const xor_kernels_t* kernels)
+{
+#ifdef XOR_KERNELS_X86
+	__builtin_cpu_init();
+
+	if (kernels == &XOR_KERNELS_AVX512)
+	{
+		return __builtin_cpu_supports("avx512f");
+	}
+
+	if (kernels == &XOR_KERNELS_AVX2)
+	{
+		return __builtin_cpu_supports("avx2");
+	}
+#endif
+
+	return kernels == &XOR_KERNELS_GENERIC;
+}
+
+oknok_t select_xor_kernels(const char* name)
+{
+	/**
+	 * Available kernels, from best to worst
+	 */
+	const xor_kernels_t* available[] = {
+#ifdef XOR_KERNELS_X86
+		&XOR_KERNELS_AVX512, &XOR_KERNELS_AVX2,
+#endif
+		&XOR_KERNELS_GENERIC
+	};
+
+	uint64_t n_available = sizeof(available) / sizeof(available[0]);
+
+	for (uint64_t i = 0; i < n_available; i++)
+	{
+		if (name != NULL && strcmp(name, available[i]->name) != 0)
+		{
+			continue;
+		}
+
+		if (cpu_supports_kernels(available[i]))
+		{
+			selected_kernels = available[i];
+			return OK;
+		}
+
+		if (name != NULL)
+		{
+			fprintf(stderr, "This CPU does not support the %s kernels\n",
+					name);
+			return NOK;
+		}
+	}
+
+	fprintf(stderr, "Unknown kernels %s\n", name);
+	return NOK;
+}
+
+const xor_kernels_t* get_xor_kernels(void)
+{
+	return selected_kernels;
+}
@@ -0,0 +1,139 @@
+/*
+ ============================================================================
+ Name        : xor_kernels.h
+ Author      : Eduardo Ribeiro
+ Description : Kernels that XOR and count the lines of the disjoint matrix.
+			   The best kernels for the CPU are selected at startup.
+ ============================================================================
+ */
+
+#ifndef XOR_KERNELS_H
+#define XOR_KERNELS_H
+
+#include "set_cover.h"
+#include "types/oknok_t.h"
+#include "types/word_t.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Number of disjoint matrix lines sent to the kernels on each call.
+ * The generic kernels store them in a 64x64 bit tile, so this must match
+ * WORD_BITS
+ */
+#define TILE_LINES 64
+
+/**
+ * Number of vertical counters (bit planes) used by the SIMD kernels.
+ * Plane p has weight 2^p, so they can count up to 2^16 - 1 lines
+ */
+#define N_COUNTER_PLANES 16
+
+/**
+ * Do we have x86 SIMD kernels?
+ */
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define XOR_KERNELS_X86
+#endif
+
+/**
+ * Counters for the words of one cycle.
+ * The meaning of data depends on the kernels in use
+ */
+typedef struct xor_counters_t
+{
+	/**
+	 * Number of words in this cycle (max N_WORDS_PER_CYCLE)
+	 */
+	uint64_t n_words;
+
+	/**
+	 * Number of lines counted since the last flush
+	 */
+	uint64_t n_lines;
+
+	/**
+	 * Counters data
+	 */
+	word_t data[N_WORDS_PER_CYCLE * TILE_LINES];
+} xor_counters_t;
+
+typedef struct xor_kernels_t
+{
+	/**
+	 * Kernels name
+	 */
+	const char* name;
+
+	/**
+	 * Maximum number of lines the counters can hold before a flush
+	 */
+	uint64_t max_lines;
+
+	/**
+	 * Counts the bits set in la[i] ^ lb[i], for i < n_lines (max
+	 * TILE_LINES), on counters->n_words words starting at word cw
+	 */
+	void (*count_lines)(xor_counters_t* counters, const word_t* const* la,
+						const word_t* const* lb, const uint64_t cw,
+						const uint64_t n_lines);
+
+	/**
+	 * Adds (or subtracts) the counters to totals and resets them
+	 */
+	void (*flush)(xor_counters_t* counters, const bool subtract,
+				  uint64_t* totals);
+
+	/**
+	 * Returns a word where bit WORD_BITS - 1 - i is bit attribute_bit of
+	 * la[i][attribute_word] ^ lb[i][attribute_word], for i < n_lines (max
+	 * TILE_LINES)
+	 */
+	word_t (*column_bits)(const word_t* const* la, const word_t* const* lb,
+						  const uint64_t attribute_word,
+						  const uint8_t attribute_bit, const uint64_t n_lines);
+} xor_kernels_t;
+
+/**
+ * Generic C kernels: transposes tiles of lines and counts columns with
+ * popcount
+ */
+extern const xor_kernels_t XOR_KERNELS_GENERIC;
+
+#ifdef XOR_KERNELS_X86
+/**
+ * AVX2 kernels: Harley-Seal carry-save adders over 256 bit vectors
+ */
+extern const xor_kernels_t XOR_KERNELS_AVX2;
+
+/**
+ * AVX-512 kernels: Harley-Seal carry-save adders over 512 bit vectors
+ */
+extern const xor_kernels_t XOR_KERNELS_AVX512;
+#endif
+
+/**
+ * Selects the kernels by name. If name is NULL selects the best kernels
+ * available for this CPU
+ */
+oknok_t select_xor_kernels(const char* name);
+
+/**
+ * Returns the selected kernels
+ */
+const xor_kernels_t* get_xor_kernels(void);
+
+/**
+ * Resets the counters for a new cycle with n_words
+ */
+void reset_xor_counters(xor_counters_t* counters, const uint64_t n_words);
+
+/**
+ * Adds (or subtracts) the vertical counters to totals and resets them.
+ * Used by the SIMD kernels
+ */
+void flush_vertical_counters(xor_counters_t* counters, const bool subtract,
+							 uint64_t* totals);
+
+#endif // XOR_KERNELS_H
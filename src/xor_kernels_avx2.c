@@ -0,0 +1,209 @@
+/*
+ ============================================================================
+ Name        : xor_kernels_avx2.c
+ Author      : Eduardo Ribeiro
+ Description : AVX2 kernels that XOR and count the lines of the disjoint
+			   matrix
+ ============================================================================
+ */
+
+#include "xor_kernels.h"
+
+#include "set_cover.h"
+#include "types/word_t.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef XOR_KERNELS_X86
+
+#include <immintrin.h>
+
+/**
+ * Number of words in one vector
+ */
+#define AVX2_WORDS 4
+
+/**
+ * Carry-save adder: h:l = a + b + c
+ */
+#define CSA_AVX2(h, l, a, b, c)                                                \
+	{                                                                          \
+		__m256i a_ = (a);                                                      \
+		__m256i b_ = (b);                                                      \
+		__m256i c_ = (c);                                                      \
+		__m256i u_ = _mm256_xor_si256(a_, b_);                                 \
+		(h)		   = _mm256_or_si256(_mm256_and_si256(a_, b_),                 \
+									 _mm256_and_si256(u_, c_));                \
+		(l)		   = _mm256_xor_si256(u_, c_);                                 \
+	}
+
+/**
+ * Reversed nibbles, so lane 0 of a movemask goes to the highest bit
+ */
+static const uint8_t REVERSED_NIBBLE[16]
+	= { 0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE,
+		0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF };
+
+/**
+ * Loads la[i] ^ lb[i] for the words of vector v, or zero if there's no line i
+ */
+__attribute__((target("avx2"))) static inline __m256i
+load_xor_avx2(const word_t* const* la, const word_t* const* lb,
+			  const uint64_t i, const uint64_t n_lines, const uint64_t w,
+			  const bool full, const __m256i mask)
+{
+	if (i >= n_lines)
+	{
+		return _mm256_setzero_si256();
+	}
+
+	if (full)
+	{
+		return _mm256_xor_si256(
+			_mm256_loadu_si256((const __m256i*) (la[i] + w)),
+			_mm256_loadu_si256((const __m256i*) (lb[i] + w)));
+	}
+
+	return _mm256_xor_si256(
+		_mm256_maskload_epi64((const long long*) (la[i] + w), mask),
+		_mm256_maskload_epi64((const long long*) (lb[i] + w), mask));
+}
+
+/**
+ * Counts the lines with a Harley-Seal carry-save adder tree, 16 lines at a
+ * time. Planes 0 to 3 store the ones, twos, fours and eights, and the
+ * sixteens are added to the remaining planes.
+ */
+__attribute__((target("avx2"))) static void
+count_lines_avx2(xor_counters_t* counters, const word_t* const* la,
+				 const word_t* const* lb, const uint64_t cw,
+				 const uint64_t n_lines)
+{
+	word_t* data = counters->data;
+
+	for (uint64_t v = 0; v < counters->n_words; v += AVX2_WORDS)
+	{
+		// Words of this vector that belong to the cycle
+		uint64_t n_words = counters->n_words - v;
+		bool full		 = n_words >= AVX2_WORDS;
+
+		__m256i mask = _mm256_cmpgt_epi64(_mm256_set1_epi64x(n_words),
+										  _mm256_set_epi64x(3, 2, 1, 0));
+
+		uint64_t w = cw + v;
+
+		__m256i ones
+			= _mm256_loadu_si256((const __m256i*) (data + v));
+		__m256i twos = _mm256_loadu_si256(
+			(const __m256i*) (data + N_WORDS_PER_CYCLE + v));
+		__m256i fours = _mm256_loadu_si256(
+			(const __m256i*) (data + 2 * N_WORDS_PER_CYCLE + v));
+		__m256i eights = _mm256_loadu_si256(
+			(const __m256i*) (data + 3 * N_WORDS_PER_CYCLE + v));
+
+		__m256i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+		__m256i sixteens;
+
+		for (uint64_t i = 0; i < n_lines; i += 16)
+		{
+#define LX(k) load_xor_avx2(la, lb, i + (k), n_lines, w, full, mask)
+			CSA_AVX2(twos_a, ones, ones, LX(0), LX(1));
+			CSA_AVX2(twos_b, ones, ones, LX(2), LX(3));
+			CSA_AVX2(fours_a, twos, twos, twos_a, twos_b);
+			CSA_AVX2(twos_a, ones, ones, LX(4), LX(5));
+			CSA_AVX2(twos_b, ones, ones, LX(6), LX(7));
+			CSA_AVX2(fours_b, twos, twos, twos_a, twos_b);
+			CSA_AVX2(eights_a, fours, fours, fours_a, fours_b);
+			CSA_AVX2(twos_a, ones, ones, LX(8), LX(9));
+			CSA_AVX2(twos_b, ones, ones, LX(10), LX(11));
+			CSA_AVX2(fours_a, twos, twos, twos_a, twos_b);
+			CSA_AVX2(twos_a, ones, ones, LX(12), LX(13));
+			CSA_AVX2(twos_b, ones, ones, LX(14), LX(15));
+			CSA_AVX2(fours_b, twos, twos, twos_a, twos_b);
+			CSA_AVX2(eights_b, fours, fours, fours_a, fours_b);
+			CSA_AVX2(sixteens, eights, eights, eights_a, eights_b);
+#undef LX
+
+			// Ripple the sixteens through the remaining planes
+			for (uint64_t p = 4; p < N_COUNTER_PLANES; p++)
+			{
+				if (_mm256_testz_si256(sixteens, sixteens))
+				{
+					break;
+				}
+
+				__m256i* plane = (__m256i*) (data + p * N_WORDS_PER_CYCLE + v);
+
+				__m256i c = _mm256_loadu_si256(plane);
+				_mm256_storeu_si256(plane, _mm256_xor_si256(c, sixteens));
+				sixteens = _mm256_and_si256(c, sixteens);
+			}
+		}
+
+		_mm256_storeu_si256((__m256i*) (data + v), ones);
+		_mm256_storeu_si256((__m256i*) (data + N_WORDS_PER_CYCLE + v), twos);
+		_mm256_storeu_si256((__m256i*) (data + 2 * N_WORDS_PER_CYCLE + v),
+							fours);
+		_mm256_storeu_si256((__m256i*) (data + 3 * N_WORDS_PER_CYCLE + v),
+							eights);
+	}
+
+	counters->n_lines += n_lines;
+}
+
+/**
+ * Gathers the attribute word from 4 lines at a time and moves the attribute
+ * bit to the sign bit, so movemask extracts the column bits
+ */
+__attribute__((target("avx2"))) static word_t
+column_bits_avx2(const word_t* const* la, const word_t* const* lb,
+				 const uint64_t attribute_word, const uint8_t attribute_bit,
+				 const uint64_t n_lines)
+{
+	word_t bits = 0;
+
+	__m128i shift = _mm_cvtsi32_si128(WORD_BITS - 1 - attribute_bit);
+
+	uint64_t i = 0;
+
+	for (; i + AVX2_WORDS <= n_lines; i += AVX2_WORDS)
+	{
+		// Gather with byte offsets relative to the first line of each group
+		const long long* base_a = (const long long*) (la[i] + attribute_word);
+		const long long* base_b = (const long long*) (lb[i] + attribute_word);
+
+		__m256i offsets_a
+			= _mm256_sub_epi64(_mm256_loadu_si256((const __m256i*) (la + i)),
+							   _mm256_set1_epi64x((long long) la[i]));
+		__m256i offsets_b
+			= _mm256_sub_epi64(_mm256_loadu_si256((const __m256i*) (lb + i)),
+							   _mm256_set1_epi64x((long long) lb[i]));
+
+		__m256i lxor
+			= _mm256_xor_si256(_mm256_i64gather_epi64(base_a, offsets_a, 1),
+							   _mm256_i64gather_epi64(base_b, offsets_b, 1));
+
+		int m = _mm256_movemask_pd(
+			_mm256_castsi256_pd(_mm256_sll_epi64(lxor, shift)));
+
+		bits |= (word_t) REVERSED_NIBBLE[m] << (WORD_BITS - AVX2_WORDS - i);
+	}
+
+	for (; i < n_lines; i++)
+	{
+		word_t lxor = la[i][attribute_word] ^ lb[i][attribute_word];
+		bits |= ((lxor >> attribute_bit) & 1) << (WORD_BITS - 1 - i);
+	}
+
+	return bits;
+}
+
+const xor_kernels_t XOR_KERNELS_AVX2
+	= { .name		 = "avx2",
+		.max_lines	 = ((uint64_t) 1 << N_COUNTER_PLANES) - 1,
+		.count_lines = count_lines_avx2,
+		.flush		 = flush_vertical_counters,
+		.column_bits = column_bits_avx2 };
+
+#endif // XOR_KERNELS_X86
@@ -0,0 +1,188 @@
+/*
+ ============================================================================
+ Name        : xor_kernels_avx512.c
+ Author      : Eduardo Ribeiro
+ Description : AVX-512 kernels that XOR and count the lines of the disjoint
+			   matrix
+ ============================================================================
+ */
+
+#include "xor_kernels.h"
+
+#include "set_cover.h"
+#include "types/word_t.h"
+
+#include <stdint.h>
+
+#ifdef XOR_KERNELS_X86
+
+#include <immintrin.h>
+
+/**
+ * Number of words in one vector
+ */
+#define AVX512_WORDS 8
+
+/**
+ * Carry-save adder: h:l = a + b + c
+ * 0xE8 is the majority function and 0x96 is a ^ b ^ c
+ */
+#define CSA_AVX512(h, l, a, b, c)                                              \
+	{                                                                          \
+		__m512i a_ = (a);                                                      \
+		__m512i b_ = (b);                                                      \
+		__m512i c_ = (c);                                                      \
+		(h)		   = _mm512_ternarylogic_epi64(a_, b_, c_, 0xE8);              \
+		(l)		   = _mm512_ternarylogic_epi64(a_, b_, c_, 0x96);              \
+	}
+
+/**
+ * Reverses the bits of a byte, so lane 0 of a mask goes to the highest bit
+ */
+static inline uint8_t reverse_byte(uint8_t b)
+{
+	b = (uint8_t) ((b & 0xF0) >> 4 | (b & 0x0F) << 4);
+	b = (uint8_t) ((b & 0xCC) >> 2 | (b & 0x33) << 2);
+	b = (uint8_t) ((b & 0xAA) >> 1 | (b & 0x55) << 1);
+	return b;
+}
+
+/**
+ * Loads la[i] ^ lb[i] for the words of the cycle, or zero if there's no
+ * line i. Words past the end of the cycle are not read
+ */
+__attribute__((target("avx512f"))) static inline __m512i
+load_xor_avx512(const word_t* const* la, const word_t* const* lb,
+				const uint64_t i, const uint64_t n_lines, const uint64_t w,
+				const __mmask8 mask)
+{
+	if (i >= n_lines)
+	{
+		return _mm512_setzero_si512();
+	}
+
+	return _mm512_xor_si512(_mm512_maskz_loadu_epi64(mask, la[i] + w),
+							_mm512_maskz_loadu_epi64(mask, lb[i] + w));
+}
+
+/**
+ * Counts the lines with a Harley-Seal carry-save adder tree, 16 lines at a
+ * time. Planes 0 to 3 store the ones, twos, fours and eights, and the
+ * sixteens are added to the remaining planes.
+ * One vector holds all the words of a cycle.
+ */
+__attribute__((target("avx512f"))) static void
+count_lines_avx512(xor_counters_t* counters, const word_t* const* la,
+				   const word_t* const* lb, const uint64_t cw,
+				   const uint64_t n_lines)
+{
+	word_t* data = counters->data;
+
+	__mmask8 mask = (__mmask8) ((1U << counters->n_words) - 1);
+
+	__m512i ones   = _mm512_loadu_si512(data);
+	__m512i twos   = _mm512_loadu_si512(data + N_WORDS_PER_CYCLE);
+	__m512i fours  = _mm512_loadu_si512(data + 2 * N_WORDS_PER_CYCLE);
+	__m512i eights = _mm512_loadu_si512(data + 3 * N_WORDS_PER_CYCLE);
+
+	__m512i twos_a, twos_b, fours_a, fours_b, eights_a, eights_b;
+	__m512i sixteens;
+
+	for (uint64_t i = 0; i < n_lines; i += 16)
+	{
+#define LX(k) load_xor_avx512(la, lb, i + (k), n_lines, cw, mask)
+		CSA_AVX512(twos_a, ones, ones, LX(0), LX(1));
+		CSA_AVX512(twos_b, ones, ones, LX(2), LX(3));
+		CSA_AVX512(fours_a, twos, twos, twos_a, twos_b);
+		CSA_AVX512(twos_a, ones, ones, LX(4), LX(5));
+		CSA_AVX512(twos_b, ones, ones, LX(6), LX(7));
+		CSA_AVX512(fours_b, twos, twos, twos_a, twos_b);
+		CSA_AVX512(eights_a, fours, fours, fours_a, fours_b);
+		CSA_AVX512(twos_a, ones, ones, LX(8), LX(9));
+		CSA_AVX512(twos_b, ones, ones, LX(10), LX(11));
+		CSA_AVX512(fours_a, twos, twos, twos_a, twos_b);
+		CSA_AVX512(twos_a, ones, ones, LX(12), LX(13));
+		CSA_AVX512(twos_b, ones, ones, LX(14), LX(15));
+		CSA_AVX512(fours_b, twos, twos, twos_a, twos_b);
+		CSA_AVX512(eights_b, fours, fours, fours_a, fours_b);
+		CSA_AVX512(sixteens, eights, eights, eights_a, eights_b);
+#undef LX
+
+		// Ripple the sixteens through the remaining planes
+		for (uint64_t p = 4; p < N_COUNTER_PLANES; p++)
+		{
+			if (_mm512_test_epi64_mask(sixteens, sixteens) == 0)
+			{
+				break;
+			}
+
+			word_t* plane = data + p * N_WORDS_PER_CYCLE;
+
+			__m512i c = _mm512_loadu_si512(plane);
+			_mm512_storeu_si512(plane, _mm512_xor_si512(c, sixteens));
+			sixteens = _mm512_and_si512(c, sixteens);
+		}
+	}
+
+	_mm512_storeu_si512(data, ones);
+	_mm512_storeu_si512(data + N_WORDS_PER_CYCLE, twos);
+	_mm512_storeu_si512(data + 2 * N_WORDS_PER_CYCLE, fours);
+	_mm512_storeu_si512(data + 3 * N_WORDS_PER_CYCLE, eights);
+
+	counters->n_lines += n_lines;
+}
+
+/**
+ * Gathers the attribute word from 8 lines at a time and tests the attribute
+ * bit to build the column bits mask
+ */
+__attribute__((target("avx512f"))) static word_t
+column_bits_avx512(const word_t* const* la, const word_t* const* lb,
+				   const uint64_t attribute_word, const uint8_t attribute_bit,
+				   const uint64_t n_lines)
+{
+	word_t bits = 0;
+
+	__m512i bit = _mm512_set1_epi64((long long) ((word_t) 1 << attribute_bit));
+
+	uint64_t i = 0;
+
+	for (; i + AVX512_WORDS <= n_lines; i += AVX512_WORDS)
+	{
+		// Gather with byte offsets relative to the first line of each group
+		const long long* base_a = (const long long*) (la[i] + attribute_word);
+		const long long* base_b = (const long long*) (lb[i] + attribute_word);
+
+		__m512i offsets_a
+			= _mm512_sub_epi64(_mm512_loadu_si512(la + i),
+							   _mm512_set1_epi64((long long) la[i]));
+		__m512i offsets_b
+			= _mm512_sub_epi64(_mm512_loadu_si512(lb + i),
+							   _mm512_set1_epi64((long long) lb[i]));
+
+		__m512i lxor
+			= _mm512_xor_si512(_mm512_i64gather_epi64(offsets_a, base_a, 1),
+							   _mm512_i64gather_epi64(offsets_b, base_b, 1));
+
+		__mmask8 m = _mm512_test_epi64_mask(lxor, bit);
+
+		bits |= (word_t) reverse_byte(m) << (WORD_BITS - AVX512_WORDS - i);
+	}
+
+	for (; i < n_lines; i++)
+	{
+		word_t lxor = la[i][attribute_word] ^ lb[i][attribute_word];
+		bits |= ((lxor >> attribute_bit) & 1) << (WORD_BITS - 1 - i);
+	}
+
+	return bits;
+}
+
+const xor_kernels_t XOR_KERNELS_AVX512
+	= { .name		 = "avx512",
+		.max_lines	 = ((uint64_t) 1 << N_COUNTER_PLANES) - 1,
+		.count_lines = count_lines_avx512,
+		.flush		 = flush_vertical_counters,
+		.column_bits = column_bits_avx512 };
+
+#endif // XOR_KERNELS_X86
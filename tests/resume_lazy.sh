@@ -0,0 +1,65 @@
+#!/bin/bash
+
+# Resumes a --lazy run from a checkpoint with part of the solution and checks
+# that the rounds after the checkpoint select the same attributes, covering
+# the same lines, as the run that wrote it
+#
+# usage: resume_lazy.sh laid-by-lines generate-dataset
+# MPIEXEC sets the command that starts the processes (default: mpiexec)
+
+LAID=$1
+GENERATE=$2
+MPIEXEC=${MPIEXEC:-mpiexec}
+
+if [ ! -x "$LAID" ] || [ ! -x "$GENERATE" ]; then
+	echo "Usage: $0 laid-by-lines generate-dataset"
+	exit 1
+fi
+
+WORK_DIR=$(mktemp -d)
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+DATASET_FILE="$WORK_DIR/dataset.h5"
+CHECKPOINT_FILE="$WORK_DIR/checkpoint.h5"
+
+# 15 attributes are selected, the checkpoint keeps the first 12
+"$GENERATE" -f="$DATASET_FILE" --attributes=300 --observations=600 --seed=3 \
+	>/dev/null || exit 1
+
+# The selected attributes, without the times
+selected() {
+	grep "Selected attribute" | sed 's/ \[.*//'
+}
+
+FAILED=0
+
+for N_PROCESSES in 1 2; do
+	# With and without the cached columns
+	for OPTIONS in "" "--max-dm-memory=1000"; do
+		rm -f "$CHECKPOINT_FILE"
+
+		FULL_RUN=$($MPIEXEC -np $N_PROCESSES "$LAID" -f "$DATASET_FILE" \
+			-d dados --lazy --checkpoint="$CHECKPOINT_FILE" \
+			--checkpoint-rounds=4 $OPTIONS | selected)
+
+		RESUMED_RUN=$($MPIEXEC -np $N_PROCESSES "$LAID" -f "$DATASET_FILE" \
+			-d dados --lazy --checkpoint="$CHECKPOINT_FILE" --resume \
+			$OPTIONS | selected)
+
+		if [ -z "$RESUMED_RUN" ] \
+			|| [ "$RESUMED_RUN" != "$(echo "$FULL_RUN" | tail -n 3)" ]; then
+			echo "FAILED with $N_PROCESSES process(es) $OPTIONS"
+			echo "Expected:"
+			echo "$FULL_RUN" | tail -n 3
+			echo "Resumed:"
+			echo "$RESUMED_RUN"
+			FAILED=1
+		fi
+	done
+done
+
+if [ $FAILED -eq 0 ]; then
+	echo "Resuming --lazy runs: OK"
+fi
+
+exit $FAILED